@@ -0,0 +1,156 @@
+#include "Allocator.h"
+#include <string.h>
+
+namespace cz
+{
+
+//////////////////////////////////////////////////////////////////////////
+// ArenaAllocator
+//////////////////////////////////////////////////////////////////////////
+
+ArenaAllocator::ArenaAllocator(void* buffer, size_t size)
+	: m_data(static_cast<uint8_t*>(buffer))
+	, m_capacity(size)
+{
+	CZ_ASSERT((reinterpret_cast<uintptr_t>(buffer) & (ALLOCATOR_ALIGNMENT - 1)) == 0);
+}
+
+void* ArenaAllocator::allocate(size_t size)
+{
+	size_t start = (m_used + ALLOCATOR_ALIGNMENT - 1) & ~(ALLOCATOR_ALIGNMENT - 1);
+	if (start > m_capacity || size > m_capacity - start)
+	{
+		return nullptr;
+	}
+
+	m_last = start;
+	m_used = start + size;
+	if (m_used > m_peak)
+	{
+		m_peak = m_used;
+	}
+	return m_data + start;
+}
+
+void ArenaAllocator::deallocate(void* ptr, size_t size)
+{
+	if (ptr == m_data + m_last && m_last + size == m_used)
+	{
+		m_used = m_last;
+	}
+}
+
+void* ArenaAllocator::reallocate(void* ptr, size_t oldSize, size_t newSize)
+{
+	if (ptr == m_data + m_last && m_last + oldSize == m_used)
+	{
+		if (newSize > m_capacity - m_last)
+		{
+			return nullptr;
+		}
+
+		m_used = m_last + newSize;
+		if (m_used > m_peak)
+		{
+			m_peak = m_used;
+		}
+		return ptr;
+	}
+
+	void* newPtr = allocate(newSize);
+	if (newPtr)
+	{
+		memcpy(newPtr, ptr, oldSize < newSize ? oldSize : newSize);
+	}
+	return newPtr;
+}
+
+void ArenaAllocator::reset()
+{
+	m_used = 0;
+	m_last = 0;
+}
+
+size_t ArenaAllocator::used() const
+{
+	return m_used;
+}
+
+size_t ArenaAllocator::capacity() const
+{
+	return m_capacity;
+}
+
+size_t ArenaAllocator::peak() const
+{
+	return m_peak;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// PoolAllocator
+//////////////////////////////////////////////////////////////////////////
+
+PoolAllocator::PoolAllocator(void* buffer, size_t blockSize, int numBlocks)
+	: m_data(static_cast<uint8_t*>(buffer))
+	, m_blockSize(calcBlockSize(blockSize))
+	, m_numBlocks(numBlocks)
+{
+	CZ_ASSERT((reinterpret_cast<uintptr_t>(buffer) & (ALLOCATOR_ALIGNMENT - 1)) == 0);
+
+	// Build the free list, so the first allocation returns the first block
+	for (int i = numBlocks - 1; i >= 0; i--)
+	{
+		FreeBlock* block = reinterpret_cast<FreeBlock*>(m_data + m_blockSize * i);
+		block->next = m_free;
+		m_free = block;
+	}
+}
+
+void* PoolAllocator::allocate(size_t size)
+{
+	if (size > m_blockSize || !m_free)
+	{
+		return nullptr;
+	}
+
+	FreeBlock* block = m_free;
+	m_free = block->next;
+	m_used++;
+	return block;
+}
+
+void PoolAllocator::deallocate(void* ptr, size_t /*size*/)
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	CZ_ASSERT(ptr >= m_data && ptr < m_data + m_blockSize * m_numBlocks);
+	FreeBlock* block = static_cast<FreeBlock*>(ptr);
+	block->next = m_free;
+	m_free = block;
+	m_used--;
+}
+
+void* PoolAllocator::reallocate(void* ptr, size_t /*oldSize*/, size_t newSize)
+{
+	return newSize <= m_blockSize ? ptr : nullptr;
+}
+
+size_t PoolAllocator::blockSize() const
+{
+	return m_blockSize;
+}
+
+int PoolAllocator::used() const
+{
+	return m_used;
+}
+
+int PoolAllocator::capacity() const
+{
+	return m_numBlocks;
+}
+
+} // namespace cz
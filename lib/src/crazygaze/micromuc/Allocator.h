@@ -0,0 +1,257 @@
+#pragma once
+
+#include "crazygaze/micromuc/czmicromuc.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace cz
+{
+
+/**
+ * Allocators used by the containers (e.g: TArray).
+ *
+ * An allocator is any type with the following methods:
+ *	void* allocate(size_t size);
+ *	void deallocate(void* ptr, size_t size);
+ *	void* reallocate(void* ptr, size_t oldSize, size_t newSize);
+ *
+ * allocate returns nullptr if it can't satisfy the request. deallocate gets the same size that was passed to allocate.
+ * reallocate resizes a block, keeping its contents (in place if possible). If it fails, it returns nullptr and the
+ * original block is left untouched.
+ * Containers keep a copy of the allocator, so stateful allocators (arenas, pools) are used through a TAllocatorRef.
+ */
+
+/**
+ * Alignment of all memory returned by the allocators
+ */
+constexpr size_t ALLOCATOR_ALIGNMENT = alignof(max_align_t);
+
+/**
+ * Default allocator. Just uses malloc/free.
+ */
+struct MallocAllocator
+{
+	void* allocate(size_t size)
+	{
+		return malloc(size);
+	}
+
+	void deallocate(void* ptr, size_t /*size*/)
+	{
+		free(ptr);
+	}
+
+	void* reallocate(void* ptr, size_t /*oldSize*/, size_t newSize)
+	{
+		return realloc(ptr, newSize);
+	}
+};
+
+/**
+ * Lets a container use an allocator it doesn't own.
+ * The allocator needs to outlive the container.
+ */
+template<typename A>
+class TAllocatorRef
+{
+public:
+	TAllocatorRef(A& allocator) : m_allocator(&allocator)
+	{
+	}
+
+	void* allocate(size_t size)
+	{
+		return m_allocator->allocate(size);
+	}
+
+	void deallocate(void* ptr, size_t size)
+	{
+		m_allocator->deallocate(ptr, size);
+	}
+
+	void* reallocate(void* ptr, size_t oldSize, size_t newSize)
+	{
+		return m_allocator->reallocate(ptr, oldSize, newSize);
+	}
+
+	A& get() const
+	{
+		return *m_allocator;
+	}
+
+private:
+	A* m_allocator;
+};
+
+/**
+ * Bump allocator over a user specified buffer.
+ *
+ * Allocation is just a pointer increment, and all the memory is released at once with reset(), which is O(1).
+ * deallocate only gives back memory if it was the last allocation, so this is meant for short lived data (e.g: arrays
+ * used while processing a frame, after which the arena is reset).
+ */
+class ArenaAllocator
+{
+public:
+
+	/**
+	 * @param buffer Memory to allocate from. Should be aligned to ALLOCATOR_ALIGNMENT
+	 * @param size Buffer size in bytes
+	 */
+	ArenaAllocator(void* buffer, size_t size);
+
+	ArenaAllocator(const ArenaAllocator&) = delete;
+	ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+
+	/**
+	 * Allocates memory, aligned to ALLOCATOR_ALIGNMENT
+	 * @return The allocated memory, or nullptr if there is not enough space left
+	 */
+	void* allocate(size_t size);
+
+	/**
+	 * Releases memory if it was the last allocation. Otherwise does nothing, and the memory is only released by reset()
+	 */
+	void deallocate(void* ptr, size_t size);
+
+	/**
+	 * Resizes an allocation. If it's the last allocation, it's done in place, otherwise a new block is allocated.
+	 */
+	void* reallocate(void* ptr, size_t oldSize, size_t newSize);
+
+	/**
+	 * Releases all the allocations
+	 * Any container still using memory from this arena is left with dangling pointers, so should not be used after
+	 * this, not even destroyed.
+	 */
+	void reset();
+
+	/**
+	 * How many bytes are in use
+	 */
+	size_t used() const;
+
+	/**
+	 * Total size in bytes
+	 */
+	size_t capacity() const;
+
+	/**
+	 * Highest value used() had since construction
+	 */
+	size_t peak() const;
+
+private:
+	uint8_t* m_data;
+	size_t m_capacity;
+	size_t m_used = 0;
+	size_t m_last = 0; // offset of the last allocation
+	size_t m_peak = 0;
+};
+
+/**
+ * ArenaAllocator that owns its buffer
+ */
+template<size_t SIZE>
+class TStaticArenaAllocator : public ArenaAllocator
+{
+public:
+	TStaticArenaAllocator() : ArenaAllocator(m_buffer, SIZE)
+	{
+	}
+
+private:
+	alignas(ALLOCATOR_ALIGNMENT) uint8_t m_buffer[SIZE];
+};
+
+/**
+ * Allocates fixed size blocks from a user specified buffer.
+ *
+ * Allocation and deallocation are O(1) and never fragment, since all blocks have the same size.
+ * Any request bigger than the block size fails.
+ */
+class PoolAllocator
+{
+public:
+
+	/**
+	 * Calculates the real size of the blocks, taking into account alignment
+	 */
+	static constexpr size_t calcBlockSize(size_t blockSize)
+	{
+		size_t size = blockSize < sizeof(void*) ? sizeof(void*) : blockSize;
+		return (size + ALLOCATOR_ALIGNMENT - 1) & ~(ALLOCATOR_ALIGNMENT - 1);
+	}
+
+	/**
+	 * @param buffer Memory to allocate from. Should be aligned to ALLOCATOR_ALIGNMENT, and have at least
+	 * calcBlockSize(blockSize)*numBlocks bytes
+	 * @param blockSize Size of each block
+	 * @param numBlocks Number of blocks
+	 */
+	PoolAllocator(void* buffer, size_t blockSize, int numBlocks);
+
+	PoolAllocator(const PoolAllocator&) = delete;
+	PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+	/**
+	 * Allocates a block
+	 * @return A block, or nullptr if size is bigger than the block size, or there are no free blocks
+	 */
+	void* allocate(size_t size);
+
+	/**
+	 * Puts the block back in the pool
+	 */
+	void deallocate(void* ptr, size_t size);
+
+	/**
+	 * Since all blocks have the same size, this just checks if the new size still fits in the block
+	 */
+	void* reallocate(void* ptr, size_t oldSize, size_t newSize);
+
+	/**
+	 * Size of each block
+	 */
+	size_t blockSize() const;
+
+	/**
+	 * Number of blocks in use
+	 */
+	int used() const;
+
+	/**
+	 * Total number of blocks
+	 */
+	int capacity() const;
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	uint8_t* m_data;
+	size_t m_blockSize;
+	int m_numBlocks;
+	int m_used = 0;
+	FreeBlock* m_free = nullptr;
+};
+
+/**
+ * PoolAllocator that owns its buffer
+ */
+template<size_t BLOCK_SIZE, int NUM_BLOCKS>
+class TStaticPoolAllocator : public PoolAllocator
+{
+public:
+	TStaticPoolAllocator() : PoolAllocator(m_buffer, BLOCK_SIZE, NUM_BLOCKS)
+	{
+	}
+
+private:
+	alignas(ALLOCATOR_ALIGNMENT) uint8_t m_buffer[calcBlockSize(BLOCK_SIZE) * NUM_BLOCKS];
+};
+
+} // namespace cz
@@ -15,7 +15,10 @@
 #pragma once
 
 #include "crazygaze/micromuc/czmicromuc.h"
+#include "crazygaze/micromuc/Allocator.h"
+#include "crazygaze/micromuc/Simd.h"
 #include <utility>
+#include <type_traits>
 #include <string.h>
 #include <stdlib.h>
 #ifdef __AVR__
@@ -25,6 +28,16 @@
 namespace cz
 {
 
+	/*!
+		Tells if objects of a type can be moved to another memory location with a memcpy, instead of move constructing
+		and destroying them.
+		This is true for trivially copyable types, and can be specialized for other types that don't point to themselves.
+	*/
+	template<typename T>
+	struct TIsTriviallyRelocatable : std::is_trivially_copyable<T>
+	{
+	};
+
 	/*!
 		Creates/destroys array elements
 	*/
@@ -38,46 +51,29 @@ namespace cz
 
 		static void constructCopy(void* at, const Type& val, int count)
 		{
-			while(count--)
+			if constexpr (simd::TIsSupported<Type>::value)
 			{
-				new(at) Type(val);
-				at = reinterpret_cast<Type*>(at)+1;
+				simd::fill(reinterpret_cast<Type*>(at), val, count);
+			}
+			else
+			{
+				while(count--)
+				{
+					new(at) Type(val);
+					at = reinterpret_cast<Type*>(at)+1;
+				}
 			}
 		}
 
-		static void construct(void* at)
-		{
-			new(at) Type();
-		}
-
-		template<typename A1>
-		static void construct(void* at, A1 a1)
-		{
-			new(at) Type(std::forward<A1>(a1));
-		}
-
-		template<typename A1, typename A2>
-		static void construct(void* at, A1 a1, A2 a2)
-		{
-			new(at) Type(std::forward<A1>(a1), std::forward<A2>(a2));
-		}
-
-		template<typename A1, typename A2, typename A3>
-		static void construct(void* at, A1 a1, A2 a2, A3 a3)
-		{
-			new(at) Type(std::forward<A1>(a1), std::forward<A2>(a2), std::forward<A3>(a3));
-		}
-
-		template<typename A1, typename A2, typename A3, typename A4>
-		static void construct(void* at, A1 a1, A2 a2, A3 a3, A4 a4)
+		static void constructMove(void* at, Type&& val)
 		{
-			new(at) Type(std::forward<A1>(a1), std::forward<A2>(a2), std::forward<A3>(a3), std::forward<A4>(a4));
+			new(at) Type(std::move(val));
 		}
 
-		template<typename A1, typename A2, typename A3, typename A4, typename A5>
-		static void construct(void* at, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5)
+		template<typename... Args>
+		static void construct(void* at, Args&&... args)
 		{
-			new(at) Type(std::forward<A1>(a1), std::forward<A2>(a2), std::forward<A3>(a3), std::forward<A4>(a4), std::forward<A5>(a5));
+			new(at) Type(std::forward<Args>(args)...);
 		}
 
 		static void construct_multiple(void* at, int count)
@@ -113,6 +109,49 @@ namespace cz
 #endif
 		}
 
+		/*!
+		* Moves count elements from src to the uninitialized memory at dst. The source elements are destroyed.
+		* Trivially relocatable types are simply memmove'd. Other types are move constructed if their move constructor
+		* doesn't throw, or copy constructed otherwise.
+		* The ranges can overlap.
+		*/
+		static void relocate(void* dst, Type* src, int count)
+		{
+			if (count <= 0 || dst == src)
+			{
+				return;
+			}
+
+			if constexpr (TIsTriviallyRelocatable<Type>::value)
+			{
+				memmove(dst, src, sizeof(Type)*count);
+			}
+			else if (reinterpret_cast<Type*>(dst) < src)
+			{
+				Type* d = reinterpret_cast<Type*>(dst);
+				while(count--)
+				{
+					new(d) Type(std::move_if_noexcept(*src));
+					destroy(src);
+					d++;
+					src++;
+				}
+			}
+			else
+			{
+				// Moving forward, so go backwards in case the ranges overlap
+				Type* d = reinterpret_cast<Type*>(dst) + count;
+				src += count;
+				while(count--)
+				{
+					d--;
+					src--;
+					new(d) Type(std::move_if_noexcept(*src));
+					destroy(src);
+				}
+			}
+		}
+
 	};
 
 
@@ -138,18 +177,14 @@ namespace cz
 		{
 			CZ_ASSERT(start<=end);
 
-			const Type *p = start;
-			while(p<end)
+			const Type* p = simd::find(start, end, val);
+			if (p==end)
 			{
-				if (*p==val)
-				{
-					index = static_cast<int>(p - start);
-					return true;
-				}
-				p++;
+				return false;
 			}
 
-			return false;
+			index = static_cast<int>(p - start);
+			return true;
 		}
 
 		/*! Finds an element inside the specified range
@@ -157,18 +192,15 @@ namespace cz
 		static bool _find(const Type* start, const Type* end, const Type &val)
 		{
 			CZ_ASSERT(start<=end);
+			return simd::find(start, end, val)!=end;
+		}
 
-			const Type *p = start;
-			while(p<end)
-			{
-				if (*p==val)
-				{
-					return true;
-				}
-				p++;
-			}
-
-			return false;
+		/*! Counts how many elements inside the specified range are equal to val
+		*/
+		static int _count(const Type* start, const Type* end, const Type &val)
+		{
+			CZ_ASSERT(start<=end);
+			return simd::count(start, end, val);
 		}
 
 
@@ -181,20 +213,16 @@ namespace cz
 		{
 			CZ_ASSERT(at<=end);
 
-			// Move elements forward to make space for the new one
-			size_t count = end-at;
-			if (count)
+			// If val is one of the elements being moved, then it will end up 1 position forward
+			const Type* src = &val;
+			if (src>=at && src<end)
 			{
-				Type *p=end;
-				while(count--)
-				{
-					TArrayElementCreation<Type>::constructCopy(p,*(p-1));
-					p--;
-					TArrayElementCreation<Type>::destroy(p);
-				}
+				src++;
 			}
 
-			TArrayElementCreation<Type>::constructCopy(at, val);
+			// Move elements forward to make space for the new one
+			TArrayElementCreation<Type>::relocate(at+1, at, static_cast<int>(end-at));
+			TArrayElementCreation<Type>::constructCopy(at, *src);
 		}
 
 		/*!
@@ -208,15 +236,83 @@ namespace cz
 			TArrayElementCreation<Type>::destroy(at);
 
 			// Move the other items, compacting the array
-			int count = static_cast<int>(end-at-1);
-			Type *p = at;
-			while(count--)
+			TArrayElementCreation<Type>::relocate(at, at+1, static_cast<int>(end-at-1));
+		}
+
+		/*!
+		* Inserts copies of a range of elements, moving the existing elements only once
+		* \param at Where to insert
+		* \param end Where the array ends (exclusive). There needs to be space for count more elements after it
+		* \param src Elements to insert. Can point to elements of the array itself
+		* \param count How many elements to insert
+		*/
+		static void _insertRange(Type* at, Type* end, const Type* src, int count)
+		{
+			CZ_ASSERT(at<=end && count>=0);
+
+			TArrayElementCreation<Type>::relocate(at+count, at, static_cast<int>(end-at));
+
+			if (src+count<=at || src>=end)
+			{
+				_copyToNewMemory(at, src, count);
+			}
+			else
+			{
+				// Some of the source elements were moved forward to make space, so adjust as we go
+				for (int i=0; i<count; i++)
+				{
+					const Type* p = src+i;
+					if (p>=at && p<end)
+					{
+						p += count;
+					}
+					TArrayElementCreation<Type>::constructCopy(at+i, *p);
+				}
+			}
+		}
+
+		/*!
+		* Removes a range of elements, moving the elements after it only once
+		* \param at First element to remove
+		* \param end Where the array ends (exclusive)
+		* \param count How many elements to remove
+		*/
+		static void _eraseRange(Type* at, Type* end, int count)
+		{
+			CZ_ASSERT(count>=0 && at+count<=end);
+			if (count==0)
+			{
+				return;
+			}
+
+			TArrayElementCreation<Type>::destroy(at, count);
+			TArrayElementCreation<Type>::relocate(at, at+count, static_cast<int>(end-at-count));
+		}
+
+		/*!
+		* Removes all the elements for which pred returns true, in a single pass.
+		* Runs of elements that are kept are moved in one go.
+		* \return How many elements are left
+		*/
+		template<typename Pred>
+		static int _eraseIf(Type* start, Type* end, Pred& pred)
+		{
+			Type* dst = start;
+			Type* run = start; // Start of the run of elements to keep, that still need to be moved to dst
+			for (Type* p=start; p<end; p++)
 			{
-				TArrayElementCreation<Type>::constructCopy(p, *(p+1));
-				p++;
-				TArrayElementCreation<Type>::destroy(p);
+				if (pred(*p))
+				{
+					TArrayElementCreation<Type>::relocate(dst, run, static_cast<int>(p-run));
+					dst += p-run;
+					TArrayElementCreation<Type>::destroy(p);
+					run = p+1;
+				}
 			}
 
+			TArrayElementCreation<Type>::relocate(dst, run, static_cast<int>(end-run));
+			dst += end-run;
+			return static_cast<int>(dst-start);
 		}
 
 		/*!
@@ -230,13 +326,7 @@ namespace cz
 		*/
 		static void _moveToNewMemory(void *dst, Type *src, int count)
 		{
-			while(count--)
-			{
-				TArrayElementCreation<Type>::constructCopy(dst, *src);
-				TArrayElementCreation<Type>::destroy(src);
-				dst = reinterpret_cast<Type*>(dst)+1;
-				src++;
-			}
+			TArrayElementCreation<Type>::relocate(dst, src, count);
 		}
 
 		/*!
@@ -249,11 +339,21 @@ namespace cz
 		*/
 		static void _copyToNewMemory(void *dst, const Type *src, int count)
 		{
-			while(count--)
+			if constexpr (std::is_trivially_copyable<Type>::value)
 			{
-				TArrayElementCreation<Type>::constructCopy(dst, *src);
-				dst = reinterpret_cast<Type*>(dst)+1;
-				src++;
+				if (count>0)
+				{
+					memcpy(dst, src, sizeof(Type)*count);
+				}
+			}
+			else
+			{
+				while(count--)
+				{
+					TArrayElementCreation<Type>::constructCopy(dst, *src);
+					dst = reinterpret_cast<Type*>(dst)+1;
+					src++;
+				}
 			}
 		}
 
@@ -261,11 +361,7 @@ namespace cz
 		*/
 		static void _setTo(Type* start, const Type &val, int count)
 		{
-			while(count--)
-			{
-				*start = val;
-				start++;
-			}
+			simd::fill(start, val, count);
 		}
 
 	};
@@ -307,7 +403,7 @@ namespace cz
 		TStaticArray()
 		{
 			// Compile time assert to make sure the size of this object is the same size as the equivalent C style array
-			CZ_COMPILETIME_ASSERT(sizeof(TStaticArray)==sizeof(Type)*SIZE);
+			static_assert(sizeof(TStaticArray)==sizeof(Type)*SIZE, "TStaticArray should have the same size as a C array");
 			TArrayElementCreation<Type>::construct_multiple(&eleAt(0), SIZE);
 		}
 
@@ -335,7 +431,7 @@ namespace cz
 		*/
 		void setAll(const Type &val)
 		{
-			_setTo(&eleAt(0), val, SIZE);
+			this->_setTo(&eleAt(0), val, SIZE);
 		}
 
 		//! Finds the specified value, and lets you know at what index
@@ -345,13 +441,19 @@ namespace cz
 		// \note Complexity is O(n). It just transverses the array to find the value
 		bool find(const Type &val, int &destIndex) const
 		{
-			return _find(&eleAt(0), &eleAt(SIZE), val, destIndex);
+			return this->_find(&eleAt(0), &eleAt(SIZE), val, destIndex);
 		}
 
 		/*! */
 		bool find(const Type &val) const
 		{
-			return _find(&eleAt(0), &eleAt(SIZE), val);
+			return this->_find(&eleAt(0), &eleAt(SIZE), val);
+		}
+
+		/*! Counts how many elements are equal to val */
+		int count(const Type &val) const
+		{
+			return this->_count(&eleAt(0), &eleAt(SIZE), val);
 		}
 
 		Type* begin()
@@ -364,6 +466,16 @@ namespace cz
 			return &eleAt(SIZE);
 		}
 
+		const Type* begin() const
+		{
+			return &eleAt(0);
+		}
+
+		const Type* end() const
+		{
+			return &eleAt(SIZE);
+		}
+
 		/*! Returns the array size */
 		int size() const
 		{
@@ -441,12 +553,34 @@ namespace cz
 			}
 		}
 
+		/*! Moves a new element into the end of the array
+		\return true if succeeded, false otherwise
+		*/
+		bool push(Type&& val)
+		{
+			if (mUsedSize==SIZE)
+			{
+				return false;
+			}
+			else
+			{
+				TArrayElementCreation<Type>::constructMove(&eleAt(mUsedSize), std::move(val));
+				mUsedSize++;
+				return true;
+			}
+		}
+
 		/*! Same as \link push \endlink , so it has an interface similar to std::vector*/
 		bool push_back(const Type &val)
 		{
 			return push(val);
 		}
 
+		bool push_back(Type&& val)
+		{
+			return push(std::move(val));
+		}
+
 		/*! Removes the last element
 		\return true if succeeded, false if the array was empty
 		*/
@@ -476,7 +610,7 @@ namespace cz
 			}
 			else
 			{
-				dest = eleAt(mUsedSize-1);
+				dest = std::move(eleAt(mUsedSize-1));
 				return pop();
 			}
 		}
@@ -526,6 +660,16 @@ namespace cz
 			return &eleAt(mUsedSize);
 		}
 
+		const Type* begin() const
+		{
+			return &eleAt(0);
+		}
+
+		const Type* end() const
+		{
+			return &eleAt(mUsedSize);
+		}
+
 		/*! Returns the number of indexes used in the array */
 		int size() const
 		{
@@ -562,6 +706,12 @@ namespace cz
 			return Super::_find(&eleAt(0), &eleAt(mUsedSize), val);
 		}
 
+		/*! Counts how many elements are equal to val */
+		int count(const Type &val) const
+		{
+			return Super::_count(&eleAt(0), &eleAt(mUsedSize), val);
+		}
+
 		/*! Inserts the specified value at the specified index, moving forward all the elements, starting at index "index"
 		\param index Index at which to insert
 		\param val Value to insert
@@ -575,7 +725,7 @@ namespace cz
 				return false;
 			}
 
-			_insertAt(&eleAt(index), &eleAt(mUsedSize), val);
+			this->_insertAt(&eleAt(index), &eleAt(mUsedSize), val);
 			mUsedSize++;
 			return true;
 		}
@@ -611,7 +761,7 @@ namespace cz
 				return false;
 			}
 
-			dest = eleAt(index);
+			dest = std::move(eleAt(index));
 			return removeAtIndex(index);
 		}
 
@@ -621,15 +771,55 @@ namespace cz
 		*/
 		int removeIfExists(const Type &val)
 		{
-			int count=0;
-			for (int i=size(); i>0; i--)
+			return eraseIf([&val](const Type& v) { return v==val; });
+		}
+
+		/*! Inserts copies of a range of elements at the specified index.
+		The elements after index are moved only once, instead of once per inserted element.
+		\param index Where to insert
+		\param first Pointer to the first element to insert. Can point to elements of this array
+		\param count How many elements to insert
+		\return true if succeeded, false if index is invalid or there is no space for the new elements
+		*/
+		bool insertRange(int index, const Type* first, int count)
+		{
+			if (index<0 || index>mUsedSize || count<0 || mUsedSize+count>SIZE)
 			{
-				if (eleAt(i-1)==val)
-				{
-					count++;
-					removeAtIndex(i-1);
-				}
+				return false;
+			}
+
+			this->_insertRange(ptrToEleAt(index), ptrToEleAt(mUsedSize), first, count);
+			mUsedSize += count;
+			return true;
+		}
+
+		/*! Removes count elements starting at the specified index, and compacts the array.
+		The elements after the range are moved only once.
+		\return true if succeeded, false if the range is invalid
+		*/
+		bool eraseRange(int index, int count)
+		{
+			if (index<0 || count<0 || index+count>mUsedSize)
+			{
+				return false;
 			}
+
+			this->_eraseRange(ptrToEleAt(index), ptrToEleAt(mUsedSize), count);
+			mUsedSize -= count;
+			return true;
+		}
+
+		/*! Removes all the elements for which pred returns true, keeping the order of the others.
+		It's a single pass over the array, so it's O(n) no matter how many elements are removed.
+		\param pred Called once per element, as pred(const Type&)
+		\return number of elements removed
+		*/
+		template<typename Pred>
+		int eraseIf(Pred pred)
+		{
+			int newSize = this->_eraseIf(ptrToEleAt(0), ptrToEleAt(mUsedSize), pred);
+			int count = mUsedSize-newSize;
+			mUsedSize = newSize;
 			return count;
 		}
 
@@ -649,6 +839,16 @@ namespace cz
 			return *(reinterpret_cast<Type*>(&mItems[sizeof(Type)*index]));
 		}
 
+		const Type* ptrToEleAt(int index) const
+		{
+			return reinterpret_cast<const Type*>(&mItems[sizeof(Type)*index]);
+		}
+
+		Type* ptrToEleAt(int index)
+		{
+			return reinterpret_cast<Type*>(&mItems[sizeof(Type)*index]);
+		}
+
 		// Using raw memory, because object creation/destruction is controlled manually
 		char mItems[sizeof(Type)*SIZE];
 		int mUsedSize;
@@ -659,119 +859,232 @@ namespace cz
 		TStaticArray& operator=(const TStaticArray& other);
 	};
 
-
-	/*! Dynamic array
+	/*! Fixed size array that can be fully built at compile time, for lookup tables.
+	Unlike TStaticArray, which constructs its elements at runtime, this is a literal type with no constructors, so a
+	constexpr instance doesn't need any code to run at startup, and a "static constexpr" or namespace scope constexpr
+	table is placed in read only memory (flash, on ARM). E.g:
+	\code
+	static constexpr cz::TConstexprArray<uint8_t, 4> gPins = {{2, 3, 5, 7}};
+	static constexpr auto gGamma = cz::makeConstexprArray<uint8_t, 256>([](int i) { return uint8_t(i*i/255); });
+	\endcode
+	Type needs to be a literal type (e.g: integers, floats, enums, or structs of those).
+	It has the same operator[], begin/end and size as TStaticArray.
+	\note On AVR, read only data is still copied to RAM at startup, since reading from flash needs pgm_read_*. It
+	still saves the code and time to build the table.
+	\note operator[] can't use CZ_ASSERT, since that can't be used in constexpr functions. Out of bounds accesses are
+	still detected when evaluated at compile time.
 	*/
-	template<typename Type>
-	class TArray : public TBaseArray<Type>
+	template<typename Type, int Size>
+	struct TConstexprArray
 	{
-	public:
+		static_assert(Size>0, "TConstexprArray needs at least one element");
 
-		TArray()
+		enum
 		{
-			mData = NULL;
-			mCapacity = 0;
-			mSize = 0;
-		}
+			SIZE = Size
+		};
 
-		/*! Constructor
-		\param initialCapacity Initial array capacity
-		*/
-		explicit TArray(long initialCapacity)
+		constexpr const Type& operator[](int index) const
 		{
-			// Don't allow capacity 0, otherwise we would have a NULL pointer, and iterators wouldn't work
-			if (initialCapacity>0)
-			{
-				mData = malloc(initialCapacity*sizeof(Type));
-				mCapacity = initialCapacity;
-				mSize = 0;
-				#if CZ_DEBUG
-				memset(mData, 0xCD, sizeof(Type)*mCapacity);
-				#endif
-			}
-			else
-			{
-				mData = NULL;
-				mCapacity = 0;
-				mSize = 0;
-			}
+			return mItems[index];
+		}
 
+		constexpr Type& operator[](int index)
+		{
+			return mItems[index];
 		}
 
-		/*! Construct the array, copying from another array*/
-		TArray(const TArray& other)
+		constexpr const Type* begin() const
 		{
-			mData = NULL;
-			mCapacity = 0;
-			mSize = 0;
-			setTo(other);
+			return mItems;
 		}
 
-		~TArray()
+		constexpr const Type* end() const
 		{
-			clear();
-			if (mData)
-			{
-				free(mData);
-			}
+			return mItems+SIZE;
 		}
 
+		constexpr Type* begin()
+		{
+			return mItems;
+		}
 
-		/*! \name STL compatible methods
-			@{
-		*/
+		constexpr Type* end()
+		{
+			return mItems+SIZE;
+		}
 
-		/*! Returns a pointer to the first element
-		This can be used with std algorithms.
-		\note in order to work with stl algorithms, if the array is empty, it will return NULL (which means it's equal to end())
-		*/
-		Type* begin()
+		/*! Returns the array size */
+		constexpr int size() const
 		{
-			return (mData) ? &eleAt(0) : NULL;
+			return SIZE;
 		}
 
-		const Type* begin() const
+		constexpr int capacity() const
 		{
-			return (mData) ? &eleAt(0) : NULL;
+			return SIZE;
 		}
-	
-		/*! Returns a pointer addressing the position one past the final element
-		This can be used with std algorithms.
-		\note In order to work with stl algorithms, if the array is empty, it will return NULL (which will be equal to begin())
+
+		/*! Finds the specified value
+		\param val Value to search for
+		\param destIndex Where you'll get the index at which the value was found
+		\return true if found (destIndex will contain the index), false if not found
 		*/
-		Type* end()
+		bool find(const Type& val, int& destIndex) const
 		{
-			return (mData) ? &eleAt(mSize) : NULL;
+			const Type* p = simd::find(begin(), end(), val);
+			if (p==end())
+				return false;
+			destIndex = static_cast<int>(p-begin());
+			return true;
 		}
 
-		const Type* end() const
+		/*! */
+		bool find(const Type& val) const
 		{
-			return (mData) ? &eleAt(mSize) : NULL;
+			return simd::find(begin(), end(), val)!=end();
 		}
 
-		/*! Grows the array if necessary, to have enough capacity for the specified number of elements */
-		void reserve(int newcapacity)
+		/*! Counts how many elements are equal to val */
+		int count(const Type& val) const
 		{
-			if (newcapacity>mCapacity)
-				grow(newcapacity);
+			return simd::count(begin(), end(), val);
 		}
 
-		/*! Resizes the container to contain count elements.
-		If the current size is less than count, additional elements are appended and initialized with value.
-		If the current size is greater than count, the container is reduced to its first count elements.
-		*/
-		void resize(int count)
-		{
-			if (size()<count)
-			{
+		// Public only so the class is an aggregate and can be brace initialized. Use operator[] instead.
+		Type mItems[Size];
+	};
+
+	/*! Builds a TConstexprArray at compile time, by calling gen(index) for each element
+	\param gen Callable with a constexpr operator(), taking the index and returning the element's value
+	*/
+	template<typename Type, int Size, typename Generator>
+	constexpr TConstexprArray<Type, Size> makeConstexprArray(Generator gen)
+	{
+		TConstexprArray<Type, Size> res{};
+		for (int i=0; i<Size; i++)
+			res.mItems[i] = gen(i);
+		return res;
+	}
+
+
+	/*! Growth policies for TArray.
+	They calculate the new capacity when the array needs space for "required" elements.
+	*/
+
+	/*! Grows the capacity by NUM/DEN, with a minimum of MIN elements. */
+	template<int NUM=2, int DEN=1, int MIN=16>
+	struct TGeometricGrowth
+	{
+		static_assert(NUM>DEN, "TGeometricGrowth needs a factor bigger than 1");
+
+		static int calcCapacity(int capacity, int required)
+		{
+			int newCapacity = static_cast<int>(static_cast<long long>(capacity) * NUM / DEN);
+			if (newCapacity < MIN)
+				newCapacity = MIN;
+			return newCapacity < required ? required : newCapacity;
+		}
+	};
+
+	/*! Grows the capacity by STEP elements at a time. */
+	template<int STEP>
+	struct TFixedStepGrowth
+	{
+		static_assert(STEP>0, "TFixedStepGrowth needs a positive step");
+
+		static int calcCapacity(int capacity, int required)
+		{
+			int newCapacity = capacity + STEP;
+			return newCapacity < required ? required : newCapacity;
+		}
+	};
+
+	/*! Grows the capacity to exactly what is required. Uses the least memory, but every push needs to reallocate. */
+	struct ExactGrowth
+	{
+		static int calcCapacity(int /*capacity*/, int required)
+		{
+			return required;
+		}
+	};
+
+	/*! Implementation shared by the arrays that grow as needed (TArray and TInlineArray), so they only differ in where
+	the memory comes from.
+	The derived class owns the memory, and provides:
+		- bool setCapacity(int newCapacity) : Grows or shrinks the memory. Returns false if the allocator failed, in
+		which case the array is left untouched.
+		- bool growFor(int required) : Grows the memory so it fits at least "required" elements.
+	\tparam Type Element type
+	\tparam Derived The derived array class
+	*/
+	template<typename Type, typename Derived>
+	class TGrowableArray : public TBaseArray<Type>
+	{
+	public:
+
+		/*! \name STL compatible methods
+			@{
+		*/
+
+		/*! Returns a pointer to the first element
+		This can be used with std algorithms.
+		\note in order to work with stl algorithms, if the array has no memory, it will return NULL (which means it's equal to end())
+		*/
+		Type* begin()
+		{
+			return ptrToEleAt(0);
+		}
+
+		const Type* begin() const
+		{
+			return ptrToEleAt(0);
+		}
+
+		/*! Returns a pointer addressing the position one past the final element
+		This can be used with std algorithms.
+		\note In order to work with stl algorithms, if the array has no memory, it will return NULL (which will be equal to begin())
+		*/
+		Type* end()
+		{
+			return ptrToEleAt(mSize);
+		}
+
+		const Type* end() const
+		{
+			return ptrToEleAt(mSize);
+		}
+
+		/*! Grows the array if necessary, to have enough capacity for the specified number of elements
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool reserve(int newcapacity)
+		{
+			if (newcapacity>mCapacity)
+				return derived().setCapacity(newcapacity);
+			return true;
+		}
+
+		/*! Resizes the container to contain count elements.
+		If the current size is less than count, additional elements are appended and value initialized.
+		If the current size is greater than count, the container is reduced to its first count elements.
+		\return true if successful, false otherwise (e.g: Out of memory), in which case the elements that fit are kept
+		*/
+		bool resize(int count)
+		{
+			if (size()<count)
+			{
 				while(size()!=count)
-					emplace_back();
+				{
+					if (!emplace_back())
+						return false;
+				}
 			}
 			else
 			{
 				while(size()>count)
 					pop_back();
 			}
+			return true;
 		}
 
 		/*! Reduces the capacity to "size"
@@ -779,7 +1092,7 @@ namespace cz
 		*/
 		void shrink_to_fit()
 		{
-			setCapacity(mSize);
+			derived().setCapacity(mSize);
 		}
 
 		/*! Returns how many elements the array can contain without allocating more memory */
@@ -796,72 +1109,30 @@ namespace cz
 			push(val);
 		}
 
-		/*! Remove the last element, if any */
-		void pop_back()
+		void push_back(Type&& val)
 		{
-			pop();
+			push(std::move(val));
 		}
 
-
-		/* Appends a new element at the end of the array, constructing it in-place*/
-		void emplace_back()
-		{
-			if (mSize==mCapacity)
-				grow(mCapacity*2);
-
-			TArrayElementCreation<Type>::construct(&eleAt(mSize));
-			mSize++;
-		}
-
-		template<typename A1>
-		void emplace_back(A1 a1)
-		{
-			if (mSize==mCapacity)
-				grow(mCapacity*2);
-
-			TArrayElementCreation<Type>::construct(&eleAt(mSize), std::forward<A1>(a1));
-			mSize++;
-		}
-
-
-		template<typename A1, typename A2>
-		void emplace_back(A1 a1, A2 a2)
-		{
-			if (mSize==mCapacity)
-				grow(mCapacity*2);
-
-			TArrayElementCreation<Type>::construct(&eleAt(mSize), std::forward<A1>(a1), std::forward<A2>(a2));
-			mSize++;
-		}
-
-		template<typename A1, typename A2, typename A3>
-		void emplace_back(A1 a1, A2 a2, A3 a3)
+		/*! Remove the last element, if any */
+		void pop_back()
 		{
-			if (mSize==mCapacity)
-				grow(mCapacity*2);
-
-			TArrayElementCreation<Type>::construct(&eleAt(mSize), std::forward<A1>(a1), std::forward<A2>(a2), std::forward<A3>(a3));
-			mSize++;
+			pop();
 		}
 
-		template<typename A1, typename A2, typename A3, typename A4>
-		void emplace_back(A1 a1, A2 a2, A3 a3, A4 a4)
-		{
-			if (mSize==mCapacity)
-				grow(mCapacity*2);
 
-			TArrayElementCreation<Type>::construct(&eleAt(mSize), std::forward<A1>(a1), std::forward<A2>(a2), std::forward<A3>(a3), std::forward<A4>(a4));
-			mSize++;
-		}
-
-		template<typename A1, typename A2, typename A3, typename A4, typename A5>
-		void emplace_back(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5)
+		/* Appends a new element at the end of the array, constructing it in-place
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		template<typename... Args>
+		bool emplace_back(Args&&... args)
 		{
+			// args might refer to elements of this array, so the new element is created before the memory moves
 			if (mSize==mCapacity)
-				grow(mCapacity*2);
+				return emplaceAndGrow(Type(std::forward<Args>(args)...));
 
-			TArrayElementCreation<Type>::construct(&eleAt(mSize), std::forward<A1>(a1), std::forward<A2>(a2), std::forward<A3>(a3), std::forward<A4>(a4), std::forward<A5>(a5));
+			TArrayElementCreation<Type>::construct(ptrToEleAt(mSize), std::forward<Args>(args)...);
 			mSize++;
+			return true;
 		}
 
 		/*! Returns how many elements there are in the array */
@@ -870,12 +1141,12 @@ namespace cz
 			return mSize;
 		}
 
-		/*! Removes all elements from the array */
+		/*! Removes all elements from the array. Doesn't release any memory. */
 		void clear()
 		{
 			if (mSize>0)
 			{
-				TArrayElementCreation<Type>::destroy(&eleAt(0), mSize);
+				TArrayElementCreation<Type>::destroy(ptrToEleAt(0), mSize);
 				mSize = 0;
 			}
 		}
@@ -895,48 +1166,35 @@ namespace cz
 			@{
 		*/
 
-		/*! */
-		TArray& operator=(const TArray& other)
-		{
-			if (this!=&other)
-				setTo(other);
-			return *this;
-		}
-
 		/*! */
 		const Type& operator[](int index) const
 		{
 			CZ_ASSERT(index<mSize);
-			return eleAt(index);
+			return *ptrToEleAt(index);
 		}
 
 		/*! */
 		Type& operator[](int index)
 		{
 			CZ_ASSERT(index<mSize);
-			return eleAt(index);
+			return *ptrToEleAt(index);
 		}
 
-		bool operator==(const TArray& other) const
+		bool operator==(const TGrowableArray& other) const
 		{
 			if (this==&other)
 				return true;
-			if (this->size() != other.size())
+			if (size() != other.size())
 				return false;
 
 			for(int i=0; i<size(); i++)
 			{
-				if (!(eleAt(i)==other.eleAt(i)))
+				if (!((*this)[i]==other[i]))
 					return false;
 			}
 			return true;
 		}
 
-		bool operator<(const TArray& other) const
-		{
-			// Not really the same behaviour as in std::vector
-			return size() < other.size();
-		}
 		/*!
 			@}
 		*/
@@ -948,11 +1206,26 @@ namespace cz
 		{
 			if (mSize==mCapacity)
 			{
-				if (!grow(mCapacity*2))
-					return false;
+				// val might be an element of this array, so copy it before the memory moves
+				return emplaceAndGrow(Type(val));
+			}
+
+			TArrayElementCreation<Type>::constructCopy(ptrToEleAt(mSize), val);
+			mSize++;
+			return true;
+		}
+
+		/*! Moves a new element to the end of the array
+		\param val Element to add
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool push(Type&& val)
+		{
+			if (mSize==mCapacity)
+			{
+				return emplaceAndGrow(Type(std::move(val)));
 			}
 
-			TArrayElementCreation<Type>::constructCopy(&eleAt(mSize), val);
+			TArrayElementCreation<Type>::constructMove(ptrToEleAt(mSize), std::move(val));
 			mSize++;
 			return true;
 		}
@@ -963,11 +1236,23 @@ namespace cz
 		\return true if successful, false otherwise (e.g: Out of memory)*/
 		bool push(const Type& val, int count)
 		{
-			while (count--)
+			if (count<=0)
+				return true;
+
+			if (mSize+count>mCapacity)
 			{
-				if (!push(val))
+				// val might be an element of this array, so copy it before the memory moves
+				Type tmp(val);
+				if (!derived().growFor(mSize+count))
 					return false;
+				TArrayElementCreation<Type>::constructCopy(ptrToEleAt(mSize), tmp, count);
+			}
+			else
+			{
+				TArrayElementCreation<Type>::constructCopy(ptrToEleAt(mSize), val, count);
 			}
+
+			mSize += count;
 			return true;
 		}
 
@@ -981,8 +1266,8 @@ namespace cz
 			if (mSize==0)
 				return false;
 			mSize--;
-			dest = eleAt(mSize);
-			TArrayElementCreation<Type>::destroy(&eleAt(mSize));
+			dest = std::move(*ptrToEleAt(mSize));
+			TArrayElementCreation<Type>::destroy(ptrToEleAt(mSize));
 			return true;
 		}
 
@@ -994,7 +1279,7 @@ namespace cz
 			if (mSize==0)
 				return false;
 			mSize--;
-			TArrayElementCreation<Type>::destroy(&eleAt(mSize));
+			TArrayElementCreation<Type>::destroy(ptrToEleAt(mSize));
 			return true;
 		}
 
@@ -1003,7 +1288,7 @@ namespace cz
 		const Type& last() const
 		{
 			CZ_ASSERT(mSize>0);
-			return eleAt(mSize-1);
+			return *ptrToEleAt(mSize-1);
 		}
 
 		/*! Returns a reference to the last element
@@ -1011,7 +1296,7 @@ namespace cz
 		Type& last()
 		{
 			CZ_ASSERT(mSize>0);
-			return eleAt(mSize-1);
+			return *ptrToEleAt(mSize-1);
 		}
 
 		/*! Finds an element
@@ -1022,13 +1307,19 @@ namespace cz
 		*/
 		bool find(const Type &val, int &destIndex) const
 		{
-			return _find(&eleAt(0), &eleAt(mSize), val, destIndex);
+			return this->_find(ptrToEleAt(0), ptrToEleAt(mSize), val, destIndex);
 		}
 
 		/*! Finds an element*/
 		bool find(const Type &val) const
 		{
-			return _find(&eleAt(0), &eleAt(mSize), val);
+			return this->_find(ptrToEleAt(0), ptrToEleAt(mSize), val);
+		}
+
+		/*! Counts how many elements are equal to val */
+		int count(const Type &val) const
+		{
+			return this->_count(ptrToEleAt(0), ptrToEleAt(mSize), val);
 		}
 
 
@@ -1036,18 +1327,24 @@ namespace cz
 		*/
 		bool insertAtIndex(int index, const Type &val)
 		{
-			if (index>mSize)
+			if (index<0 || index>mSize)
 			{
 				return false;
 			}
 
 			if (mSize==mCapacity)
 			{
-				if (!grow(mCapacity*2))
+				// val might be an element of this array, so copy it before the memory moves
+				Type tmp(val);
+				if (!derived().growFor(mSize+1))
 					return false;
+				this->_insertAt(ptrToEleAt(index), ptrToEleAt(mSize), tmp);
+			}
+			else
+			{
+				this->_insertAt(ptrToEleAt(index), ptrToEleAt(mSize), val);
 			}
 
-			_insertAt(&eleAt(index), &eleAt(mSize), val);
 			mSize++;
 			return true;
 		}
@@ -1065,7 +1362,7 @@ namespace cz
 				return false;
 			}
 
-			_removeAt(&eleAt(index), &eleAt(mSize));
+			this->_removeAt(ptrToEleAt(index), ptrToEleAt(mSize));
 			//The last element is now invalid, so decrease the size by 1
 			mSize--;
 			return true;
@@ -1081,14 +1378,12 @@ namespace cz
 				return false;
 			}
 
-			Type* pAt = &eleAt(index);
+			Type* pAt = ptrToEleAt(index);
 			TArrayElementCreation<Type>::destroy(pAt);
-			// Copy the last element to the position we want to delete
+			// Move the last element to the position we want to delete
 			if (index<mSize-1)
 			{
-				Type* pLastEle = &eleAt(mSize-1);
-				TArrayElementCreation<Type>::constructCopy(pAt, *pLastEle);
-				TArrayElementCreation<Type>::destroy(pLastEle);
+				TArrayElementCreation<Type>::relocate(pAt, ptrToEleAt(mSize-1), 1);
 			}
 
 			mSize--;
@@ -1103,107 +1398,532 @@ namespace cz
 		*/
 		int removeIfExists(const Type &val)
 		{
-			int count=0;
-			for (int i=size(); i>0; i--)
+			return eraseIf([&val](const Type& v) { return v==val; });
+		}
+
+		/*! Inserts copies of a range of elements at the specified index.
+		The elements after index are moved only once, instead of once per inserted element.
+		\param index Where to insert
+		\param first Pointer to the first element to insert. Can point to elements of this array
+		\param count How many elements to insert
+		\return true if succeeded, false if index is invalid or there is no space for the new elements
+		*/
+		bool insertRange(int index, const Type* first, int count)
+		{
+			if (index<0 || index>mSize || count<0)
 			{
-				if (eleAt(i-1)==val)
+				return false;
+			}
+
+			if (mSize+count>mCapacity)
+			{
+				// If the source is in this array, it moves with the memory
+				const Type* data = ptrToEleAt(0);
+				int offset = (mData && first>=data && first<data+mSize) ? static_cast<int>(first-data) : -1;
+				if (!derived().growFor(mSize+count))
 				{
-					count++;
-					removeAtIndex(i-1);
+					return false;
+				}
+				if (offset!=-1)
+				{
+					first = ptrToEleAt(offset);
 				}
 			}
+
+			this->_insertRange(ptrToEleAt(index), ptrToEleAt(mSize), first, count);
+			mSize += count;
+			return true;
+		}
+
+		/*! Removes count elements starting at the specified index, and compacts the array.
+		The elements after the range are moved only once.
+		\return true if succeeded, false if the range is invalid
+		*/
+		bool eraseRange(int index, int count)
+		{
+			if (index<0 || count<0 || index+count>mSize)
+			{
+				return false;
+			}
+
+			this->_eraseRange(ptrToEleAt(index), ptrToEleAt(mSize), count);
+			mSize -= count;
+			return true;
+		}
+
+		/*! Removes all the elements for which pred returns true, keeping the order of the others.
+		It's a single pass over the array, so it's O(n) no matter how many elements are removed.
+		\param pred Called once per element, as pred(const Type&)
+		\return number of elements removed
+		*/
+		template<typename Pred>
+		int eraseIf(Pred pred)
+		{
+			int newSize = this->_eraseIf(ptrToEleAt(0), ptrToEleAt(mSize), pred);
+			int count = mSize-newSize;
+			mSize = newSize;
 			return count;
 		}
 
 
 		/*! Appends data from another array
 		*/
-		void append(const TArray& other)
+		bool append(const TGrowableArray& other)
 		{
-			// This actually supports appending an array to itself
-			append(other.ptrToEleAt(0), other.size());
+			// This actually supports appending an array to itself, as long as the memory is reserved before getting
+			// the pointer to the source elements
+			if (mSize+other.size()>mCapacity && !derived().growFor(mSize+other.size()))
+				return false;
+			return append(other.ptrToEleAt(0), other.size());
 		}
 
-		void append(const Type* data, int count)
+		bool append(const Type* data, int count)
 		{
-			reserve(size()+count);
-			_copyToNewMemory(ptrToEleAt(size()), data, count);
+			if (mSize+count>mCapacity && !derived().growFor(mSize+count))
+				return false;
+			this->_copyToNewMemory(ptrToEleAt(size()), data, count);
 			mSize += count;
+			return true;
 		}
 
-	private:
-		const Type& eleAt(int index) const
+	protected:
+
+		TGrowableArray()
+			: mData(NULL)
+			, mCapacity(0)
+			, mSize(0)
 		{
-			return *(reinterpret_cast<const Type*>(&( ((char*)mData)[sizeof(Type)*index] )));
 		}
 
-		Type& eleAt(int index)
+		Derived& derived()
 		{
-			return *(reinterpret_cast<Type*>(&( ((char*)mData)[sizeof(Type)*index] )));
+			return static_cast<Derived&>(*this);
 		}
 
 		const Type* ptrToEleAt(int index) const
 		{
-			return reinterpret_cast<const Type*>(&( ((char*)mData)[sizeof(Type)*index] ));
+			return reinterpret_cast<const Type*>(mData) + index;
 		}
 
 		Type* ptrToEleAt(int index)
 		{
-			return reinterpret_cast<Type*>(&( ((char*)mData)[sizeof(Type)*index] ));
+			return reinterpret_cast<Type*>(mData) + index;
 		}
 
-		void setTo(const TArray& other)
+		// Makes this array a copy of other. Either all the elements are copied, or the array is left empty
+		bool setTo(const TGrowableArray& other)
 		{
 			clear();
-			if (other.mSize)
+			if (!reserve(other.mSize))
+				return false;
+			this->_copyToNewMemory(ptrToEleAt(0), other.ptrToEleAt(0), other.mSize);
+			mSize = other.mSize;
+			return true;
+		}
+
+		// Adds an element that was created before growing, for when the element being added might be in the array
+		bool emplaceAndGrow(Type&& val)
+		{
+			if (!derived().growFor(mSize+1))
+				return false;
+
+			TArrayElementCreation<Type>::constructMove(ptrToEleAt(mSize), std::move(val));
+			mSize++;
+			return true;
+		}
+
+		void* mData;
+		int mCapacity;
+		int mSize;
+	};
+
+	/*! Dynamic array
+	\tparam Type Element type
+	\tparam Allocator Where the memory comes from. See Allocator.h
+		Stateful allocators (e.g: ArenaAllocator, PoolAllocator) are used through a TAllocatorRef. E.g:
+		\code
+		cz::TStaticArenaAllocator<4096> arena;
+		cz::TArray<int, cz::TAllocatorRef<cz::ArenaAllocator>> a(arena);
+		\endcode
+	\tparam GrowthPolicy How the capacity grows when the array is full (e.g: TGeometricGrowth, TFixedStepGrowth, ExactGrowth)
+	*/
+	template<typename Type, typename Allocator = MallocAllocator, typename GrowthPolicy = TGeometricGrowth<>>
+	class TArray : public TGrowableArray<Type, TArray<Type, Allocator, GrowthPolicy>>, private Allocator
+	{
+		using Base = TGrowableArray<Type, TArray>;
+		friend Base;
+
+	public:
+
+		TArray()
+		{
+		}
+
+		/*! Constructor
+		\param allocator Allocator to use
+		*/
+		explicit TArray(const Allocator& allocator)
+			: Allocator(allocator)
+		{
+		}
+
+		/*! Constructor
+		\param initialCapacity Initial array capacity
+		*/
+		explicit TArray(long initialCapacity)
+		{
+			init(initialCapacity);
+		}
+
+		/*! Constructor
+		\param initialCapacity Initial array capacity
+		\param allocator Allocator to use
+		*/
+		TArray(long initialCapacity, const Allocator& allocator)
+			: Allocator(allocator)
+		{
+			init(initialCapacity);
+		}
+
+		/*! Construct the array, copying from another array. The allocator is copied too.
+		If there isn't enough memory for all the elements, the array is left empty, so if the allocator can fail, check
+		size() afterwards.
+		*/
+		TArray(const TArray& other)
+			: Allocator(other.getAllocator())
+		{
+			this->setTo(other);
+		}
+
+		/*! Construct the array, taking the memory and allocator of another array. The other array is left empty.*/
+		TArray(TArray&& other) noexcept
+			: Allocator(std::move(static_cast<Allocator&>(other)))
+		{
+			mData = other.mData;
+			mCapacity = other.mCapacity;
+			mSize = other.mSize;
+			other.mData = NULL;
+			other.mCapacity = 0;
+			other.mSize = 0;
+		}
+
+		~TArray()
+		{
+			this->clear();
+			if (mData)
 			{
-				reserve(other.mCapacity);
-				for (int i=0; i<other.size(); i++)
-					push(other[i]);
+				Allocator::deallocate(mData, mCapacity*sizeof(Type));
+			}
+		}
+
+		/*! Returns the allocator used by the array */
+		const Allocator& getAllocator() const
+		{
+			return *this;
+		}
+
+		/*! Swaps the contents (and allocators) of two arrays. No elements are copied or moved.*/
+		void swap(TArray& other) noexcept
+		{
+			std::swap(static_cast<Allocator&>(*this), static_cast<Allocator&>(other));
+			std::swap(mData, other.mData);
+			std::swap(mCapacity, other.mCapacity);
+			std::swap(mSize, other.mSize);
+		}
+
+		/*! Copies another array. As with the copy constructor, the array is left empty if there isn't enough memory */
+		TArray& operator=(const TArray& other)
+		{
+			if (this!=&other)
+				this->setTo(other);
+			return *this;
+		}
+
+		/*! Releases the current contents, and takes the memory and allocator of the other array.*/
+		TArray& operator=(TArray&& other) noexcept
+		{
+			if (this!=&other)
+			{
+				TArray tmp(std::move(other));
+				swap(tmp);
+			}
+			return *this;
+		}
+
+		bool operator<(const TArray& other) const
+		{
+			// Not really the same behaviour as in std::vector
+			return this->size() < other.size();
+		}
+
+	private:
+		using Base::mData;
+		using Base::mCapacity;
+		using Base::mSize;
+
+		void init(long initialCapacity)
+		{
+			// Don't allow capacity 0, otherwise we would have a NULL pointer, and iterators wouldn't work
+			if (initialCapacity>0)
+			{
+				setCapacity(initialCapacity);
 			}
 		}
 
 		// Can be used to grow or shrink the allocated memory
-		void setCapacity(int newCapacity)
+		// Returns false if the allocator failed, in which case the array is left untouched
+		bool setCapacity(int newCapacity)
 		{
 			CZ_ASSERT(newCapacity>=mSize);
 
+			if (newCapacity==mCapacity)
+			{
+				return true;
+			}
+
 			void* pNew = NULL;
 
-			if (newCapacity)
+			if (newCapacity==0)
 			{
-				pNew = malloc(newCapacity*sizeof(Type));
-#if CZ_DEBUG
-				memset(pNew, 0xCD, sizeof(Type)*newCapacity);
-#endif
-				_moveToNewMemory(pNew, &eleAt(0), mSize);
+				Allocator::deallocate(mData, mCapacity*sizeof(Type));
+			}
+			else if (TIsTriviallyRelocatable<Type>::value && mData)
+			{
+				// The allocator can resize in place if possible, and even if it can't, it doesn't need to keep the old and
+				// new blocks around while the elements are moved one by one.
+				pNew = Allocator::reallocate(mData, mCapacity*sizeof(Type), newCapacity*sizeof(Type));
+				if (!pNew)
+				{
+					return false;
+				}
+			}
+			else
+			{
+				pNew = Allocator::allocate(newCapacity*sizeof(Type));
+				if (!pNew)
+				{
+					return false;
+				}
+
+				if (mData)
+				{
+					this->_moveToNewMemory(pNew, this->ptrToEleAt(0), mSize);
+					Allocator::deallocate(mData, mCapacity*sizeof(Type));
+				}
 			}
 
-			if (mData)
+#if CZ_DEBUG
+			// Only the unused part, since the elements are already there
+			if (newCapacity>mSize)
 			{
-				free(mData);
+				memset(reinterpret_cast<char*>(pNew)+sizeof(Type)*mSize, 0xCD, sizeof(Type)*(newCapacity-mSize));
 			}
+#endif
 
 			mData = pNew;
 			mCapacity = newCapacity;
+			return true;
 		}
 
-		bool grow(int newCapacity)
+		// Grows the array according to the growth policy, so it has space for at least "required" elements
+		bool growFor(int required)
 		{
-			// This is needed because because if we construct the array with initial capacity 0,
-			// then we end up calling this function with nNewCapaticy 0
-			if (newCapacity==0)
-				newCapacity = 16;
+			CZ_ASSERT(required>mCapacity);
+			return setCapacity(GrowthPolicy::calcCapacity(mCapacity, required));
+		}
+	};
+
+	template<typename Type, typename Allocator, typename GrowthPolicy>
+	void swap(TArray<Type, Allocator, GrowthPolicy>& a, TArray<Type, Allocator, GrowthPolicy>& b) noexcept
+	{
+		a.swap(b);
+	}
+
+	/*! TArray doesn't point to itself, so it can be memcpy'd to a new location as long as its allocator can. */
+	template<typename Type, typename Allocator, typename GrowthPolicy>
+	struct TIsTriviallyRelocatable<TArray<Type, Allocator, GrowthPolicy>> : std::is_trivially_copyable<Allocator>
+	{
+	};
+
+	/*! Dynamic array that keeps the first N elements inline, and only allocates memory once it grows past that.
+	Has the same interface as TArray.
+	\tparam Type Element type
+	\tparam N How many elements fit in the inline storage
+	\tparam Allocator Where the memory comes from once the array doesn't fit in the inline storage. See Allocator.h
+	*/
+	template<typename Type, int N, typename Allocator = MallocAllocator>
+	class TInlineArray : public TGrowableArray<Type, TInlineArray<Type, N, Allocator>>, private Allocator
+	{
+		using Base = TGrowableArray<Type, TInlineArray>;
+		friend Base;
+
+	public:
+		static_assert(N>0, "TInlineArray needs space for at least 1 element");
+
+		TInlineArray()
+		{
+			init();
+		}
+
+		/*! Constructor
+		\param allocator Allocator to use
+		*/
+		explicit TInlineArray(const Allocator& allocator)
+			: Allocator(allocator)
+		{
+			init();
+		}
+
+		/*! Construct the array, copying from another array. The allocator is copied too.
+		If there isn't enough memory for all the elements, the array is left empty.
+		*/
+		TInlineArray(const TInlineArray& other)
+			: Allocator(other.getAllocator())
+		{
+			init();
+			this->setTo(other);
+		}
+
+		/*! Construct the array, taking the contents of another array.
+		If the other array is using the heap, its memory is taken. Otherwise the elements are moved.
+		The other array is left empty.
+		*/
+		TInlineArray(TInlineArray&& other) noexcept(std::is_nothrow_move_constructible<Type>::value)
+			: Allocator(std::move(static_cast<Allocator&>(other)))
+		{
+			init();
+			takeFrom(other);
+		}
+
+		~TInlineArray()
+		{
+			this->clear();
+			if (!isInline())
+			{
+				Allocator::deallocate(mData, mCapacity*sizeof(Type));
+			}
+		}
+
+		/*! Returns the allocator used by the array */
+		const Allocator& getAllocator() const
+		{
+			return *this;
+		}
+
+		/*! Tells if the elements are in the inline storage */
+		bool isInline() const
+		{
+			return mData==mInline;
+		}
+
+		/*! Copies another array. As with the copy constructor, the array is left empty if there isn't enough memory */
+		TInlineArray& operator=(const TInlineArray& other)
+		{
+			if (this!=&other)
+				this->setTo(other);
+			return *this;
+		}
+
+		TInlineArray& operator=(TInlineArray&& other) noexcept(std::is_nothrow_move_constructible<Type>::value)
+		{
+			if (this!=&other)
+			{
+				this->clear();
+				if (!isInline())
+				{
+					Allocator::deallocate(mData, mCapacity*sizeof(Type));
+				}
+				init();
+				static_cast<Allocator&>(*this) = std::move(static_cast<Allocator&>(other));
+				takeFrom(other);
+			}
+			return *this;
+		}
 
-			CZ_ASSERT(newCapacity>mCapacity);
+	private:
+		using Base::mData;
+		using Base::mCapacity;
+		using Base::mSize;
 
-			setCapacity(newCapacity);
+		void init()
+		{
+			mData = mInline;
+			mCapacity = N;
+			mSize = 0;
+#if CZ_DEBUG
+			memset(mInline, 0xCD, sizeof(mInline));
+#endif
+		}
+
+		// Takes the contents of another array, leaving it empty.
+		// This array needs to be empty and using the inline storage.
+		void takeFrom(TInlineArray& other)
+		{
+			CZ_ASSERT(mSize==0 && isInline());
+			if (other.isInline())
+			{
+				this->_moveToNewMemory(mInline, other.ptrToEleAt(0), other.mSize);
+			}
+			else
+			{
+				mData = other.mData;
+				mCapacity = other.mCapacity;
+			}
+			mSize = other.mSize;
+
+			other.mData = other.mInline;
+			other.mCapacity = N;
+			other.mSize = 0;
+		}
+
+		// Can be used to grow or shrink the allocated memory.
+		// If the requested capacity fits in the inline storage, the elements are moved there.
+		// Returns false if the allocator failed, in which case the array is left untouched
+		bool setCapacity(int newCapacity)
+		{
+			CZ_ASSERT(newCapacity>=mSize);
+
+			void* pNew;
+			if (newCapacity<=N)
+			{
+				if (isInline())
+				{
+					return true;
+				}
+				pNew = mInline;
+				newCapacity = N;
+			}
+			else
+			{
+				pNew = Allocator::allocate(newCapacity*sizeof(Type));
+				if (!pNew)
+				{
+					return false;
+				}
+#if CZ_DEBUG
+				memset(pNew, 0xCD, sizeof(Type)*newCapacity);
+#endif
+			}
+
+			this->_moveToNewMemory(pNew, this->ptrToEleAt(0), mSize);
+			if (!isInline())
+			{
+				Allocator::deallocate(mData, mCapacity*sizeof(Type));
+			}
+
+			mData = pNew;
+			mCapacity = newCapacity;
 			return true;
 		}
 
-		void* mData;
-		int mCapacity;
-		int mSize;
+		// Doubles the capacity, or more if that's not enough for "required" elements
+		bool growFor(int required)
+		{
+			CZ_ASSERT(required>mCapacity);
+			return setCapacity(mCapacity*2>required ? mCapacity*2 : required);
+		}
+
+		alignas(Type) char mInline[sizeof(Type)*N];
 	};
 
 } // namespace cz
@@ -0,0 +1,583 @@
+/** @file */
+
+#pragma once
+
+#include "crazygaze/micromuc/czmicromuc.h"
+#include "crazygaze/micromuc/Array.h"
+#include "crazygaze/micromuc/Simd.h"
+
+namespace cz
+{
+
+	/*! Word type the bit arrays use for storage.
+	It's the native int size (16 bits on AVR, 32 bits on ARM), so __builtin_ctz works on it directly.
+	*/
+	using BitWord = unsigned int;
+	constexpr int BitsPerWord = sizeof(BitWord)*8;
+
+	/*! Iterates the indices of the set bits of a bit array, a word at a time. Words with no bits set are skipped
+	with a single check. */
+	class SetBitIterator
+	{
+	public:
+		SetBitIterator(const BitWord* words, int wordIndex, int numWords)
+			: mWords(words)
+			, mWordIndex(wordIndex)
+			, mNumWords(numWords)
+			, mCurrent(0)
+		{
+			if (mWordIndex<mNumWords)
+			{
+				mCurrent = mWords[mWordIndex];
+				skipEmptyWords();
+			}
+		}
+
+		int operator*() const
+		{
+			return mWordIndex*BitsPerWord + simd::detail::countTrailingZeros(mCurrent);
+		}
+
+		SetBitIterator& operator++()
+		{
+			// Clears the lowest set bit
+			mCurrent &= mCurrent-1;
+			skipEmptyWords();
+			return *this;
+		}
+
+		bool operator==(const SetBitIterator& other) const
+		{
+			return mWordIndex==other.mWordIndex && mCurrent==other.mCurrent;
+		}
+
+		bool operator!=(const SetBitIterator& other) const
+		{
+			return !(*this==other);
+		}
+
+	private:
+		void skipEmptyWords()
+		{
+			while (mCurrent==0 && ++mWordIndex<mNumWords)
+				mCurrent = mWords[mWordIndex];
+		}
+
+		const BitWord* mWords;
+		int mWordIndex;
+		int mNumWords;
+		BitWord mCurrent;
+	};
+
+	/*! Range to use in range based for loops, to iterate the set bits of a bit array. See TBaseBitArray::setBits */
+	struct SetBitRange
+	{
+		const BitWord* words;
+		int numWords;
+
+		SetBitIterator begin() const
+		{
+			return SetBitIterator(words, 0, numWords);
+		}
+
+		SetBitIterator end() const
+		{
+			return SetBitIterator(words, numWords, numWords);
+		}
+	};
+
+	//
+	// Base template class for bit arrays.
+	// Has all the operations, and Derived provides the storage, with:
+	//		int size() const
+	//		const BitWord* words() const
+	//		BitWord* words()
+	// The bits past size() in the last word are always 0, so operations that work with whole words (e.g: count,
+	// findFirstSet) don't need to mask them.
+	template<typename Derived>
+	class TBaseBitArray
+	{
+	public:
+
+		/*! Number of words needed for the specified number of bits */
+		static constexpr int calcNumWords(int numBits)
+		{
+			return (numBits + BitsPerWord - 1) / BitsPerWord;
+		}
+
+		/*! Returns the number of words in use */
+		int numWords() const
+		{
+			return calcNumWords(derived().size());
+		}
+
+		/*! Returns the value of the specified bit */
+		bool test(int index) const
+		{
+			CZ_ASSERT(index>=0 && index<derived().size());
+			return (derived().words()[index/BitsPerWord] >> (index%BitsPerWord)) & 1;
+		}
+
+		/*! Same as test */
+		bool operator[](int index) const
+		{
+			return test(index);
+		}
+
+		/*! Sets the specified bit to 1 */
+		void set(int index)
+		{
+			CZ_ASSERT(index>=0 && index<derived().size());
+			derived().words()[index/BitsPerWord] |= BitWord(1) << (index%BitsPerWord);
+		}
+
+		/*! Sets the specified bit to the specified value */
+		void set(int index, bool val)
+		{
+			if (val)
+				set(index);
+			else
+				clear(index);
+		}
+
+		/*! Sets the specified bit to 0 */
+		void clear(int index)
+		{
+			CZ_ASSERT(index>=0 && index<derived().size());
+			derived().words()[index/BitsPerWord] &= ~(BitWord(1) << (index%BitsPerWord));
+		}
+
+		/*! Toggles the specified bit */
+		void flip(int index)
+		{
+			CZ_ASSERT(index>=0 && index<derived().size());
+			derived().words()[index/BitsPerWord] ^= BitWord(1) << (index%BitsPerWord);
+		}
+
+		/*! Sets all the bits to 1 */
+		void setAll()
+		{
+			BitWord* words = derived().words();
+			int num = numWords();
+			for (int i=0; i<num; i++)
+				words[i] = ~BitWord(0);
+			clearUnusedBits();
+		}
+
+		/*! Sets all the bits to 0 */
+		void clearAll()
+		{
+			BitWord* words = derived().words();
+			int num = numWords();
+			for (int i=0; i<num; i++)
+				words[i] = 0;
+		}
+
+		/*! Toggles all the bits */
+		void flipAll()
+		{
+			BitWord* words = derived().words();
+			int num = numWords();
+			for (int i=0; i<num; i++)
+				words[i] = ~words[i];
+			clearUnusedBits();
+		}
+
+		/*! Returns how many bits are set */
+		int count() const
+		{
+			const BitWord* words = derived().words();
+			int num = numWords();
+			int res = 0;
+			for (int i=0; i<num; i++)
+				res += simd::detail::popCount(words[i]);
+			return res;
+		}
+
+		/*! Tells if any bit is set */
+		bool any() const
+		{
+			const BitWord* words = derived().words();
+			int num = numWords();
+			for (int i=0; i<num; i++)
+			{
+				if (words[i])
+					return true;
+			}
+			return false;
+		}
+
+		/*! Tells if no bit is set */
+		bool none() const
+		{
+			return !any();
+		}
+
+		/*! Tells if all the bits are set */
+		bool all() const
+		{
+			return findFirstClear()==-1;
+		}
+
+		/*! Returns the index of the first set bit, or -1 if there are none */
+		int findFirstSet() const
+		{
+			return findNextSet(0);
+		}
+
+		/*! Returns the index of the first set bit at or after the specified index, or -1 if there are none.
+		To iterate all the set bits, do:
+		\code
+		for (int i = bits.findFirstSet(); i!=-1; i = bits.findNextSet(i+1))
+		\endcode
+		or use setBits()
+		*/
+		int findNextSet(int index) const
+		{
+			CZ_ASSERT(index>=0);
+			if (index>=derived().size())
+				return -1;
+
+			const BitWord* words = derived().words();
+			int num = numWords();
+			int w = index/BitsPerWord;
+			// Ignore the bits before index
+			BitWord word = words[w] & (~BitWord(0) << (index%BitsPerWord));
+			while (true)
+			{
+				if (word)
+					return w*BitsPerWord + simd::detail::countTrailingZeros(word);
+				if (++w==num)
+					return -1;
+				word = words[w];
+			}
+		}
+
+		/*! Returns the index of the first bit that is not set, or -1 if all are set
+		Useful to find free slots.
+		*/
+		int findFirstClear() const
+		{
+			const BitWord* words = derived().words();
+			int num = numWords();
+			for (int w=0; w<num; w++)
+			{
+				BitWord word = ~words[w];
+				if (word)
+				{
+					int index = w*BitsPerWord + simd::detail::countTrailingZeros(word);
+					// The unused bits of the last word are 0, so they show up here
+					return index<derived().size() ? index : -1;
+				}
+			}
+			return -1;
+		}
+
+		/*! Returns a range to iterate the indices of the set bits. E.g:
+		\code
+		for (int channel : activeChannels.setBits())
+			...
+		\endcode
+		*/
+		SetBitRange setBits() const
+		{
+			return SetBitRange{derived().words(), numWords()};
+		}
+
+		/*! Bitwise AND with another array of the same size */
+		template<typename Other>
+		Derived& operator&=(const TBaseBitArray<Other>& other)
+		{
+			CZ_ASSERT(derived().size()==other.derived().size());
+			BitWord* words = derived().words();
+			const BitWord* otherWords = other.derived().words();
+			int num = numWords();
+			for (int i=0; i<num; i++)
+				words[i] &= otherWords[i];
+			return derived();
+		}
+
+		/*! Bitwise OR with another array of the same size */
+		template<typename Other>
+		Derived& operator|=(const TBaseBitArray<Other>& other)
+		{
+			CZ_ASSERT(derived().size()==other.derived().size());
+			BitWord* words = derived().words();
+			const BitWord* otherWords = other.derived().words();
+			int num = numWords();
+			for (int i=0; i<num; i++)
+				words[i] |= otherWords[i];
+			return derived();
+		}
+
+		/*! Bitwise XOR with another array of the same size */
+		template<typename Other>
+		Derived& operator^=(const TBaseBitArray<Other>& other)
+		{
+			CZ_ASSERT(derived().size()==other.derived().size());
+			BitWord* words = derived().words();
+			const BitWord* otherWords = other.derived().words();
+			int num = numWords();
+			for (int i=0; i<num; i++)
+				words[i] ^= otherWords[i];
+			return derived();
+		}
+
+		/*! Clears the bits that are set in the other array (AND NOT) */
+		template<typename Other>
+		Derived& clearBits(const TBaseBitArray<Other>& other)
+		{
+			CZ_ASSERT(derived().size()==other.derived().size());
+			BitWord* words = derived().words();
+			const BitWord* otherWords = other.derived().words();
+			int num = numWords();
+			for (int i=0; i<num; i++)
+				words[i] &= ~otherWords[i];
+			return derived();
+		}
+
+		template<typename Other>
+		bool operator==(const TBaseBitArray<Other>& other) const
+		{
+			if (derived().size()!=other.derived().size())
+				return false;
+			const BitWord* words = derived().words();
+			const BitWord* otherWords = other.derived().words();
+			int num = numWords();
+			for (int i=0; i<num; i++)
+			{
+				if (words[i]!=otherWords[i])
+					return false;
+			}
+			return true;
+		}
+
+		template<typename Other>
+		bool operator!=(const TBaseBitArray<Other>& other) const
+		{
+			return !(*this==other);
+		}
+
+	protected:
+
+		template<typename> friend class TBaseBitArray;
+
+		const Derived& derived() const
+		{
+			return static_cast<const Derived&>(*this);
+		}
+
+		Derived& derived()
+		{
+			return static_cast<Derived&>(*this);
+		}
+
+		// Sets the bits past size() in the last word to 0
+		void clearUnusedBits()
+		{
+			int used = derived().size()%BitsPerWord;
+			if (used)
+				derived().words()[numWords()-1] &= ~(~BitWord(0) << used);
+		}
+	};
+
+	/*! Fixed size bit array.
+	Uses 1 bit per element, instead of the 1 byte a bool uses. E.g, for 64 channels:
+	\code
+	cz::TStaticBitArray<64> active;
+	active.set(3);
+	for (int channel : active.setBits())
+		...
+	\endcode
+	All bits start as 0.
+	*/
+	template<int Size>
+	class TStaticBitArray : public TBaseBitArray<TStaticBitArray<Size>>
+	{
+		using Base = TBaseBitArray<TStaticBitArray<Size>>;
+
+	public:
+
+		static_assert(Size>0, "TStaticBitArray needs at least 1 bit");
+
+		enum
+		{
+			SIZE = Size,
+			NUM_WORDS = Base::calcNumWords(Size)
+		};
+
+		TStaticBitArray()
+		{
+		}
+
+		/*! Number of bits */
+		static constexpr int size()
+		{
+			return Size;
+		}
+
+		/*! Direct access to the words, for operations not covered by the class.
+		Bit i is bit (i%BitsPerWord) of word (i/BitsPerWord). The bits past size() in the last word must be left as 0.
+		*/
+		const BitWord* words() const
+		{
+			return mWords;
+		}
+
+		BitWord* words()
+		{
+			return mWords;
+		}
+
+	private:
+		BitWord mWords[NUM_WORDS] = {};
+	};
+
+	/*! Bit array that can grow.
+	Same operations as TStaticBitArray, plus resizing. All new bits start as 0.
+	\tparam Allocator Where the memory comes from. See TArray
+	*/
+	template<typename Allocator = MallocAllocator>
+	class TBitArray : public TBaseBitArray<TBitArray<Allocator>>
+	{
+		using Base = TBaseBitArray<TBitArray<Allocator>>;
+
+	public:
+
+		TBitArray()
+		{
+		}
+
+		/*! Constructor
+		\param allocator Allocator to use
+		*/
+		explicit TBitArray(const Allocator& allocator)
+			: mWords(allocator)
+		{
+		}
+
+		/*! Creates an array with the specified number of bits, all set to 0
+		Check size() to see if the memory allocation succeeded
+		*/
+		explicit TBitArray(int size, const Allocator& allocator = Allocator())
+			: mWords(allocator)
+		{
+			resize(size);
+		}
+
+		/*! Copies another array. Check size() to see if the memory allocation succeeded */
+		TBitArray(const TBitArray& other)
+			: mWords(other.mWords)
+		{
+			mSize = mWords.size()==other.mWords.size() ? other.mSize : 0;
+		}
+
+		/*! Takes the memory of the other array. The other array is left empty */
+		TBitArray(TBitArray&& other) noexcept
+			: mWords(std::move(other.mWords))
+			, mSize(other.mSize)
+		{
+			other.mSize = 0;
+		}
+
+		TBitArray& operator=(const TBitArray& other)
+		{
+			if (this!=&other)
+			{
+				mWords = other.mWords;
+				// On failure, the copy is left empty
+				mSize = mWords.size()==other.mWords.size() ? other.mSize : 0;
+			}
+			return *this;
+		}
+
+		TBitArray& operator=(TBitArray&& other) noexcept
+		{
+			if (this!=&other)
+			{
+				mWords = std::move(other.mWords);
+				mSize = other.mSize;
+				other.mSize = 0;
+			}
+			return *this;
+		}
+
+		/*! Number of bits */
+		int size() const
+		{
+			return mSize;
+		}
+
+		/*! How many bits fit without allocating more memory */
+		int capacity() const
+		{
+			return mWords.capacity()*BitsPerWord;
+		}
+
+		/*! See TStaticBitArray::words */
+		const BitWord* words() const
+		{
+			return mWords.begin();
+		}
+
+		BitWord* words()
+		{
+			return mWords.begin();
+		}
+
+		/*! Makes sure there is enough memory for the specified number of bits
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool reserve(int numBits)
+		{
+			return mWords.reserve(Base::calcNumWords(numBits));
+		}
+
+		/*! Changes the number of bits. New bits are set to 0.
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool resize(int numBits)
+		{
+			CZ_ASSERT(numBits>=0);
+			int oldNumWords = mWords.size();
+			int newNumWords = Base::calcNumWords(numBits);
+			if (newNumWords>oldNumWords)
+			{
+				if (!mWords.reserve(newNumWords))
+					return false;
+				while (mWords.size()<newNumWords)
+					mWords.push(0);
+			}
+			else
+			{
+				while (mWords.size()>newNumWords)
+					mWords.pop();
+			}
+
+			mSize = numBits;
+			this->clearUnusedBits();
+			return true;
+		}
+
+		/*! Adds a bit to the end
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool push(bool val)
+		{
+			if (mSize%BitsPerWord==0 && !mWords.push(0))
+				return false;
+			mSize++;
+			if (val)
+				this->set(mSize-1);
+			return true;
+		}
+
+		/*! Frees the memory not needed */
+		void shrink_to_fit()
+		{
+			mWords.shrink_to_fit();
+		}
+
+	private:
+		TArray<BitWord, Allocator> mWords;
+		int mSize = 0;
+	};
+
+} // namespace cz
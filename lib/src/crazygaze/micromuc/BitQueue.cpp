@@ -2,6 +2,7 @@
 #include "Logging.h"
 #include "StringUtils.h"
 #include <algorithm>
+#include <type_traits>
 #include <assert.h>
 
 #define CZ_TEST(expression) if (!(expression)) { ::cz::_doAssert(__FILENAME__, __LINE__, F(#expression)); }
@@ -35,34 +36,147 @@
 #define SET_BITS(var, H, L, val) \
 	( ZERO_BITS((var),(H),(L)) | ((val) << (L)) )
 
+// The word copy fast path relies on bit N being bit (N%8) of byte (N/8) also being bit N of a word loaded from memory
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	#define CZ_BITQUEUE_WORD_COPY 1
+#else
+	#define CZ_BITQUEUE_WORD_COPY 0
+#endif
+
 namespace cz
 {
 
 namespace
 {
 
+	// Word size used by copyBits's fast path. 64 bits on hosts, 32 bits on microcontrollers
+	using Word = std::conditional_t<(sizeof(void*) >= 8), uint64_t, uint32_t>;
+	constexpr unsigned int WORD_BITS = sizeof(Word) * 8;
+
+	/**
+	 * Reads up to 8 bits starting at any bit position.
+	 * Only touches the bytes that contain the requested bits.
+	 */
+	inline uint8_t readBits(const uint8_t* src, unsigned int pos, unsigned int numBits)
+	{
+		unsigned int idx = pos / 8;
+		unsigned int L = pos % 8;
+		unsigned int val = src[idx] >> L;
+		if (L + numBits > 8)
+		{
+			val |= static_cast<unsigned int>(src[idx + 1]) << (8 - L);
+		}
+		return static_cast<uint8_t>(val & MAKE_MASK(numBits - 1, 0));
+	}
+
+	/**
+	 * Reads WORD_BITS bits starting at any bit position.
+	 * Only touches the bytes that contain the requested bits.
+	 */
+	inline Word readWord(const uint8_t* src, unsigned int pos)
+	{
+		const uint8_t* p = src + pos / 8;
+		unsigned int L = pos % 8;
+		Word val;
+		memcpy(&val, p, sizeof(val));
+		if (L)
+		{
+			val = (val >> L) | (static_cast<Word>(p[sizeof(Word)]) << (WORD_BITS - L));
+		}
+		return val;
+	}
+
+	/**
+	 * Copies bits between two linear buffers. Bits in dst outside the destination range are preserved.
+	 *
+	 * The unaligned bits at the start of dst are written with a read-modify-write, then it copies whole words (shifting
+	 * the source as required), and then whole bytes. Any remaining bits at the end are again a read-modify-write.
+	 */
+	void copyBits(uint8_t* dst, unsigned int dstPos, const uint8_t* src, unsigned int srcPos, unsigned int numBits)
+	{
+		unsigned int L = dstPos % 8;
+		if (L && numBits)
+		{
+			unsigned int todo = std::min(numBits, 8 - L);
+			unsigned int idx = dstPos / 8;
+			dst[idx] = SET_BITS(dst[idx], L + todo - 1, L, readBits(src, srcPos, todo));
+			dstPos += todo;
+			srcPos += todo;
+			numBits -= todo;
+		}
+
+		uint8_t* d = dst + dstPos / 8;
+
+#if CZ_BITQUEUE_WORD_COPY
+		while (numBits >= WORD_BITS)
+		{
+			Word val = readWord(src, srcPos);
+			memcpy(d, &val, sizeof(val));
+			d += sizeof(val);
+			srcPos += WORD_BITS;
+			numBits -= WORD_BITS;
+		}
+#endif
+
+		while (numBits >= 8)
+		{
+			*d++ = readBits(src, srcPos, 8);
+			srcPos += 8;
+			numBits -= 8;
+		}
+
+		if (numBits)
+		{
+			*d = SET_BITS(*d, numBits - 1, 0, readBits(src, srcPos, numBits));
+		}
+	}
+
 	/**
-	 * Helper class to make it easier to write bits to a buffer
+	 * Writes the lower numBits of val into a ring of capacity bits, starting at pos, and moves pos.
+	 * Each iteration writes as many bits as fit in the current byte, so it's at most 1 + numBits/8 iterations.
 	 */
-	struct WriteHelper
+	template<typename V>
+	void writeValue(uint8_t* data, unsigned int capacity, unsigned int& pos, V val, unsigned int numBits)
 	{
-		uint8_t* ptr;
-		unsigned int pos;
-		void write(uint8_t val, unsigned int numBits)
+		while (numBits)
 		{
-			while (numBits)
+			unsigned int idx = pos / 8;
+			unsigned int L = pos % 8;
+			unsigned int todo = std::min(numBits, std::min(8 - L, capacity - pos));
+			unsigned int H = L + todo - 1;
+			data[idx] = SET_BITS(data[idx], H, L, static_cast<unsigned int>(val) & MAKE_MASK(todo - 1, 0));
+			val >>= todo;
+			numBits -= todo;
+			pos += todo;
+			if (pos == capacity)
 			{
-				unsigned int idx = pos / 8;
-				unsigned int L = pos % 8;
-				unsigned int todo = std::min(numBits, 8 - L);
-				unsigned int H = L + todo - 1;
-				ptr[idx] = SET_BITS(ptr[idx], H, L, val & BIT_MASK(todo -1, 0));
-				val >>= todo;
-				numBits -= todo;
-				pos += todo;
+				pos = 0;
 			}
 		}
-	};
+	}
+
+	template<typename V>
+	V readValue(const uint8_t* data, unsigned int capacity, unsigned int pos, unsigned int numBits)
+	{
+		V val = 0;
+		unsigned int shift = 0;
+		while (numBits)
+		{
+			unsigned int idx = pos / 8;
+			unsigned int L = pos % 8;
+			unsigned int todo = std::min(numBits, std::min(8 - L, capacity - pos));
+			unsigned int H = L + todo - 1;
+			val |= static_cast<V>(GET_BITS(data[idx], H, L)) << shift;
+			shift += todo;
+			numBits -= todo;
+			pos += todo;
+			if (pos == capacity)
+			{
+				pos = 0;
+			}
+		}
+		return val;
+	}
 
 }
 
@@ -113,13 +227,7 @@ bool FixedCapacityBitQueue::pushBits(const uint8_t* src, unsigned int numBits)
 	if (availableCapacity() < numBits)
 		return false;
 
-	while (numBits)
-	{
-		unsigned int todo = std::min(numBits, 8U);
-		pushImpl(*src, todo);
-		src++;
-		numBits -= todo;
-	}
+	pushImpl(src, numBits);
 	return true;
 }
 
@@ -141,13 +249,7 @@ void FixedCapacityBitQueue::forcePushBits(const uint8_t* src, unsigned int numBi
 		dropBits(numBits - available);
 	}
 
-	while (numBits)
-	{
-		unsigned int todo = std::min(numBits, 8U);
-		pushImpl(*src, todo);
-		src++;
-		numBits -= todo;
-	}
+	pushImpl(src, numBits);
 }
 
 void FixedCapacityBitQueue::dropBits(unsigned int numBits)
@@ -158,18 +260,24 @@ void FixedCapacityBitQueue::dropBits(unsigned int numBits)
 			numBits = s;
 	}
 
+#if CZ_BITQUEUE_ZERO_ONPOP
 	while (numBits)
 	{
 		unsigned int L = m_head % 8;
 		unsigned int todo = std::min(numBits, std::min(8 - L, m_capacity - m_head));
-#if CZ_BITQUEUE_ZERO_ONPOP
 		unsigned int idx = m_head / 8;
 		unsigned int H = L + todo - 1;
 		m_data[idx] = ZERO_BITS(m_data[idx], H, L);
-#endif
 		numBits -= todo;
 		m_head = (m_head + todo) % m_capacity;
 	};
+#else
+	m_head += numBits;
+	if (m_head >= m_capacity)
+	{
+		m_head -= m_capacity;
+	}
+#endif
 }
 
 unsigned int FixedCapacityBitQueue::pop(uint8_t* dst, unsigned int numBits)
@@ -182,22 +290,8 @@ unsigned int FixedCapacityBitQueue::pop(uint8_t* dst, unsigned int numBits)
 	}
 	ret = numBits;
 
-	WriteHelper writer{ dst, 0 };
-
-	while (numBits)
-	{
-		unsigned int idx = m_head / 8;
-		unsigned int L = m_head % 8;
-		unsigned int todo = std::min(numBits, std::min(8 - L, m_capacity - m_head));
-		unsigned int H = L + todo - 1;
-		uint8_t val = GET_BITS(m_data[idx], H, L);
-#if CZ_BITQUEUE_ZERO_ONPOP
-		m_data[idx] = ZERO_BITS(m_data[idx], H, L);
-#endif
-		writer.write(val, todo);
-		numBits -= todo;
-		m_head = (m_head + todo) % m_capacity;
-	};
+	copyOut(m_head, dst, numBits);
+	dropBits(numBits);
 
 	return ret;
 }
@@ -218,22 +312,7 @@ bool FixedCapacityBitQueue::getAtIndex(unsigned int index, uint8_t* dst, unsigne
 		return false;
 	}
 
-	WriteHelper writer{ dst, 0 };
-
-	unsigned int head = (m_head + index) % m_capacity;
-
-	while (numBits)
-	{
-		unsigned int idx = head / 8;
-		unsigned int L = head % 8;
-		unsigned int todo = std::min(numBits, std::min(8 - L, m_capacity - head));
-		unsigned int H = L + todo - 1;
-		uint8_t val = GET_BITS(m_data[idx], H, L);
-		writer.write(val, todo);
-		numBits -= todo;
-		head = (head + todo) % m_capacity;
-	};
-
+	copyOut((m_head + index) % m_capacity, dst, numBits);
 	return true;
 }
 
@@ -257,6 +336,317 @@ void FixedCapacityBitQueue::pushImpl(uint8_t val, unsigned int numBits)
 	}
 }
 
+void FixedCapacityBitQueue::pushImpl(const uint8_t* src, unsigned int numBits)
+{
+	// Up to 2 linear copies, depending if it wraps around the end of the buffer
+	unsigned int first = std::min(numBits, m_capacity - m_tail);
+	copyBits(m_data, m_tail, src, 0, first);
+	copyBits(m_data, 0, src, first, numBits - first);
+
+	m_tail += numBits;
+	if (m_tail >= m_capacity)
+	{
+		m_tail -= m_capacity;
+	}
+}
+
+void FixedCapacityBitQueue::pushValueImpl(uint32_t val, unsigned int numBits)
+{
+	writeValue(m_data, m_capacity, m_tail, val, numBits);
+}
+
+void FixedCapacityBitQueue::pushValueImpl(uint64_t val, unsigned int numBits)
+{
+	writeValue(m_data, m_capacity, m_tail, val, numBits);
+}
+
+void FixedCapacityBitQueue::readValue(unsigned int from, uint32_t& outVal, unsigned int numBits) const
+{
+	outVal = cz::readValue<uint32_t>(m_data, m_capacity, from, numBits);
+}
+
+void FixedCapacityBitQueue::readValue(unsigned int from, uint64_t& outVal, unsigned int numBits) const
+{
+	outVal = cz::readValue<uint64_t>(m_data, m_capacity, from, numBits);
+}
+
+FixedCapacityBitQueue::Cursor::Cursor(const FixedCapacityBitQueue& queue)
+	: m_queue(&queue)
+	, m_pos(queue.m_head)
+	, m_offset(0)
+{
+}
+
+unsigned int FixedCapacityBitQueue::Cursor::remaining() const
+{
+	return m_queue->size() - m_offset;
+}
+
+bool FixedCapacityBitQueue::Cursor::readBits(uint32_t& outVal, unsigned int numBits)
+{
+	CZ_ASSERT(numBits <= 32);
+	if (remaining() < numBits)
+		return false;
+
+	m_queue->readValue(m_pos, outVal, numBits);
+	advance(numBits);
+	return true;
+}
+
+bool FixedCapacityBitQueue::Cursor::skip(unsigned int numBits)
+{
+	if (remaining() < numBits)
+		return false;
+
+	advance(numBits);
+	return true;
+}
+
+bool FixedCapacityBitQueue::Cursor::match(uint32_t pattern, unsigned int numBits) const
+{
+	CZ_ASSERT(numBits >= 1 && numBits <= 32);
+	if (remaining() < numBits)
+		return false;
+
+	uint32_t val;
+	m_queue->readValue(m_pos, val, numBits);
+	uint32_t mask = numBits == 32 ? 0xFFFFFFFF : ((uint32_t(1) << numBits) - 1);
+	return val == (pattern & mask);
+}
+
+bool FixedCapacityBitQueue::Cursor::find(uint32_t pattern, unsigned int numBits)
+{
+	CZ_ASSERT(numBits >= 1 && numBits <= 32);
+	unsigned int todo = remaining();
+	if (todo < numBits)
+		return false;
+
+	uint32_t mask = numBits == 32 ? 0xFFFFFFFF : ((uint32_t(1) << numBits) - 1);
+	pattern &= mask;
+
+	// The window holds the numBits starting at the cursor, and the bit after the window is read from "next"
+	uint32_t window;
+	m_queue->readValue(m_pos, window, numBits);
+	todo -= numBits;
+	unsigned int capacity = m_queue->m_capacity;
+	const uint8_t* data = m_queue->m_data;
+	unsigned int next = m_pos + numBits;
+	if (next >= capacity)
+		next -= capacity;
+
+	while (window != pattern)
+	{
+		if (todo == 0)
+		{
+			advance(1);
+			return false;
+		}
+
+		uint32_t bit = (data[next / 8] >> (next % 8)) & 1;
+		window = (window >> 1) | (bit << (numBits - 1));
+		if (++next == capacity)
+			next = 0;
+		advance(1);
+		todo--;
+	}
+
+	return true;
+}
+
+void FixedCapacityBitQueue::Cursor::advance(unsigned int numBits)
+{
+	m_offset += numBits;
+	m_pos += numBits;
+	if (m_pos >= m_queue->m_capacity)
+		m_pos -= m_queue->m_capacity;
+}
+
+void FixedCapacityBitQueue::copyOut(unsigned int from, uint8_t* dst, unsigned int numBits) const
+{
+	unsigned int first = std::min(numBits, m_capacity - from);
+	copyBits(dst, 0, m_data, from, first);
+	copyBits(dst, first, m_data, 0, numBits - first);
+}
+
+#ifndef __AVR__
+
+//////////////////////////////////////////////////////////////////////////
+// SPSCFixedCapacityBitQueue
+//////////////////////////////////////////////////////////////////////////
+
+SPSCFixedCapacityBitQueue::SPSCFixedCapacityBitQueue(uint8_t* buffer, int capacityBits)
+{
+	CZ_ASSERT(capacityBits >= 2);
+	m_data = buffer;
+	m_capacity = capacityBits;
+	m_droppedBits.store(0, std::memory_order_relaxed);
+	clear();
+}
+
+unsigned int SPSCFixedCapacityBitQueue::sizeImpl(unsigned int head, unsigned int tail) const
+{
+	return tail >= head ? tail - head : tail + m_capacity - head;
+}
+
+bool SPSCFixedCapacityBitQueue::isEmpty() const
+{
+	return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+}
+
+unsigned int SPSCFixedCapacityBitQueue::capacity() const
+{
+	return m_capacity - 1;
+}
+
+unsigned int SPSCFixedCapacityBitQueue::size() const
+{
+	return sizeImpl(m_head.load(std::memory_order_acquire), m_tail.load(std::memory_order_acquire));
+}
+
+unsigned int SPSCFixedCapacityBitQueue::availableCapacity() const
+{
+	return (m_capacity - 1) - size();
+}
+
+unsigned int SPSCFixedCapacityBitQueue::droppedBits() const
+{
+	return m_droppedBits.load(std::memory_order_relaxed);
+}
+
+bool SPSCFixedCapacityBitQueue::reserve(unsigned int tail, unsigned int numBits)
+{
+	unsigned int available = (m_capacity - 1) - sizeImpl(m_head.load(std::memory_order_acquire), tail);
+	if (available < numBits)
+	{
+		// Only the producer writes this, so there is no need for a read-modify-write atomic operation.
+		// That's important on the Cortex-M0+, which doesn't have those.
+		m_droppedBits.store(m_droppedBits.load(std::memory_order_relaxed) + numBits, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+bool SPSCFixedCapacityBitQueue::pushBits(uint8_t bits, unsigned int numBits)
+{
+	return pushValueImpl(static_cast<uint32_t>(bits), numBits);
+}
+
+bool SPSCFixedCapacityBitQueue::pushBits(const uint8_t* src, unsigned int numBits)
+{
+	unsigned int tail = m_tail.load(std::memory_order_relaxed);
+	if (!reserve(tail, numBits))
+		return false;
+
+	unsigned int first = std::min(numBits, m_capacity - tail);
+	copyBits(m_data, tail, src, 0, first);
+	copyBits(m_data, 0, src, first, numBits - first);
+
+	tail += numBits;
+	if (tail >= m_capacity)
+	{
+		tail -= m_capacity;
+	}
+	m_tail.store(tail, std::memory_order_release);
+	return true;
+}
+
+bool SPSCFixedCapacityBitQueue::pushValueImpl(uint32_t val, unsigned int numBits)
+{
+	unsigned int tail = m_tail.load(std::memory_order_relaxed);
+	if (!reserve(tail, numBits))
+		return false;
+
+	writeValue(m_data, m_capacity, tail, val, numBits);
+	m_tail.store(tail, std::memory_order_release);
+	return true;
+}
+
+bool SPSCFixedCapacityBitQueue::pushValueImpl(uint64_t val, unsigned int numBits)
+{
+	unsigned int tail = m_tail.load(std::memory_order_relaxed);
+	if (!reserve(tail, numBits))
+		return false;
+
+	writeValue(m_data, m_capacity, tail, val, numBits);
+	m_tail.store(tail, std::memory_order_release);
+	return true;
+}
+
+unsigned int SPSCFixedCapacityBitQueue::pop(uint8_t* dst, unsigned int numBits)
+{
+	unsigned int head = m_head.load(std::memory_order_relaxed);
+	unsigned int s = sizeImpl(head, m_tail.load(std::memory_order_acquire));
+	if (s < numBits)
+		numBits = s;
+
+	unsigned int first = std::min(numBits, m_capacity - head);
+	copyBits(dst, 0, m_data, head, first);
+	copyBits(dst, first, m_data, 0, numBits - first);
+
+	dropBits(numBits);
+	return numBits;
+}
+
+bool SPSCFixedCapacityBitQueue::popValueImpl(uint32_t& outVal, unsigned int numBits)
+{
+	unsigned int head = m_head.load(std::memory_order_relaxed);
+	if (sizeImpl(head, m_tail.load(std::memory_order_acquire)) < numBits)
+		return false;
+
+	outVal = readValue<uint32_t>(m_data, m_capacity, head, numBits);
+	dropBits(numBits);
+	return true;
+}
+
+bool SPSCFixedCapacityBitQueue::popValueImpl(uint64_t& outVal, unsigned int numBits)
+{
+	unsigned int head = m_head.load(std::memory_order_relaxed);
+	if (sizeImpl(head, m_tail.load(std::memory_order_acquire)) < numBits)
+		return false;
+
+	outVal = readValue<uint64_t>(m_data, m_capacity, head, numBits);
+	dropBits(numBits);
+	return true;
+}
+
+void SPSCFixedCapacityBitQueue::dropBits(unsigned int numBits)
+{
+	unsigned int head = m_head.load(std::memory_order_relaxed);
+	unsigned int s = sizeImpl(head, m_tail.load(std::memory_order_acquire));
+	if (s < numBits)
+		numBits = s;
+
+	head += numBits;
+	if (head >= m_capacity)
+	{
+		head -= m_capacity;
+	}
+	m_head.store(head, std::memory_order_release);
+}
+
+bool SPSCFixedCapacityBitQueue::getAtIndex(unsigned int index, uint8_t* dst, unsigned int numBits) const
+{
+	unsigned int head = m_head.load(std::memory_order_relaxed);
+	if (numBits > sizeImpl(head, m_tail.load(std::memory_order_acquire)))
+	{
+		return false;
+	}
+
+	unsigned int from = (head + index) % m_capacity;
+	unsigned int first = std::min(numBits, m_capacity - from);
+	copyBits(dst, 0, m_data, from, first);
+	copyBits(dst, first, m_data, 0, numBits - first);
+	return true;
+}
+
+void SPSCFixedCapacityBitQueue::clear()
+{
+	m_tail.store(0, std::memory_order_relaxed);
+	m_head.store(0, std::memory_order_relaxed);
+}
+
+#endif // __AVR__
+
 } // namespace cz
 
 
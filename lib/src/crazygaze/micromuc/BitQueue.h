@@ -1,6 +1,10 @@
 #pragma once
 
 #include "crazygaze/micromuc/czmicromuc.h"
+#include <type_traits>
+#ifndef __AVR__
+	#include <atomic>
+#endif
 
 #ifndef CZ_BITQUEUE_ZERO_ONPOP
 	#define CZ_BITQUEUE_ZERO_ONPOP 0
@@ -94,6 +98,65 @@ public:
 	 */
 	unsigned int pop(uint8_t* dst, unsigned int numBits);
 
+	/**
+	 * Pushes the lower numBits of an integer value (up to 64 bits) into the queue
+	 * @return true on success, false if not enough free space in the queue to satisfy request
+	 */
+	template<typename T>
+	bool pushValue(T value, unsigned int numBits)
+	{
+		static_assert(std::is_integral<T>::value, "T must be an integer type");
+		CZ_ASSERT(numBits <= sizeof(T) * 8);
+		if (availableCapacity() < numBits)
+			return false;
+
+		if constexpr (sizeof(T) <= sizeof(uint32_t))
+			pushValueImpl(static_cast<uint32_t>(value), numBits);
+		else
+			pushValueImpl(static_cast<uint64_t>(value), numBits);
+		return true;
+	}
+
+	/**
+	 * Pops numBits (up to 64) into an integer value.
+	 * If T is signed, the value is sign extended from bit numBits-1.
+	 * @return true on success, false if there are not enough bits in the queue to satisfy the request
+	 */
+	template<typename T>
+	bool popValue(T& outVal, unsigned int numBits)
+	{
+		static_assert(std::is_integral<T>::value, "T must be an integer type");
+		CZ_ASSERT(numBits <= sizeof(T) * 8);
+		if (size() < numBits)
+			return false;
+
+		using U = std::conditional_t<(sizeof(T) <= sizeof(uint32_t)), uint32_t, uint64_t>;
+		U val;
+		readValue(m_head, val, numBits);
+		dropBits(numBits);
+
+		if constexpr (std::is_signed<T>::value)
+		{
+			if (numBits && numBits < sizeof(U) * 8 && ((val >> (numBits - 1)) & 1))
+				val |= ~U(0) << numBits;
+		}
+
+		outVal = static_cast<T>(val);
+		return true;
+	}
+
+	/**
+	 * Same as popValue(T&, numBits), but asserts if there are not enough bits in the queue
+	 */
+	template<typename T>
+	T popValue(unsigned int numBits)
+	{
+		T val = 0;
+		bool ret = popValue(val, numBits);
+		CZ_ASSERT(ret);
+		return val;
+	}
+
 	/**
 	 * Clears the queue
 	 */
@@ -106,10 +169,98 @@ public:
 	 */
 	bool getAtIndex(unsigned int index, uint8_t* dst, unsigned int numBits) const;
 
+	/**
+	 * Read-only cursor that walks the queue's bits in place, without copying or removing them.
+	 * Useful to scan for patterns (e.g: a sync preamble) directly in the ring buffer.
+	 * A cursor is only valid while the queue isn't modified.
+	 */
+	class Cursor
+	{
+	public:
+		explicit Cursor(const FixedCapacityBitQueue& queue);
+
+		/**
+		 * Position of the cursor, in bits from the queue's head.
+		 * E.g: Calling dropBits(cursor.position()) on the queue drops everything before the cursor.
+		 */
+		unsigned int position() const
+		{
+			return m_offset;
+		}
+
+		/**
+		 * How many bits there are from the cursor to the queue's tail
+		 */
+		unsigned int remaining() const;
+
+		/**
+		 * Reads numBits (maximum of 32) and moves the cursor forward
+		 * @return true on success, false if there are not enough bits left
+		 */
+		bool readBits(uint32_t& outVal, unsigned int numBits);
+
+		/**
+		 * Moves the cursor forward
+		 * @return true on success, false if there are not enough bits left (in which case the cursor doesn't move)
+		 */
+		bool skip(unsigned int numBits);
+
+		/**
+		 * Checks if the next numBits (maximum of 32) match the specified pattern. The cursor doesn't move.
+		 * The pattern uses the same bit order as pushValue/popValue.
+		 */
+		bool match(uint32_t pattern, unsigned int numBits) const;
+
+		/**
+		 * Moves the cursor forward until the next numBits (maximum of 32) match the pattern.
+		 * This keeps a sliding window, so it only reads 1 new bit per position.
+		 * @return true if found (the cursor is at the start of the match). If not found, returns false and the cursor
+		 * is moved to the last numBits-1 bits, since those can still be the start of a match once more bits are pushed.
+		 * If there are less than numBits bits left to start with, it returns false without moving the cursor.
+		 */
+		bool find(uint32_t pattern, unsigned int numBits);
+
+	private:
+		const FixedCapacityBitQueue* m_queue;
+		unsigned int m_pos; // position in the buffer
+		unsigned int m_offset; // position from the queue's head
+		void advance(unsigned int numBits);
+	};
+
+	/**
+	 * Returns a cursor at the queue's head
+	 */
+	Cursor cursor() const
+	{
+		return Cursor(*this);
+	}
+
 private:
 
 	void pushImpl(uint8_t val, unsigned int numBits);
 
+	/**
+	 * Writes numBits from src at the tail, and moves the tail. Assumes there is enough space.
+	 */
+	void pushImpl(const uint8_t* src, unsigned int numBits);
+
+	/**
+	 * Copies numBits starting at the specified position into dst, without removing them from the queue
+	 */
+	void copyOut(unsigned int from, uint8_t* dst, unsigned int numBits) const;
+
+	/**
+	 * Writes the lower numBits of val at the tail, and moves the tail. Assumes there is enough space.
+	 */
+	void pushValueImpl(uint32_t val, unsigned int numBits);
+	void pushValueImpl(uint64_t val, unsigned int numBits);
+
+	/**
+	 * Reads numBits starting at the specified position into outVal, without removing them from the queue
+	 */
+	void readValue(unsigned int from, uint32_t& outVal, unsigned int numBits) const;
+	void readValue(unsigned int from, uint64_t& outVal, unsigned int numBits) const;
+
 };
 
 template<unsigned int SIZE_BITS>
@@ -130,6 +281,183 @@ public:
 	}
 };
 
+#ifndef __AVR__
+
+/**
+ * Lock-free single-producer/single-consumer version of FixedCapacityBitQueue.
+ * E.g: Bits pushed from a GPIO ISR (or the other core) and popped in loop(), without masking interrupts.
+ *
+ * The producer only writes m_tail, and the consumer only writes m_head. Indexes are published with release
+ * semantics and read with acquire semantics.
+ *
+ * Overflow policy: The producer never touches the consumer's index, so there is no forcePushBits. If there isn't
+ * enough space, the push fails and the number of bits that didn't fit is added to droppedBits(). The consumer can keep
+ * the last value it saw to detect gaps.
+ *
+ * Note that bits are packed, so the consumer can be reading a byte while the producer is writing other bits of that
+ * same byte. That's fine, because the producer preserves the bits it doesn't own, and the consumer only looks at bits
+ * that were already published. For the same reason, there is no CZ_BITQUEUE_ZERO_ONPOP support, since the consumer
+ * never writes to the buffer.
+ *
+ * Rules:
+ *	- Only the producer can call pushBits/pushValue
+ *	- Only the consumer can call pop/popValue/dropBits/getAtIndex
+ *	- isEmpty/size/availableCapacity/droppedBits can be called from either side, but the result is only a snapshot
+ *	- clear is NOT thread safe
+ */
+class SPSCFixedCapacityBitQueue
+{
+public:
+
+	/**
+	 * @param buffer Buffer to use to implement the queue
+	 * @param capacity How many bits fit in the buffer. Please note that queue wastes 1 bit, so the real queue capacity
+	 * will capacity - 1
+	 */
+	SPSCFixedCapacityBitQueue(uint8_t* buffer, int capacityBits);
+
+	SPSCFixedCapacityBitQueue(const SPSCFixedCapacityBitQueue&) = delete;
+	SPSCFixedCapacityBitQueue& operator=(const SPSCFixedCapacityBitQueue&) = delete;
+
+	bool isEmpty() const;
+
+	/**
+	 * Returns capacity in bits
+	 */
+	unsigned int capacity() const;
+
+	/**
+	 * Returns the queue size in bits
+	 */
+	unsigned int size() const;
+
+	/**
+	 * Returns how many bits still available in the queue
+	 */
+	unsigned int availableCapacity() const;
+
+	/**
+	 * Total number of bits the producer failed to push because the queue was full.
+	 * It's a free running counter, so it can wrap around.
+	 */
+	unsigned int droppedBits() const;
+
+	/**
+	 * Producer side only. Pushes bits (maximum of 8) into the queue
+	 * @return true on success, false if not enough free space in the queue to satisfy request
+	 */
+	bool pushBits(uint8_t bits, unsigned int numBits);
+
+	/**
+	 * Producer side only. Pushes bits (can be more than 8 bits) into the queue
+	 * @return true on success, false if not enough free space in the queue to satisfy request
+	 */
+	bool pushBits(const uint8_t* src, unsigned int numBits);
+
+	/**
+	 * Producer side only. Same as FixedCapacityBitQueue::pushValue
+	 */
+	template<typename T>
+	bool pushValue(T value, unsigned int numBits)
+	{
+		static_assert(std::is_integral<T>::value, "T must be an integer type");
+		CZ_ASSERT(numBits <= sizeof(T) * 8);
+		if constexpr (sizeof(T) <= sizeof(uint32_t))
+			return pushValueImpl(static_cast<uint32_t>(value), numBits);
+		else
+			return pushValueImpl(static_cast<uint64_t>(value), numBits);
+	}
+
+	/**
+	 * Consumer side only. Pops an arbitrary number of bits
+	 * @return number of bits popped
+	 */
+	unsigned int pop(uint8_t* dst, unsigned int numBits);
+
+	/**
+	 * Consumer side only. Same as FixedCapacityBitQueue::popValue
+	 */
+	template<typename T>
+	bool popValue(T& outVal, unsigned int numBits)
+	{
+		static_assert(std::is_integral<T>::value, "T must be an integer type");
+		CZ_ASSERT(numBits <= sizeof(T) * 8);
+		using U = std::conditional_t<(sizeof(T) <= sizeof(uint32_t)), uint32_t, uint64_t>;
+		U val;
+		if (!popValueImpl(val, numBits))
+			return false;
+
+		if constexpr (std::is_signed<T>::value)
+		{
+			if (numBits && numBits < sizeof(U) * 8 && ((val >> (numBits - 1)) & 1))
+				val |= ~U(0) << numBits;
+		}
+
+		outVal = static_cast<T>(val);
+		return true;
+	}
+
+	/**
+	 * Consumer side only. Same as popValue(T&, numBits), but asserts if there are not enough bits in the queue
+	 */
+	template<typename T>
+	T popValue(unsigned int numBits)
+	{
+		T val = 0;
+		bool ret = popValue(val, numBits);
+		CZ_ASSERT(ret);
+		return val;
+	}
+
+	/**
+	 * Consumer side only. Drops the specified number of bits.
+	 */
+	void dropBits(unsigned int numBits);
+
+	/**
+	 * Consumer side only. Same as FixedCapacityBitQueue::getAtIndex
+	 */
+	bool getAtIndex(unsigned int index, uint8_t* dst, unsigned int numBits) const;
+
+	/**
+	 * Not thread safe
+	 */
+	void clear();
+
+protected:
+	uint8_t* m_data;
+	unsigned int m_capacity; // capacity in bits
+	// Written by the producer only
+	alignas(CZ_CACHELINE_SIZE) std::atomic<unsigned int> m_tail; // write position in bits
+	std::atomic<unsigned int> m_droppedBits;
+	// Written by the consumer only
+	alignas(CZ_CACHELINE_SIZE) std::atomic<unsigned int> m_head; // read position in bits
+
+private:
+	unsigned int sizeImpl(unsigned int head, unsigned int tail) const;
+	// Checks for space and updates m_droppedBits if there isn't enough
+	bool reserve(unsigned int tail, unsigned int numBits);
+	bool pushValueImpl(uint32_t val, unsigned int numBits);
+	bool pushValueImpl(uint64_t val, unsigned int numBits);
+	bool popValueImpl(uint32_t& outVal, unsigned int numBits);
+	bool popValueImpl(uint64_t& outVal, unsigned int numBits);
+};
+
+template<unsigned int SIZE_BITS>
+class TStaticSPSCFixedBitCapacityQueue : public SPSCFixedCapacityBitQueue
+{
+public:
+	/**
+	 * Reserve space for requested bits + 1, because SPSCFixedCapacityBitQueue wastes 1 bit
+	 */
+	uint8_t m_buffer[((SIZE_BITS+1) / 8) + (((SIZE_BITS+1) % 8) ? 1 : 0)];
+	TStaticSPSCFixedBitCapacityQueue() : SPSCFixedCapacityBitQueue(m_buffer, SIZE_BITS+1)
+	{
+	}
+};
+
+#endif // __AVR__
+
 void runBitQueueTests();
 
 } // namespace cz
@@ -0,0 +1,485 @@
+/** @file */
+
+#pragma once
+
+#include "crazygaze/micromuc/czmicromuc.h"
+#include "crazygaze/micromuc/Array.h"
+
+namespace cz
+{
+
+	/*! Array that allocates memory in fixed size chunks.
+	Growing only allocates new chunks, so existing elements are never moved, and pointers/references to them stay valid
+	until they are removed. It also means growing doesn't need memory for both the old and the new contents at the same
+	time, as TArray does.
+	Indexing is O(1), with a shift and mask.
+	Good for big append only containers (e.g: event logs).
+	\tparam Type Element type
+	\tparam ChunkSize Number of elements per chunk. Must be a power of 2
+	\tparam Allocator Where the memory comes from. See TArray
+	*/
+	template<typename Type, int ChunkSize = 64, typename Allocator = MallocAllocator>
+	class TChunkedArray : private Allocator
+	{
+		static_assert(ChunkSize>0 && (ChunkSize & (ChunkSize-1))==0, "TChunkedArray needs a power of 2 chunk size");
+
+		static constexpr int calcShift(int n)
+		{
+			return n==1 ? 0 : 1 + calcShift(n/2);
+		}
+
+		static constexpr int Shift = calcShift(ChunkSize);
+		static constexpr int Mask = ChunkSize-1;
+
+	public:
+
+		/*! Iterates the elements in order, moving to the next chunk when needed */
+		template<typename T>
+		class TIterator
+		{
+		public:
+			TIterator(Type* const* chunks, int index) : mChunks(chunks), mIndex(index)
+			{
+				mPtr = (index & Mask) ? chunks[index>>Shift] + (index & Mask) : nullptr;
+			}
+
+			T& operator*() const
+			{
+				return *get();
+			}
+
+			T* operator->() const
+			{
+				return get();
+			}
+
+			TIterator& operator++()
+			{
+				mIndex++;
+				// At the start of a chunk, the pointer is set on the next access, so we don't need to check if there is
+				// a next chunk
+				if (mIndex & Mask)
+					mPtr++;
+				else
+					mPtr = nullptr;
+				return *this;
+			}
+
+			bool operator==(const TIterator& other) const
+			{
+				return mIndex==other.mIndex;
+			}
+
+			bool operator!=(const TIterator& other) const
+			{
+				return mIndex!=other.mIndex;
+			}
+
+		private:
+			T* get() const
+			{
+				if (!mPtr)
+					mPtr = mChunks[mIndex>>Shift];
+				return mPtr;
+			}
+
+			Type* const* mChunks;
+			mutable T* mPtr;
+			int mIndex;
+		};
+
+		using Iterator = TIterator<Type>;
+		using ConstIterator = TIterator<const Type>;
+
+		TChunkedArray()
+		{
+		}
+
+		/*! Constructor
+		\param allocator Allocator to use
+		*/
+		explicit TChunkedArray(const Allocator& allocator)
+			: Allocator(allocator)
+			, mChunks(allocator)
+		{
+		}
+
+		/*! Construct the array, copying from another array. The allocator is copied too.*/
+		TChunkedArray(const TChunkedArray& other)
+			: Allocator(other.getAllocator())
+			, mChunks(other.getAllocator())
+		{
+			append(other);
+		}
+
+		/*! Construct the array, taking the chunks and allocator of another array. The other array is left empty.
+		No elements are moved.
+		*/
+		TChunkedArray(TChunkedArray&& other) noexcept
+			: Allocator(std::move(static_cast<Allocator&>(other)))
+			, mChunks(std::move(other.mChunks))
+			, mSize(other.mSize)
+		{
+			other.mSize = 0;
+		}
+
+		~TChunkedArray()
+		{
+			clear();
+			freeChunks(0);
+		}
+
+		TChunkedArray& operator=(const TChunkedArray& other)
+		{
+			if (this!=&other)
+			{
+				clear();
+				append(other);
+			}
+			return *this;
+		}
+
+		/*! Releases the current contents, and takes the chunks and allocator of the other array.*/
+		TChunkedArray& operator=(TChunkedArray&& other) noexcept
+		{
+			if (this!=&other)
+			{
+				TChunkedArray tmp(std::move(other));
+				swap(tmp);
+			}
+			return *this;
+		}
+
+		/*! Returns the allocator used by the array */
+		const Allocator& getAllocator() const
+		{
+			return *this;
+		}
+
+		/*! Swaps the contents (and allocators) of two arrays. No elements are copied or moved.*/
+		void swap(TChunkedArray& other) noexcept
+		{
+			std::swap(static_cast<Allocator&>(*this), static_cast<Allocator&>(other));
+			mChunks.swap(other.mChunks);
+			std::swap(mSize, other.mSize);
+		}
+
+		/*! \name STL compatible methods
+			@{
+		*/
+
+		Iterator begin()
+		{
+			return Iterator(mChunks.begin(), 0);
+		}
+
+		ConstIterator begin() const
+		{
+			return ConstIterator(mChunks.begin(), 0);
+		}
+
+		Iterator end()
+		{
+			return Iterator(mChunks.begin(), mSize);
+		}
+
+		ConstIterator end() const
+		{
+			return ConstIterator(mChunks.begin(), mSize);
+		}
+
+		/*! Allocates chunks if necessary, to have enough capacity for the specified number of elements
+		\return true if successful, false otherwise (e.g: Out of memory). On failure, the chunks that were allocated are
+		kept, so capacity() might still grow.
+		*/
+		bool reserve(int newcapacity)
+		{
+			int numChunks = (newcapacity + Mask) >> Shift;
+			if (numChunks<=mChunks.size())
+				return true;
+			if (!mChunks.reserve(numChunks))
+				return false;
+			while (mChunks.size()<numChunks)
+			{
+				if (!addChunk())
+					return false;
+			}
+			return true;
+		}
+
+		/*! Resizes the container to contain count elements.
+		If the current size is less than count, additional elements are appended and value initialized.
+		If the current size is greater than count, the container is reduced to its first count elements.
+		\return true if successful, false otherwise (e.g: Out of memory), in which case the elements that fit are kept
+		*/
+		bool resize(int count)
+		{
+			while (mSize<count)
+			{
+				if (!emplace_back())
+					return false;
+			}
+			while (mSize>count)
+				pop();
+			return true;
+		}
+
+		/*! Releases the chunks that are not in use */
+		void shrink_to_fit()
+		{
+			freeChunks((mSize + Mask) >> Shift);
+			mChunks.shrink_to_fit();
+		}
+
+		/*! Returns how many elements the array can contain without allocating more memory */
+		int capacity() const
+		{
+			return mChunks.size() * ChunkSize;
+		}
+
+		/*! Same as push
+		This is to improve std::vector compatibility
+		*/
+		void push_back(const Type& val)
+		{
+			push(val);
+		}
+
+		void push_back(Type&& val)
+		{
+			push(std::move(val));
+		}
+
+		/*! Remove the last element, if any */
+		void pop_back()
+		{
+			pop();
+		}
+
+		/* Appends a new element at the end of the array, constructing it in-place
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		template<typename... Args>
+		bool emplace_back(Args&&... args)
+		{
+			if (mSize==capacity() && !addChunk())
+				return false;
+
+			TArrayElementCreation<Type>::construct(ptrToEleAt(mSize), std::forward<Args>(args)...);
+			mSize++;
+			return true;
+		}
+
+		/*! Returns how many elements there are in the array */
+		int size() const
+		{
+			return mSize;
+		}
+
+		/*! Removes all elements from the array. The chunks are kept, so they can be reused */
+		void clear()
+		{
+			for (int i=0; i<mSize; i+=ChunkSize)
+			{
+				int count = mSize-i;
+				TArrayElementCreation<Type>::destroy(ptrToEleAt(i), count<ChunkSize ? count : ChunkSize);
+			}
+			mSize = 0;
+		}
+
+		const Type& front() const { return operator[](0); }
+		Type& front() { return operator[](0); }
+		const Type& back() const { return last(); }
+		Type& back() { return last(); }
+
+		/*!
+			@}
+		*/
+
+		/*! */
+		const Type& operator[](int index) const
+		{
+			CZ_ASSERT(index>=0 && index<mSize);
+			return *ptrToEleAt(index);
+		}
+
+		/*! */
+		Type& operator[](int index)
+		{
+			CZ_ASSERT(index>=0 && index<mSize);
+			return *ptrToEleAt(index);
+		}
+
+		/*! Adds a new element to the end of the array
+		Since existing elements are never moved, val can be an element of the array itself.
+		\param val Element to add
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool push(const Type& val)
+		{
+			return emplace_back(val);
+		}
+
+		bool push(Type&& val)
+		{
+			return emplace_back(std::move(val));
+		}
+
+		/*! Removes the last element, moving it to dest
+		\return true on success, false if the array was empty
+		*/
+		bool pop(Type& dest)
+		{
+			if (mSize==0)
+				return false;
+			mSize--;
+			Type* p = ptrToEleAt(mSize);
+			dest = std::move(*p);
+			TArrayElementCreation<Type>::destroy(p);
+			return true;
+		}
+
+		/*! Removes the last element from the array
+		\return true on success, false if the array was empty
+		*/
+		bool pop()
+		{
+			if (mSize==0)
+				return false;
+			mSize--;
+			TArrayElementCreation<Type>::destroy(ptrToEleAt(mSize));
+			return true;
+		}
+
+		/*! Returns a reference to the last element
+		*/
+		const Type& last() const
+		{
+			CZ_ASSERT(mSize>0);
+			return *ptrToEleAt(mSize-1);
+		}
+
+		/*! Returns a reference to the last element
+		*/
+		Type& last()
+		{
+			CZ_ASSERT(mSize>0);
+			return *ptrToEleAt(mSize-1);
+		}
+
+		/*! Finds an element
+		\param val Value to search for
+		\param destIndex Where you'll get the index at which the value was found
+		\return true if found (destIndex will contain the index), false if not found
+		\note Complexity is O(n).
+		*/
+		bool find(const Type &val, int &destIndex) const
+		{
+			for (int i=0; i<mSize; i+=ChunkSize)
+			{
+				int count = mSize-i;
+				const Type* start = ptrToEleAt(i);
+				const Type* end = start + (count<ChunkSize ? count : ChunkSize);
+				const Type* p = simd::find(start, end, val);
+				if (p!=end)
+				{
+					destIndex = i + static_cast<int>(p-start);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/*! Finds an element*/
+		bool find(const Type &val) const
+		{
+			int index;
+			return find(val, index);
+		}
+
+		/*! Removes the element at the specified index, moving the last element to its place.
+		Only the last element is moved, so pointers to any other elements stay valid.
+		*/
+		bool removeAtIndexAndFillWithLast(int index)
+		{
+			if (index<0 || index>=mSize)
+				return false;
+
+			Type* pAt = ptrToEleAt(index);
+			TArrayElementCreation<Type>::destroy(pAt);
+			if (index<mSize-1)
+				TArrayElementCreation<Type>::relocate(pAt, ptrToEleAt(mSize-1), 1);
+			mSize--;
+			return true;
+		}
+
+		/*! Appends elements from another array
+		\return true if successful, false otherwise (e.g: Out of memory). On failure, some of the elements might have
+		been added.
+		*/
+		bool append(const TChunkedArray& other)
+		{
+			if (!reserve(mSize + other.mSize))
+				return false;
+			for (const Type& val : other)
+				emplace_back(val);
+			return true;
+		}
+
+		/*! Appends elements from a C array
+		\return true if successful, false otherwise (e.g: Out of memory). On failure, some of the elements might have
+		been added.
+		*/
+		bool append(const Type* data, int count)
+		{
+			if (!reserve(mSize + count))
+				return false;
+			while (count--)
+				emplace_back(*data++);
+			return true;
+		}
+
+	private:
+
+		const Type* ptrToEleAt(int index) const
+		{
+			return mChunks[index>>Shift] + (index & Mask);
+		}
+
+		Type* ptrToEleAt(int index)
+		{
+			return mChunks[index>>Shift] + (index & Mask);
+		}
+
+		bool addChunk()
+		{
+			Type* chunk = static_cast<Type*>(Allocator::allocate(sizeof(Type)*ChunkSize));
+			if (!chunk)
+				return false;
+			if (!mChunks.push(chunk))
+			{
+				Allocator::deallocate(chunk, sizeof(Type)*ChunkSize);
+				return false;
+			}
+			return true;
+		}
+
+		// Frees all chunks from the specified one. Those chunks can't have any elements
+		void freeChunks(int first)
+		{
+			while (mChunks.size()>first)
+			{
+				Allocator::deallocate(mChunks.last(), sizeof(Type)*ChunkSize);
+				mChunks.pop();
+			}
+		}
+
+		TArray<Type*, Allocator> mChunks;
+		int mSize = 0;
+	};
+
+	template<typename Type, int ChunkSize, typename Allocator>
+	void swap(TChunkedArray<Type, ChunkSize, Allocator>& a, TChunkedArray<Type, ChunkSize, Allocator>& b) noexcept
+	{
+		a.swap(b);
+	}
+
+} // namespace cz
@@ -0,0 +1,512 @@
+/** @file */
+
+#pragma once
+
+#include "crazygaze/micromuc/czmicromuc.h"
+#include "crazygaze/micromuc/Array.h"
+
+namespace cz
+{
+
+	/*! Double ended queue that grows as needed.
+	Elements are kept in a ring buffer, so pushing/popping at both ends is amortized O(1). Unlike
+	TFixedCapacityQueue, it doesn't need to be sized up front, and unlike TArray::removeAtIndex(0), popping from the
+	front doesn't move the other elements.
+	The capacity is always a power of 2, so indexing is a mask instead of a modulo.
+	Growing relocates the elements the same way TArray does (memcpy for trivially relocatable types).
+	\tparam Type Element type
+	\tparam Allocator Where the memory comes from. See TArray
+	*/
+	template<typename Type, typename Allocator = MallocAllocator>
+	class TDeque : private Allocator
+	{
+		static constexpr int MinCapacity = 8;
+
+	public:
+
+		/*! Iterates the elements from front to back */
+		template<typename T>
+		class TIterator
+		{
+		public:
+			TIterator(T* data, int mask, int pos) : mData(data), mMask(mask), mPos(pos)
+			{
+			}
+
+			T& operator*() const
+			{
+				return mData[mPos & mMask];
+			}
+
+			T* operator->() const
+			{
+				return &mData[mPos & mMask];
+			}
+
+			TIterator& operator++()
+			{
+				mPos++;
+				return *this;
+			}
+
+			bool operator==(const TIterator& other) const
+			{
+				return mPos==other.mPos;
+			}
+
+			bool operator!=(const TIterator& other) const
+			{
+				return mPos!=other.mPos;
+			}
+
+		private:
+			T* mData;
+			int mMask;
+			// Position in the ring buffer, without wrapping
+			int mPos;
+		};
+
+		using Iterator = TIterator<Type>;
+		using ConstIterator = TIterator<const Type>;
+
+		TDeque()
+		{
+		}
+
+		/*! Constructor
+		\param allocator Allocator to use
+		*/
+		explicit TDeque(const Allocator& allocator)
+			: Allocator(allocator)
+		{
+		}
+
+		/*! Construct the deque, copying from another deque. The allocator is copied too.*/
+		TDeque(const TDeque& other)
+			: Allocator(other.getAllocator())
+		{
+			append(other);
+		}
+
+		/*! Construct the deque, taking the memory and allocator of another deque. The other deque is left empty.*/
+		TDeque(TDeque&& other) noexcept
+			: Allocator(std::move(static_cast<Allocator&>(other)))
+			, mData(other.mData)
+			, mCapacity(other.mCapacity)
+			, mHead(other.mHead)
+			, mSize(other.mSize)
+		{
+			other.mData = nullptr;
+			other.mCapacity = 0;
+			other.mHead = 0;
+			other.mSize = 0;
+		}
+
+		~TDeque()
+		{
+			clear();
+			setCapacity(0);
+		}
+
+		TDeque& operator=(const TDeque& other)
+		{
+			if (this!=&other)
+			{
+				clear();
+				append(other);
+			}
+			return *this;
+		}
+
+		/*! Releases the current contents, and takes the memory and allocator of the other deque.*/
+		TDeque& operator=(TDeque&& other) noexcept
+		{
+			if (this!=&other)
+			{
+				TDeque tmp(std::move(other));
+				swap(tmp);
+			}
+			return *this;
+		}
+
+		/*! Returns the allocator used by the deque */
+		const Allocator& getAllocator() const
+		{
+			return *this;
+		}
+
+		/*! Swaps the contents (and allocators) of two deques. No elements are copied or moved.*/
+		void swap(TDeque& other) noexcept
+		{
+			std::swap(static_cast<Allocator&>(*this), static_cast<Allocator&>(other));
+			std::swap(mData, other.mData);
+			std::swap(mCapacity, other.mCapacity);
+			std::swap(mHead, other.mHead);
+			std::swap(mSize, other.mSize);
+		}
+
+		/*! Returns how many elements there are in the deque */
+		int size() const
+		{
+			return mSize;
+		}
+
+		/*! Returns how many elements the deque can contain without allocating more memory */
+		int capacity() const
+		{
+			return mCapacity;
+		}
+
+		bool isEmpty() const
+		{
+			return mSize==0;
+		}
+
+		/*! Grows the deque if necessary, to have enough capacity for the specified number of elements.
+		The capacity is rounded up to a power of 2.
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool reserve(int newcapacity)
+		{
+			if (newcapacity>mCapacity)
+				return setCapacity(roundUpCapacity(newcapacity));
+			return true;
+		}
+
+		/*! Reduces the capacity to the smallest power of 2 that fits all the elements */
+		void shrink_to_fit()
+		{
+			setCapacity(mSize ? roundUpCapacity(mSize) : 0);
+		}
+
+		/*! \name STL compatible methods
+			@{
+		*/
+
+		Iterator begin()
+		{
+			return Iterator(mData, mCapacity-1, mHead);
+		}
+
+		ConstIterator begin() const
+		{
+			return ConstIterator(mData, mCapacity-1, mHead);
+		}
+
+		Iterator end()
+		{
+			return Iterator(mData, mCapacity-1, mHead+mSize);
+		}
+
+		ConstIterator end() const
+		{
+			return ConstIterator(mData, mCapacity-1, mHead+mSize);
+		}
+
+		/*! Same as pushBack */
+		void push_back(const Type& val)
+		{
+			emplace_back(val);
+		}
+
+		void push_back(Type&& val)
+		{
+			emplace_back(std::move(val));
+		}
+
+		/*! Same as pushFront */
+		void push_front(const Type& val)
+		{
+			emplace_front(val);
+		}
+
+		void push_front(Type&& val)
+		{
+			emplace_front(std::move(val));
+		}
+
+		/*! Remove the last element, if any */
+		void pop_back()
+		{
+			popBack();
+		}
+
+		/*! Remove the first element, if any */
+		void pop_front()
+		{
+			popFront();
+		}
+
+		/*! Adds a new element at the back, constructing it in-place
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		template<typename... Args>
+		bool emplace_back(Args&&... args)
+		{
+			if (mSize==mCapacity)
+			{
+				// The arguments can be references to elements of the deque itself, so the element needs to be created
+				// before growing
+				return emplaceAndGrow<false>(Type(std::forward<Args>(args)...));
+			}
+
+			TArrayElementCreation<Type>::construct(ptrToEleAt(mSize), std::forward<Args>(args)...);
+			mSize++;
+			return true;
+		}
+
+		/*! Adds a new element at the front, constructing it in-place
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		template<typename... Args>
+		bool emplace_front(Args&&... args)
+		{
+			if (mSize==mCapacity)
+				return emplaceAndGrow<true>(Type(std::forward<Args>(args)...));
+
+			int head = (mHead-1) & (mCapacity-1);
+			TArrayElementCreation<Type>::construct(mData+head, std::forward<Args>(args)...);
+			mHead = head;
+			mSize++;
+			return true;
+		}
+
+		/*! Removes all elements. The memory is kept, so it can be reused */
+		void clear()
+		{
+			if (mSize)
+			{
+				int firstSize = firstSpanSize();
+				TArrayElementCreation<Type>::destroy(mData+mHead, firstSize);
+				if (mSize>firstSize)
+					TArrayElementCreation<Type>::destroy(mData, mSize-firstSize);
+			}
+			mHead = 0;
+			mSize = 0;
+		}
+
+		const Type& front() const { return operator[](0); }
+		Type& front() { return operator[](0); }
+		const Type& back() const { return operator[](mSize-1); }
+		Type& back() { return operator[](mSize-1); }
+
+		/*!
+			@}
+		*/
+
+		/*! Access an element, where 0 is the front */
+		const Type& operator[](int index) const
+		{
+			CZ_ASSERT(index>=0 && index<mSize);
+			return *ptrToEleAt(index);
+		}
+
+		/*! Access an element, where 0 is the front */
+		Type& operator[](int index)
+		{
+			CZ_ASSERT(index>=0 && index<mSize);
+			return *ptrToEleAt(index);
+		}
+
+		/*! Adds a new element at the back
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool pushBack(const Type& val)
+		{
+			return emplace_back(val);
+		}
+
+		bool pushBack(Type&& val)
+		{
+			return emplace_back(std::move(val));
+		}
+
+		/*! Adds a new element at the front
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool pushFront(const Type& val)
+		{
+			return emplace_front(val);
+		}
+
+		bool pushFront(Type&& val)
+		{
+			return emplace_front(std::move(val));
+		}
+
+		/*! Removes the first element, moving it to dest
+		\return true on success, false if the deque was empty
+		*/
+		bool popFront(Type& dest)
+		{
+			if (mSize==0)
+				return false;
+			dest = std::move(mData[mHead]);
+			return popFront();
+		}
+
+		/*! Removes the first element
+		\return true on success, false if the deque was empty
+		*/
+		bool popFront()
+		{
+			if (mSize==0)
+				return false;
+			TArrayElementCreation<Type>::destroy(mData+mHead);
+			mHead = (mHead+1) & (mCapacity-1);
+			mSize--;
+			return true;
+		}
+
+		/*! Removes the last element, moving it to dest
+		\return true on success, false if the deque was empty
+		*/
+		bool popBack(Type& dest)
+		{
+			if (mSize==0)
+				return false;
+			dest = std::move(*ptrToEleAt(mSize-1));
+			return popBack();
+		}
+
+		/*! Removes the last element
+		\return true on success, false if the deque was empty
+		*/
+		bool popBack()
+		{
+			if (mSize==0)
+				return false;
+			mSize--;
+			TArrayElementCreation<Type>::destroy(ptrToEleAt(mSize));
+			return true;
+		}
+
+		/*! Finds an element
+		\param val Value to search for
+		\param destIndex Where you'll get the index at which the value was found (0 is the front)
+		\return true if found (destIndex will contain the index), false if not found
+		\note Complexity is O(n).
+		*/
+		bool find(const Type& val, int& destIndex) const
+		{
+			if (mSize==0)
+				return false;
+
+			// The elements are in up to two contiguous parts, so search each one with no wrapping
+			int firstSize = firstSpanSize();
+			const Type* start = mData+mHead;
+			const Type* p = simd::find(start, start+firstSize, val);
+			if (p!=start+firstSize)
+			{
+				destIndex = static_cast<int>(p-start);
+				return true;
+			}
+
+			const Type* end = mData + (mSize-firstSize);
+			p = simd::find(static_cast<const Type*>(mData), end, val);
+			if (p!=end)
+			{
+				destIndex = firstSize + static_cast<int>(p-mData);
+				return true;
+			}
+
+			return false;
+		}
+
+		/*! Finds an element*/
+		bool find(const Type& val) const
+		{
+			int index;
+			return find(val, index);
+		}
+
+		/*! Appends all the elements of another deque to the back
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool append(const TDeque& other)
+		{
+			if (!reserve(mSize+other.mSize))
+				return false;
+			int count = other.mSize; // In case other is this
+			for (int i=0; i<count; i++)
+				emplace_back(other[i]);
+			return true;
+		}
+
+	private:
+
+		static int roundUpCapacity(int count)
+		{
+			int res = MinCapacity;
+			while (res<count)
+				res *= 2;
+			return res;
+		}
+
+		// Number of elements from the head to the end of the buffer (or the end of the deque, if it doesn't wrap)
+		int firstSpanSize() const
+		{
+			int toEnd = mCapacity-mHead;
+			return mSize<toEnd ? mSize : toEnd;
+		}
+
+		const Type* ptrToEleAt(int index) const
+		{
+			return mData + ((mHead+index) & (mCapacity-1));
+		}
+
+		Type* ptrToEleAt(int index)
+		{
+			return mData + ((mHead+index) & (mCapacity-1));
+		}
+
+		template<bool Front>
+		bool emplaceAndGrow(Type&& val)
+		{
+			if (!setCapacity(mCapacity ? mCapacity*2 : MinCapacity))
+				return false;
+			if constexpr (Front)
+				return emplace_front(std::move(val));
+			else
+				return emplace_back(std::move(val));
+		}
+
+		// Moves the elements to a new buffer, with the head at 0
+		bool setCapacity(int newCapacity)
+		{
+			CZ_ASSERT(newCapacity>=mSize);
+			CZ_ASSERT((newCapacity & (newCapacity-1))==0);
+			if (newCapacity==mCapacity)
+				return true;
+
+			Type* newData = nullptr;
+			if (newCapacity)
+			{
+				newData = static_cast<Type*>(Allocator::allocate(sizeof(Type)*newCapacity));
+				if (!newData)
+					return false;
+			}
+
+			if (newData && mSize)
+			{
+				int firstSize = firstSpanSize();
+				TArrayElementCreation<Type>::relocate(newData, mData+mHead, firstSize);
+				TArrayElementCreation<Type>::relocate(newData+firstSize, mData, mSize-firstSize);
+			}
+
+			if (mData)
+				Allocator::deallocate(mData, sizeof(Type)*mCapacity);
+
+			mData = newData;
+			mCapacity = newCapacity;
+			mHead = 0;
+			return true;
+		}
+
+		Type* mData = nullptr;
+		int mCapacity = 0;
+		int mHead = 0;
+		int mSize = 0;
+	};
+
+	template<typename Type, typename Allocator>
+	void swap(TDeque<Type, Allocator>& a, TDeque<Type, Allocator>& b) noexcept
+	{
+		a.swap(b);
+	}
+
+} // namespace cz
@@ -0,0 +1,349 @@
+/** @file */
+
+#pragma once
+
+#include "crazygaze/micromuc/czmicromuc.h"
+#include "crazygaze/micromuc/Array.h"
+#include <algorithm>
+#include <functional>
+
+namespace cz
+{
+
+	namespace detail
+	{
+		/*! Common code for TFlatSet and TFlatMap.
+		Keeps the elements sorted by key in contiguous storage, so lookups are a binary search over a plain array, without
+		any allocations or pointer chasing.
+		\tparam Key Key type
+		\tparam Entry What is stored in the array
+		\tparam GetKey Functor that returns the key of an entry
+		\tparam Compare Strict weak ordering for the keys
+		\tparam Storage Array type to use for the entries (e.g: TArray or TStaticArray with TrackUsedSize=true)
+		*/
+		template<typename Key, typename Entry, typename GetKey, typename Compare, typename Storage>
+		class TFlatContainer
+		{
+		public:
+
+			/*! Number of elements */
+			int size() const
+			{
+				return mEntries.size();
+			}
+
+			/*! Tells if there are no elements */
+			bool empty() const
+			{
+				return mEntries.size()==0;
+			}
+
+			/*! How many elements fit without allocating more memory. For static storage, that's the maximum size */
+			int capacity() const
+			{
+				return mEntries.capacity();
+			}
+
+			/*! Removes all elements */
+			void clear()
+			{
+				mEntries.clear();
+			}
+
+			/*! Iteration, in key order */
+			const Entry* begin() const
+			{
+				return mEntries.begin();
+			}
+
+			const Entry* end() const
+			{
+				return mEntries.end();
+			}
+
+			/*! Access by index, in key order */
+			const Entry& operator[](int index) const
+			{
+				return mEntries[index];
+			}
+
+			/*! Tells if the key exists */
+			bool contains(const Key& key) const
+			{
+				return indexOf(key)!=-1;
+			}
+
+			/*! Returns the index of the specified key, or -1 if it doesn't exist */
+			int indexOf(const Key& key) const
+			{
+				int index = lowerBound(key);
+				return isMatch(index, key) ? index : -1;
+			}
+
+			/*! Returns the index of the first element whose key is not less than the specified key.
+			This is the index where the key would be inserted if it doesn't exist.
+			*/
+			int lowerBound(const Key& key) const
+			{
+				const Entry* data = mEntries.begin();
+				unsigned lo = 0;
+				unsigned hi = static_cast<unsigned>(mEntries.size());
+				while (lo<hi)
+				{
+					unsigned mid = (lo+hi)/2;
+					if (mCompare(GetKey()(data[mid]), key))
+						lo = mid+1;
+					else
+						hi = mid;
+				}
+				return static_cast<int>(lo);
+			}
+
+			/*! Removes the element with the specified key
+			\return true if the key existed, false otherwise
+			*/
+			bool erase(const Key& key)
+			{
+				int index = indexOf(key);
+				if (index==-1)
+					return false;
+				mEntries.removeAtIndex(index);
+				return true;
+			}
+
+			/*! Removes all the elements for which pred returns true
+			\return number of elements removed
+			*/
+			template<typename Pred>
+			int eraseIf(Pred pred)
+			{
+				return mEntries.eraseIf(pred);
+			}
+
+			/*! Sorts the elements added with addUnsorted, and removes duplicates.
+			This should be called once after adding all the elements, before doing any lookups.
+			If there are duplicate keys, the first one added is kept.
+			This is a binary insertion sort, since std::stable_sort allocates a temporary buffer. It does O(n log n)
+			comparisons, but up to O(n^2) element moves, so it is fast for the sizes that fit in a microcontroller's
+			memory, and for elements that are added mostly in order.
+			*/
+			void sort()
+			{
+				Entry* first = mEntries.begin();
+				Entry* last = mEntries.end();
+				if (first==last)
+					return;
+
+				auto less = [this](const Entry& a, const Entry& b)
+				{
+					return mCompare(GetKey()(a), GetKey()(b));
+				};
+
+				for (Entry* it = first+1; it!=last; ++it)
+				{
+					if (!less(*it, *(it-1)))
+						continue;
+
+					// Inserting after any equal keys keeps the sort stable
+					Entry tmp(std::move(*it));
+					Entry* pos = std::upper_bound(first, it, tmp, less);
+					std::move_backward(pos, it, it+1);
+					*pos = std::move(tmp);
+				}
+
+				Entry* newLast = std::unique(first, last, [this](const Entry& a, const Entry& b)
+				{
+					return !mCompare(GetKey()(a), GetKey()(b));
+				});
+				mEntries.eraseRange(static_cast<int>(newLast-first), static_cast<int>(last-newLast));
+			}
+
+			/*! Tells if the elements are sorted. Only useful for asserts/tests */
+			bool isSorted() const
+			{
+				for (int i=1; i<mEntries.size(); i++)
+				{
+					if (!mCompare(GetKey()(mEntries[i-1]), GetKey()(mEntries[i])))
+						return false;
+				}
+				return true;
+			}
+
+		protected:
+
+			bool isMatch(int index, const Key& key) const
+			{
+				return index<mEntries.size() && !mCompare(key, GetKey()(mEntries[index]));
+			}
+
+			Storage mEntries;
+			Compare mCompare;
+		};
+
+		template<typename Key>
+		struct TFlatSetGetKey
+		{
+			const Key& operator()(const Key& key) const
+			{
+				return key;
+			}
+		};
+
+		template<typename Entry>
+		struct TFlatMapGetKey
+		{
+			const typename Entry::KeyType& operator()(const Entry& entry) const
+			{
+				return entry.key;
+			}
+		};
+	}
+
+	/*! Sorted set of keys, in contiguous storage.
+	Lookups are O(log n) binary searches, and inserts/erases O(n), so this is meant for small to medium sets that are
+	searched a lot more than they are modified (e.g: lookup tables).
+	To build a big set, use addUnsorted for all the keys, followed by a single sort().
+	\tparam Key Key type
+	\tparam Compare Strict weak ordering for the keys
+	\tparam Storage Array type to use (e.g: TArray or TStaticArray with TrackUsedSize=true). See TStaticFlatSet
+	*/
+	template<typename Key, typename Compare = std::less<Key>, typename Storage = TArray<Key>>
+	class TFlatSet : public detail::TFlatContainer<Key, Key, detail::TFlatSetGetKey<Key>, Compare, Storage>
+	{
+	public:
+
+		/*! Inserts a key, keeping the set sorted
+		\return true if inserted, false if the key already exists or there is no space
+		*/
+		bool insert(const Key& key)
+		{
+			int index = this->lowerBound(key);
+			if (this->isMatch(index, key))
+				return false;
+			return this->mEntries.insertAtIndex(index, key);
+		}
+
+		/*! Returns a pointer to the key in the set, or nullptr if not found */
+		const Key* find(const Key& key) const
+		{
+			int index = this->indexOf(key);
+			return index==-1 ? nullptr : &this->mEntries[index];
+		}
+
+		/*! Adds a key to the end, without keeping the set sorted.
+		Once all keys are added, sort() needs to be called before any lookups.
+		\return false if there is no space
+		*/
+		bool addUnsorted(const Key& key)
+		{
+			return this->mEntries.push(key);
+		}
+
+		/*! Replaces the contents with the specified keys
+		\return false if there is no space
+		*/
+		bool assign(const Key* keys, int count)
+		{
+			this->mEntries.clear();
+			if (!this->mEntries.insertRange(0, keys, count))
+				return false;
+			this->sort();
+			return true;
+		}
+	};
+
+	/*! TFlatSet with a fixed capacity, so it never allocates memory */
+	template<typename Key, int N, typename Compare = std::less<Key>>
+	using TStaticFlatSet = TFlatSet<Key, Compare, TStaticArray<Key, N, true>>;
+
+	/*! Key/value pair stored by TFlatMap */
+	template<typename K, typename V>
+	struct TFlatMapEntry
+	{
+		using KeyType = K;
+		K key;
+		V value;
+	};
+
+	/*! Sorted key/value map, in contiguous storage.
+	Lookups are O(log n) binary searches, and inserts/erases O(n), so this is meant for small to medium maps that are
+	searched a lot more than they are modified (e.g: lookup tables).
+	To build a big map, use addUnsorted for all the entries, followed by a single sort().
+	\tparam Key Key type
+	\tparam Value Value type
+	\tparam Compare Strict weak ordering for the keys
+	\tparam Storage Array type to use (e.g: TArray or TStaticArray with TrackUsedSize=true). See TStaticFlatMap
+	*/
+	template<typename Key, typename Value, typename Compare = std::less<Key>,
+		typename Storage = TArray<TFlatMapEntry<Key, Value>>>
+	class TFlatMap : public detail::TFlatContainer<Key, TFlatMapEntry<Key, Value>,
+		detail::TFlatMapGetKey<TFlatMapEntry<Key, Value>>, Compare, Storage>
+	{
+	public:
+		using Entry = TFlatMapEntry<Key, Value>;
+
+		/*! Inserts a new key/value pair, keeping the map sorted
+		\return true if inserted, false if the key already exists or there is no space
+		*/
+		bool insert(const Key& key, const Value& value)
+		{
+			int index = this->lowerBound(key);
+			if (this->isMatch(index, key))
+				return false;
+			return this->mEntries.insertAtIndex(index, Entry{key, value});
+		}
+
+		/*! Sets the value for the specified key, inserting it if it doesn't exist
+		\return false if the key didn't exist and there is no space
+		*/
+		bool set(const Key& key, const Value& value)
+		{
+			int index = this->lowerBound(key);
+			if (this->isMatch(index, key))
+			{
+				this->mEntries[index].value = value;
+				return true;
+			}
+			return this->mEntries.insertAtIndex(index, Entry{key, value});
+		}
+
+		/*! Returns a pointer to the value of the specified key, or nullptr if not found */
+		Value* find(const Key& key)
+		{
+			int index = this->indexOf(key);
+			return index==-1 ? nullptr : &this->mEntries[index].value;
+		}
+
+		const Value* find(const Key& key) const
+		{
+			int index = this->indexOf(key);
+			return index==-1 ? nullptr : &this->mEntries[index].value;
+		}
+
+		/*! Adds an entry to the end, without keeping the map sorted.
+		Once all entries are added, sort() needs to be called before any lookups.
+		\return false if there is no space
+		*/
+		bool addUnsorted(const Key& key, const Value& value)
+		{
+			return this->mEntries.push(Entry{key, value});
+		}
+
+		/*! Replaces the contents with the specified entries
+		\return false if there is no space
+		*/
+		bool assign(const Entry* entries, int count)
+		{
+			this->mEntries.clear();
+			if (!this->mEntries.insertRange(0, entries, count))
+				return false;
+			this->sort();
+			return true;
+		}
+	};
+
+	/*! TFlatMap with a fixed capacity, so it never allocates memory */
+	template<typename Key, typename Value, int N, typename Compare = std::less<Key>>
+	using TStaticFlatMap = TFlatMap<Key, Value, Compare, TStaticArray<TFlatMapEntry<Key, Value>, N, true>>;
+
+} // namespace cz
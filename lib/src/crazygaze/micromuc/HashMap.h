@@ -0,0 +1,516 @@
+/** @file */
+
+#pragma once
+
+#include "crazygaze/micromuc/czmicromuc.h"
+#include "crazygaze/micromuc/Array.h"
+#include "crazygaze/micromuc/FNVHash.h"
+#include <string.h>
+#include <type_traits>
+
+namespace cz
+{
+
+	/*! Default hash functor for the hash maps.
+	Integral, enum and pointer keys are hashed with FNV-1a over their bytes.
+	Other key types need a specialization.
+	*/
+	template<typename K>
+	struct THash
+	{
+		static_assert(std::is_integral<K>::value || std::is_enum<K>::value || std::is_pointer<K>::value,
+			"Specialize cz::THash for this key type");
+
+		uint32_t operator()(const K& key) const
+		{
+			return Hash::fnv_32a_buf(const_cast<K*>(&key), sizeof(K));
+		}
+	};
+
+	/*! C strings are hashed by contents. This gives the same values as the _fnv1a literals */
+	template<>
+	struct THash<const char*>
+	{
+		uint32_t operator()(const char* key) const
+		{
+			return Hash::fnv_32a_str(key);
+		}
+	};
+
+	/*! For keys that are already hashes (e.g: "some_command"_fnv1a) */
+	struct IdentityHash
+	{
+		uint32_t operator()(uint32_t key) const
+		{
+			return key;
+		}
+	};
+
+	/*! Default key comparison functor for the hash maps */
+	template<typename K>
+	struct TKeyEqual
+	{
+		bool operator()(const K& a, const K& b) const
+		{
+			return a==b;
+		}
+	};
+
+	/*! C strings are compared by contents */
+	template<>
+	struct TKeyEqual<const char*>
+	{
+		bool operator()(const char* a, const char* b) const
+		{
+			return strcmp(a, b)==0;
+		}
+	};
+
+	/*! Key/value pair stored by the hash maps */
+	template<typename K, typename V>
+	struct THashMapEntry
+	{
+		K key;
+		V value;
+	};
+
+	namespace detail
+	{
+		/*! Open addressing hash table with linear probing, used by TStaticHashMap and THashMap.
+		Removing an element shifts back the elements that follow it in the same cluster, so there are no tombstones,
+		and lookups never get slower because of removed elements.
+		The slots are provided by the derived class. The number of slots must be a power of 2.
+		*/
+		template<typename K, typename V, typename Hasher, typename KeyEqual>
+		class THashTable
+		{
+		public:
+			using Entry = THashMapEntry<K, V>;
+
+			/*! Slot of the table. A hash of 0 means the slot is empty */
+			struct Slot
+			{
+				uint32_t hash;
+				alignas(Entry) unsigned char data[sizeof(Entry)];
+
+				Entry& entry()
+				{
+					return *reinterpret_cast<Entry*>(data);
+				}
+
+				const Entry& entry() const
+				{
+					return *reinterpret_cast<const Entry*>(data);
+				}
+			};
+
+			/*! Iterates the entries of the table, in no particular order */
+			template<typename SlotType, typename EntryType>
+			class TIterator
+			{
+			public:
+				TIterator(SlotType* slot, SlotType* end) : mSlot(slot), mEnd(end)
+				{
+					skipEmpty();
+				}
+
+				EntryType& operator*() const
+				{
+					return mSlot->entry();
+				}
+
+				EntryType* operator->() const
+				{
+					return &mSlot->entry();
+				}
+
+				TIterator& operator++()
+				{
+					mSlot++;
+					skipEmpty();
+					return *this;
+				}
+
+				bool operator==(const TIterator& other) const
+				{
+					return mSlot==other.mSlot;
+				}
+
+				bool operator!=(const TIterator& other) const
+				{
+					return mSlot!=other.mSlot;
+				}
+
+			private:
+				void skipEmpty()
+				{
+					while (mSlot!=mEnd && mSlot->hash==0)
+						mSlot++;
+				}
+
+				SlotType* mSlot;
+				SlotType* mEnd;
+			};
+
+			using Iterator = TIterator<Slot, Entry>;
+			using ConstIterator = TIterator<const Slot, const Entry>;
+
+			THashTable(const THashTable&) = delete;
+			THashTable& operator=(const THashTable&) = delete;
+
+			Iterator begin()
+			{
+				return Iterator(mSlots, mSlots+capacity());
+			}
+
+			Iterator end()
+			{
+				return Iterator(mSlots+capacity(), mSlots+capacity());
+			}
+
+			ConstIterator begin() const
+			{
+				return ConstIterator(mSlots, mSlots+capacity());
+			}
+
+			ConstIterator end() const
+			{
+				return ConstIterator(mSlots+capacity(), mSlots+capacity());
+			}
+
+			/*! Number of elements */
+			int size() const
+			{
+				return mSize;
+			}
+
+			/*! Tells if there are no elements */
+			bool empty() const
+			{
+				return mSize==0;
+			}
+
+			/*! Number of slots */
+			int capacity() const
+			{
+				return mSlots ? static_cast<int>(mMask+1) : 0;
+			}
+
+			/*! Returns a pointer to the value of the specified key, or nullptr if not found */
+			V* find(const K& key)
+			{
+				int index = findIndex(key, calcHash(key));
+				return index==-1 ? nullptr : &mSlots[index].entry().value;
+			}
+
+			const V* find(const K& key) const
+			{
+				int index = findIndex(key, calcHash(key));
+				return index==-1 ? nullptr : &mSlots[index].entry().value;
+			}
+
+			/*! Tells if the key exists */
+			bool contains(const K& key) const
+			{
+				return findIndex(key, calcHash(key))!=-1;
+			}
+
+			/*! Removes the specified key
+			\return true if the key existed, false otherwise
+			*/
+			bool erase(const K& key)
+			{
+				int index = findIndex(key, calcHash(key));
+				if (index==-1)
+					return false;
+				eraseAt(static_cast<unsigned>(index));
+				return true;
+			}
+
+			/*! Removes all elements */
+			void clear()
+			{
+				for (unsigned i=0; mSize && i<=mMask; i++)
+				{
+					if (mSlots[i].hash)
+					{
+						TArrayElementCreation<Entry>::destroy(&mSlots[i].entry());
+						mSlots[i].hash = 0;
+						mSize--;
+					}
+				}
+			}
+
+		protected:
+
+			THashTable() = default;
+
+			~THashTable()
+			{
+				clear();
+			}
+
+			static uint32_t calcHash(const K& key)
+			{
+				uint32_t hash = Hasher()(key);
+				// 0 is used to mark empty slots
+				return hash ? hash : 1;
+			}
+
+			int findIndex(const K& key, uint32_t hash) const
+			{
+				if (!mSlots)
+					return -1;
+
+				unsigned index = hash & mMask;
+				for (unsigned n=0; n<=mMask; n++)
+				{
+					const Slot& slot = mSlots[index];
+					if (slot.hash==0)
+						return -1;
+					if (slot.hash==hash && KeyEqual()(slot.entry().key, key))
+						return static_cast<int>(index);
+					index = (index+1) & mMask;
+				}
+				return -1;
+			}
+
+			// Finds the first empty slot for the specified hash. The table can't be full.
+			Slot& findEmpty(uint32_t hash)
+			{
+				CZ_ASSERT(mSize<capacity());
+				unsigned index = hash & mMask;
+				while (mSlots[index].hash)
+					index = (index+1) & mMask;
+				return mSlots[index];
+			}
+
+			// Constructs an entry in an empty slot. The key can't exist already.
+			template<typename KK, typename VV>
+			V& emplaceNew(uint32_t hash, KK&& key, VV&& value)
+			{
+				Slot& slot = findEmpty(hash);
+				new(slot.data) Entry{std::forward<KK>(key), std::forward<VV>(value)};
+				slot.hash = hash;
+				mSize++;
+				return slot.entry().value;
+			}
+
+			void eraseAt(unsigned index)
+			{
+				TArrayElementCreation<Entry>::destroy(&mSlots[index].entry());
+				mSlots[index].hash = 0;
+				mSize--;
+
+				// Shift back any elements in the same cluster that can be closer to their ideal slot
+				unsigned hole = index;
+				unsigned next = index;
+				while (true)
+				{
+					next = (next+1) & mMask;
+					Slot& slot = mSlots[next];
+					if (slot.hash==0)
+						break;
+
+					// If the ideal slot is cyclically in (hole, next], the element needs to stay where it is
+					unsigned ideal = slot.hash & mMask;
+					bool stays = hole<=next ? (ideal>hole && ideal<=next) : (ideal>hole || ideal<=next);
+					if (!stays)
+					{
+						TArrayElementCreation<Entry>::relocate(&mSlots[hole].entry(), &slot.entry(), 1);
+						mSlots[hole].hash = slot.hash;
+						slot.hash = 0;
+						hole = next;
+					}
+				}
+			}
+
+			// Moves all the entries to another set of slots (which must be empty), and starts using those.
+			void moveTo(Slot* slots, unsigned numSlots)
+			{
+				CZ_ASSERT((numSlots & (numSlots-1))==0);
+				Slot* oldSlots = mSlots;
+				unsigned oldNumSlots = oldSlots ? mMask+1 : 0;
+				int oldSize = mSize;
+
+				mSlots = slots;
+				mMask = numSlots-1;
+				mSize = 0;
+				for (unsigned i=0; i<oldNumSlots; i++)
+				{
+					Slot& src = oldSlots[i];
+					if (src.hash)
+					{
+						Slot& dst = findEmpty(src.hash);
+						TArrayElementCreation<Entry>::relocate(&dst.entry(), &src.entry(), 1);
+						dst.hash = src.hash;
+						src.hash = 0;
+						mSize++;
+					}
+				}
+				CZ_ASSERT(mSize==oldSize);
+			}
+
+			Slot* mSlots = nullptr;
+			unsigned mMask = 0;
+			int mSize = 0;
+		};
+	}
+
+	/*! Fixed capacity hash map that doesn't allocate any memory.
+	Uses open addressing with linear probing, and no tombstones.
+	\tparam K Key type
+	\tparam V Value type
+	\tparam N Number of slots. Must be a power of 2. The map can get completely full, but lookups get slower the
+		fuller it is, so ideally N should be around 30% bigger than the number of elements.
+	\tparam Hasher Hash functor. See THash, IdentityHash
+	\tparam KeyEqual Key comparison functor
+	*/
+	template<typename K, typename V, int N, typename Hasher = THash<K>, typename KeyEqual = TKeyEqual<K>>
+	class TStaticHashMap : public detail::THashTable<K, V, Hasher, KeyEqual>
+	{
+		using Super = detail::THashTable<K, V, Hasher, KeyEqual>;
+	public:
+		static_assert(N>0 && (N & (N-1))==0, "TStaticHashMap needs a power of 2 number of slots");
+
+		TStaticHashMap()
+		{
+			for (int i=0; i<N; i++)
+				mBuffer[i].hash = 0;
+			this->mSlots = mBuffer;
+			this->mMask = N-1;
+		}
+
+		~TStaticHashMap()
+		{
+			// Needs to be done here, because the slots are destroyed before the base class destructor runs
+			this->clear();
+		}
+
+		/*! Inserts a new key/value pair
+		\return true if inserted, false if the key already exists or the map is full
+		*/
+		bool insert(const K& key, const V& value)
+		{
+			uint32_t hash = this->calcHash(key);
+			if (this->findIndex(key, hash)!=-1 || this->mSize==N)
+				return false;
+			this->emplaceNew(hash, key, value);
+			return true;
+		}
+
+		/*! Sets the value of the specified key, inserting it if it doesn't exist
+		\return false if the key didn't exist and the map is full
+		*/
+		bool set(const K& key, const V& value)
+		{
+			uint32_t hash = this->calcHash(key);
+			int index = this->findIndex(key, hash);
+			if (index!=-1)
+			{
+				this->mSlots[index].entry().value = value;
+				return true;
+			}
+			if (this->mSize==N)
+				return false;
+			this->emplaceNew(hash, key, value);
+			return true;
+		}
+
+	private:
+		typename Super::Slot mBuffer[N];
+	};
+
+	/*! Growable hash map, with its slots in a TArray.
+	Uses open addressing with linear probing, and no tombstones. Grows (doubling the number of slots) when it gets
+	75% full.
+	\tparam K Key type
+	\tparam V Value type
+	\tparam Hasher Hash functor. See THash, IdentityHash
+	\tparam KeyEqual Key comparison functor
+	*/
+	template<typename K, typename V, typename Hasher = THash<K>, typename KeyEqual = TKeyEqual<K>>
+	class THashMap : public detail::THashTable<K, V, Hasher, KeyEqual>
+	{
+		using Super = detail::THashTable<K, V, Hasher, KeyEqual>;
+		using Slot = typename Super::Slot;
+	public:
+
+		THashMap()
+		{
+		}
+
+		~THashMap()
+		{
+			// Needs to be done here, because the slots are destroyed before the base class destructor runs
+			this->clear();
+		}
+
+		/*! Makes sure there are enough slots for the specified number of elements, without needing to grow
+		\return false if out of memory
+		*/
+		bool reserve(int count)
+		{
+			unsigned numSlots = 16;
+			while (numSlots*3 < static_cast<unsigned>(count)*4)
+				numSlots *= 2;
+			if (static_cast<int>(numSlots)<=this->capacity())
+				return true;
+			return rehash(numSlots);
+		}
+
+		/*! Inserts a new key/value pair
+		\return true if inserted, false if the key already exists or out of memory
+		*/
+		bool insert(const K& key, const V& value)
+		{
+			uint32_t hash = this->calcHash(key);
+			if (this->findIndex(key, hash)!=-1 || !growIfNeeded())
+				return false;
+			this->emplaceNew(hash, key, value);
+			return true;
+		}
+
+		/*! Sets the value of the specified key, inserting it if it doesn't exist
+		\return false if the key didn't exist and out of memory
+		*/
+		bool set(const K& key, const V& value)
+		{
+			uint32_t hash = this->calcHash(key);
+			int index = this->findIndex(key, hash);
+			if (index!=-1)
+			{
+				this->mSlots[index].entry().value = value;
+				return true;
+			}
+			if (!growIfNeeded())
+				return false;
+			this->emplaceNew(hash, key, value);
+			return true;
+		}
+
+	private:
+
+		bool growIfNeeded()
+		{
+			unsigned numSlots = static_cast<unsigned>(this->capacity());
+			if (static_cast<unsigned>(this->mSize+1)*4 <= numSlots*3)
+				return true;
+			return rehash(numSlots ? numSlots*2 : 16);
+		}
+
+		bool rehash(unsigned numSlots)
+		{
+			TArray<Slot> slots;
+			if (!slots.push(Slot(), static_cast<int>(numSlots)))
+				return false;
+
+			this->moveTo(slots.begin(), numSlots);
+			mSlotsArray = std::move(slots);
+			return true;
+		}
+
+		TArray<Slot> mSlotsArray;
+	};
+
+} // namespace cz
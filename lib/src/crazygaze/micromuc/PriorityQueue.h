@@ -0,0 +1,323 @@
+/** @file */
+
+#pragma once
+
+#include "crazygaze/micromuc/czmicromuc.h"
+#include "crazygaze/micromuc/Array.h"
+#include <functional>
+
+namespace cz
+{
+
+	/*! What TPriorityQueue stores in the heap array: the value, and the handle slot that points back to it */
+	template<typename T>
+	struct TPriorityQueueEntry
+	{
+		T value;
+		int slot;
+	};
+
+	/*! Priority queue, implemented as a binary heap in contiguous storage.
+	push/pop are O(log n), and top is O(1).
+	Unlike std::priority_queue, the element that comes out first is the one that compares as lower, so with the default
+	Compare (std::less) this is a min-heap, which is what timers/deadlines need.
+	push returns a handle that stays valid until the element is removed, which can be used to change the element's
+	priority (decreaseKey/update) or remove it, without searching for it. Handles of removed elements are reused.
+	To build a queue from many elements at once, use assign, or addUnsorted for all elements followed by a single
+	heapify(), which is O(n) instead of O(n log n).
+	\tparam Type Element type
+	\tparam Compare Strict weak ordering. Compare(a,b) returns true if a should come out before b
+	\tparam HeapStorage Array type for the heap (e.g: TArray or TStaticArray with TrackUsedSize=true).
+		See TStaticPriorityQueue
+	\tparam SlotStorage Array type for the handle slots. Same as HeapStorage, but for ints
+	*/
+	template<typename Type, typename Compare = std::less<Type>,
+		typename HeapStorage = TArray<TPriorityQueueEntry<Type>>, typename SlotStorage = TArray<int>>
+	class TPriorityQueue
+	{
+	public:
+
+		using Entry = TPriorityQueueEntry<Type>;
+		using Handle = int;
+		static constexpr Handle InvalidHandle = -1;
+
+		TPriorityQueue()
+		{
+		}
+
+		explicit TPriorityQueue(const Compare& compare)
+			: mCompare(compare)
+		{
+		}
+
+		/*! Number of elements */
+		int size() const
+		{
+			return mHeap.size();
+		}
+
+		/*! Tells if there are no elements */
+		bool empty() const
+		{
+			return mHeap.size()==0;
+		}
+
+		/*! How many elements fit without allocating more memory. For static storage, that's the maximum size */
+		int capacity() const
+		{
+			return mHeap.capacity();
+		}
+
+		/*! Removes all elements. All existing handles become invalid */
+		void clear()
+		{
+			mHeap.clear();
+			mSlots.clear();
+			mFreeHead = -1;
+		}
+
+		/*! Returns the element that comes out first */
+		const Type& top() const
+		{
+			CZ_ASSERT(mHeap.size());
+			return mHeap[0].value;
+		}
+
+		/*! Returns the handle of the element that comes out first */
+		Handle topHandle() const
+		{
+			CZ_ASSERT(mHeap.size());
+			return mHeap[0].slot;
+		}
+
+		/*! Adds an element
+		\return Handle to the element, or InvalidHandle if there is no space
+		*/
+		Handle push(const Type& val)
+		{
+			Handle handle = addUnsorted(val);
+			if (handle!=InvalidHandle)
+				siftUp(mHeap.size()-1);
+			return handle;
+		}
+
+		/*! Removes the element that comes out first
+		\return true on success, false if the queue was empty
+		*/
+		bool pop()
+		{
+			if (mHeap.size()==0)
+				return false;
+			removeAt(0);
+			return true;
+		}
+
+		/*! Removes the element that comes out first, moving it to dest
+		\return true on success, false if the queue was empty
+		*/
+		bool pop(Type& dest)
+		{
+			if (mHeap.size()==0)
+				return false;
+			dest = std::move(mHeap[0].value);
+			removeAt(0);
+			return true;
+		}
+
+		/*! Tells if the handle refers to an element in the queue.
+		Since handles are reused, this is only meaningful for handles that were not removed yet, or InvalidHandle.
+		*/
+		bool contains(Handle handle) const
+		{
+			return handle>=0 && handle<mSlots.size() && mSlots[handle]>=0;
+		}
+
+		/*! Returns the element with the specified handle */
+		const Type& get(Handle handle) const
+		{
+			CZ_ASSERT(contains(handle));
+			return mHeap[mSlots[handle]].value;
+		}
+
+		/*! Changes an element to a value that comes out earlier (or the same), and moves it towards the top
+		This is O(log n).
+		*/
+		void decreaseKey(Handle handle, const Type& val)
+		{
+			CZ_ASSERT(contains(handle));
+			int pos = mSlots[handle];
+			CZ_ASSERT(!mCompare(mHeap[pos].value, val));
+			mHeap[pos].value = val;
+			siftUp(pos);
+		}
+
+		/*! Changes the value of an element, moving it up or down as needed. This is O(log n) */
+		void update(Handle handle, const Type& val)
+		{
+			CZ_ASSERT(contains(handle));
+			int pos = mSlots[handle];
+			mHeap[pos].value = val;
+			fixAt(pos);
+		}
+
+		/*! Removes the element with the specified handle
+		\return true if the element existed, false otherwise
+		*/
+		bool remove(Handle handle)
+		{
+			if (!contains(handle))
+				return false;
+			removeAt(mSlots[handle]);
+			return true;
+		}
+
+		/*! Adds an element without keeping the heap order.
+		heapify() needs to be called before using top/pop/decreaseKey/update/remove.
+		\return Handle to the element, or InvalidHandle if there is no space
+		*/
+		Handle addUnsorted(const Type& val)
+		{
+			// Get a slot first, so nothing needs to be undone if adding to the heap fails
+			if (mFreeHead==-1)
+			{
+				if (!mSlots.push(encodeFree(-1)))
+					return InvalidHandle;
+				mFreeHead = mSlots.size()-1;
+			}
+
+			Handle handle = mFreeHead;
+			if (!mHeap.push(Entry{val, handle}))
+				return InvalidHandle;
+			mFreeHead = decodeFree(mSlots[handle]);
+			mSlots[handle] = mHeap.size()-1;
+			return handle;
+		}
+
+		/*! Restores the heap order after using addUnsorted. This is O(n) */
+		void heapify()
+		{
+			for (int pos = mHeap.size()/2 - 1; pos>=0; pos--)
+				siftDown(pos);
+		}
+
+		/*! Replaces the contents with the specified values.
+		The handles are the indices in the values array (values[i] gets handle i).
+		\return false if there is no space, in which case the queue is left empty
+		*/
+		bool assign(const Type* values, int count)
+		{
+			clear();
+			for (int i=0; i<count; i++)
+			{
+				if (addUnsorted(values[i])==InvalidHandle)
+				{
+					clear();
+					return false;
+				}
+			}
+			heapify();
+			return true;
+		}
+
+		/*! Iteration over the heap entries, in no particular order (apart from the first being the top) */
+		const Entry* begin() const
+		{
+			return mHeap.begin();
+		}
+
+		const Entry* end() const
+		{
+			return mHeap.end();
+		}
+
+	private:
+
+		// Free slots keep the next free slot (or -1) as a negative number, so they can be told apart from positions
+		static int encodeFree(int next)
+		{
+			return -2 - next;
+		}
+
+		static int decodeFree(int value)
+		{
+			return -2 - value;
+		}
+
+		void removeAt(int pos)
+		{
+			int slot = mHeap[pos].slot;
+			mSlots[slot] = encodeFree(mFreeHead);
+			mFreeHead = slot;
+
+			int last = mHeap.size()-1;
+			if (pos!=last)
+			{
+				mHeap[pos] = std::move(mHeap[last]);
+				mSlots[mHeap[pos].slot] = pos;
+			}
+			mHeap.pop();
+			if (pos<last)
+				fixAt(pos);
+		}
+
+		// Moves the element at the specified position up or down, to where it belongs
+		void fixAt(int pos)
+		{
+			if (pos>0 && mCompare(mHeap[pos].value, mHeap[(pos-1)/2].value))
+				siftUp(pos);
+			else
+				siftDown(pos);
+		}
+
+		// The element being moved is kept out of the heap while the others are moved into the hole, so each step is
+		// a single move instead of a swap
+		void siftUp(int pos)
+		{
+			Entry e = std::move(mHeap[pos]);
+			while (pos>0)
+			{
+				int parent = (pos-1)/2;
+				if (!mCompare(e.value, mHeap[parent].value))
+					break;
+				mHeap[pos] = std::move(mHeap[parent]);
+				mSlots[mHeap[pos].slot] = pos;
+				pos = parent;
+			}
+			mSlots[e.slot] = pos;
+			mHeap[pos] = std::move(e);
+		}
+
+		void siftDown(int pos)
+		{
+			int size = mHeap.size();
+			Entry e = std::move(mHeap[pos]);
+			while (true)
+			{
+				int child = pos*2 + 1;
+				if (child>=size)
+					break;
+				if (child+1<size && mCompare(mHeap[child+1].value, mHeap[child].value))
+					child++;
+				if (!mCompare(mHeap[child].value, e.value))
+					break;
+				mHeap[pos] = std::move(mHeap[child]);
+				mSlots[mHeap[pos].slot] = pos;
+				pos = child;
+			}
+			mSlots[e.slot] = pos;
+			mHeap[pos] = std::move(e);
+		}
+
+		HeapStorage mHeap;
+		// For each handle, the element's position in the heap, or the next free slot if not in use (see encodeFree)
+		SlotStorage mSlots;
+		int mFreeHead = -1;
+		Compare mCompare;
+	};
+
+	/*! TPriorityQueue with a fixed capacity, so it never allocates memory */
+	template<typename Type, int N, typename Compare = std::less<Type>>
+	using TStaticPriorityQueue = TPriorityQueue<Type, Compare, TStaticArray<TPriorityQueueEntry<Type>, N, true>,
+		TStaticArray<int, N, true>>;
+
+} // namespace cz
@@ -1,7 +1,18 @@
 #pragma once
 
 #include "crazygaze/micromuc/czmicromuc.h"
+#include "crazygaze/micromuc/Simd.h"
 #include <type_traits>
+#include <utility>
+#include <string.h>
+#ifdef __AVR__
+	#include <new.h>
+#else
+	#include <new>
+#endif
+#ifndef __AVR__
+	#include <atomic>
+#endif
 
 namespace cz
 {
@@ -10,13 +21,16 @@ namespace cz
  * Fixed capacity queue.
  * It expects the user to specify a buffer to use.
  * Also, it wastes 1 slot so it can detect if the queue is empty or full
+ *
+ * Elements are constructed in place when pushed, and destroyed when popped, so the buffer is treated as raw memory.
+ * If Type is not trivial, the buffer should be uninitialized memory (e.g: what TStaticFixedCapacityQueue uses), and not
+ * an array of constructed objects.
  */
 template<typename T>
 class TFixedCapacityQueue
 {
 public:
 	using Type = T;
-	static_assert(std::is_pod<Type>::value, "Type must be a POD");
 
 protected:
 	T* m_data;
@@ -40,6 +54,15 @@ public:
 		m_head = 0;
 	}
 
+	~TFixedCapacityQueue()
+	{
+		clear();
+	}
+
+	// The queue doesn't own the buffer, so copying would end up with two queues using the same buffer
+	TFixedCapacityQueue(const TFixedCapacityQueue&) = delete;
+	TFixedCapacityQueue& operator=(const TFixedCapacityQueue&) = delete;
+
 	bool isEmpty() const
 	{
 		return m_tail == m_head;
@@ -61,14 +84,29 @@ public:
 	}
 
 	bool push(const Type& val)
+	{
+		return emplace(val);
+	}
+
+	bool push(Type&& val)
+	{
+		return emplace(std::move(val));
+	}
+
+	/**
+	 * Constructs a new element in place, at the end of the queue
+	 * @return true on success, false if the queue is full
+	 */
+	template<typename... Args>
+	bool emplace(Args&&... args)
 	{
 		if (isFull())
 		{
 			return false;
 		}
 
-		m_data[m_tail] = val;
-		m_tail = (m_tail + 1) % m_capacity;
+		new (&m_data[m_tail]) Type(std::forward<Args>(args)...);
+		m_tail = wrap(m_tail + 1);
 		return true;
 	}
 
@@ -79,16 +117,18 @@ public:
 			return false;
 		}
 
-		outVal = m_data[m_head];
-		m_head = (m_head + 1) % m_capacity;
+		outVal = std::move(m_data[m_head]);
+		m_data[m_head].~Type();
+		m_head = wrap(m_head + 1);
 		return true;
 	}
 
 	Type pop()
 	{
-		Type val;
-		bool ret = pop(val);
-		CZ_ASSERT(ret);
+		CZ_ASSERT(!isEmpty());
+		Type val(std::move(m_data[m_head]));
+		m_data[m_head].~Type();
+		m_head = wrap(m_head + 1);
 		return val;
 	}
 
@@ -105,6 +145,14 @@ public:
 
 	void clear()
 	{
+		if constexpr (!std::is_trivially_destructible<Type>::value)
+		{
+			while (m_head != m_tail)
+			{
+				m_data[m_head].~Type();
+				m_head = wrap(m_head + 1);
+			}
+		}
 		m_head = m_tail = 0;
 	}
 
@@ -114,6 +162,8 @@ public:
 	 */
 	int remove(const Type& val)
 	{
+		// val can be an element of the queue itself, which can be destroyed or moved below
+		const Type key(val);
 		int count = 0;
 		int todo = size();
 		int dstIndex = m_head;
@@ -121,14 +171,20 @@ public:
 
 		while (todo--)
 		{
-			if (m_data[srcIndex] == val) {
+			if (m_data[srcIndex] == key) {
+				m_data[srcIndex].~Type();
 				count++;
 			}
 			else {
-				m_data[dstIndex] = m_data[srcIndex];
-				dstIndex = (dstIndex + 1) % m_capacity;
+				// Any slot behind srcIndex was already destroyed (or moved out of), so it's raw memory
+				if (dstIndex != srcIndex)
+				{
+					new (&m_data[dstIndex]) Type(std::move(m_data[srcIndex]));
+					m_data[srcIndex].~Type();
+				}
+				dstIndex = wrap(dstIndex + 1);
 			}
-			srcIndex = (srcIndex + 1) % m_capacity;
+			srcIndex = wrap(srcIndex + 1);
 		}
 
 		m_tail = dstIndex;
@@ -172,9 +228,359 @@ public:
 	 */
 	bool find(const Type& val) const
 	{
-		for(int i=0; i<size(); i++)
+		// The elements can wrap around the end of the buffer, so search the 2 contiguous parts separately instead of
+		// doing a modulo per element
+		int count = size();
+		int firstSize = m_capacity - m_head;
+		if (firstSize > count)
+		{
+			firstSize = count;
+		}
+
+		const Type* first = m_data + m_head;
+		if (simd::find(first, first + firstSize, val) != first + firstSize)
+		{
+			return true;
+		}
+
+		return simd::find(m_data, m_data + (count - firstSize), val) != m_data + (count - firstSize);
+	}
+
+	//
+	// Bulk operations
+	//
+
+	/**
+	 * Contiguous region of the queue's buffer
+	 */
+	struct Span
+	{
+		Type* data;
+		int size;
+	};
+
+	/**
+	 * A region of the queue can wrap around the end of the buffer, so it's represented as 2 contiguous spans.
+	 * "second" is only used if the region wraps around, and always starts at the beginning of the buffer.
+	 */
+	struct Spans
+	{
+		Span first;
+		Span second;
+
+		int size() const
+		{
+			return first.size + second.size;
+		}
+	};
+
+	/**
+	 * Pushes as many elements from src as there is space for
+	 * @return number of elements pushed
+	 */
+	int pushN(const Type* src, int count)
+	{
+		Spans spans = getSpans(m_tail, (m_capacity - 1) - size());
+		if (count > spans.size())
+		{
+			count = spans.size();
+		}
+
+		int todo = count < spans.first.size ? count : spans.first.size;
+		if constexpr (std::is_trivially_copyable<Type>::value)
+		{
+			memcpy(spans.first.data, src, todo * sizeof(Type));
+			memcpy(spans.second.data, src + todo, (count - todo) * sizeof(Type));
+		}
+		else
+		{
+			for (int i = 0; i < todo; i++)
+				new (&spans.first.data[i]) Type(src[i]);
+			for (int i = todo; i < count; i++)
+				new (&spans.second.data[i - todo]) Type(src[i]);
+		}
+		m_tail = wrap(m_tail + count);
+		return count;
+	}
+
+	/**
+	 * Pops up to count elements into dst
+	 * @return number of elements popped
+	 */
+	int popN(Type* dst, int count)
+	{
+		Spans spans = getReadableSpans();
+		if (count > spans.size())
+		{
+			count = spans.size();
+		}
+
+		int todo = count < spans.first.size ? count : spans.first.size;
+		if constexpr (std::is_trivially_copyable<Type>::value)
+		{
+			memcpy(dst, spans.first.data, todo * sizeof(Type));
+			memcpy(dst + todo, spans.second.data, (count - todo) * sizeof(Type));
+		}
+		else
+		{
+			for (int i = 0; i < todo; i++)
+				dst[i] = std::move(spans.first.data[i]);
+			for (int i = todo; i < count; i++)
+				dst[i] = std::move(spans.second.data[i - todo]);
+		}
+		commitPop(count);
+		return count;
+	}
+
+	/**
+	 * Gets the free space of the queue, so the caller can write directly into it (e.g: with memcpy or DMA).
+	 * Once the elements are written, call commitPush to add them to the queue.
+	 * Only available for trivially copyable types, since the free space is uninitialized memory.
+	 */
+	Spans getWritableSpans()
+	{
+		static_assert(std::is_trivially_copyable<Type>::value, "Type must be trivially copyable");
+		return getSpans(m_tail, (m_capacity - 1) - size());
+	}
+
+	/**
+	 * Adds to the queue count elements previously written to the spans returned by getWritableSpans
+	 */
+	void commitPush(int count)
+	{
+		static_assert(std::is_trivially_copyable<Type>::value, "Type must be trivially copyable");
+		CZ_ASSERT(count >= 0 && count <= (m_capacity - 1) - size());
+		m_tail = wrap(m_tail + count);
+	}
+
+	/**
+	 * Gets the queue's elements, so the caller can read directly from the buffer.
+	 * Once the elements are consumed, call commitPop to remove them from the queue.
+	 */
+	Spans getReadableSpans()
+	{
+		return getSpans(m_head, size());
+	}
+
+	/**
+	 * Removes count elements from the queue, after they were consumed through getReadableSpans
+	 */
+	void commitPop(int count)
+	{
+		CZ_ASSERT(count >= 0 && count <= size());
+		if constexpr (!std::is_trivially_destructible<Type>::value)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				m_data[m_head].~Type();
+				m_head = wrap(m_head + 1);
+			}
+		}
+		else
+		{
+			m_head = wrap(m_head + count);
+		}
+	}
+
+protected:
+
+	// Wraps an index in the [0, 2*m_capacity) range without a modulo
+	int wrap(int index) const
+	{
+		return index >= m_capacity ? index - m_capacity : index;
+	}
+
+	Spans getSpans(int start, int count)
+	{
+		int firstSize = m_capacity - start;
+		if (firstSize > count)
+		{
+			firstSize = count;
+		}
+		return Spans{ {m_data + start, firstSize}, {m_data, count - firstSize} };
+	}
+
+};
+
+template<typename T, int SIZE>
+class TStaticFixedCapacityQueue : public TFixedCapacityQueue<T>
+{
+public:
+	using Type = T;
+	// Using +1 because TFixedCapacityQueue wastes 1 slot.
+	// Raw memory, because elements are only constructed when pushed.
+	alignas(Type) char m_buffer[sizeof(Type) * (SIZE + 1)];
+
+	TStaticFixedCapacityQueue() : TFixedCapacityQueue<T>(reinterpret_cast<Type*>(m_buffer), SIZE + 1)
+	{
+	}
+};
+
+/**
+ * Fixed capacity queue, where the capacity is a compile time power of two.
+ *
+ * Compared to TFixedCapacityQueue, this:
+ *	- Uses masking instead of modulo (the Cortex-M0+ doesn't have a hardware divider, so a modulo is a function call)
+ *	- Uses free-running indexes, so it doesn't need to waste 1 slot to detect if the queue is full or empty.
+ *	- Owns the buffer.
+ */
+template<typename T, unsigned int SIZE>
+class TStaticPow2FixedCapacityQueue
+{
+public:
+	using Type = T;
+	static_assert(std::is_pod<Type>::value, "Type must be a POD");
+	static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+
+protected:
+	static constexpr unsigned int MASK = SIZE - 1;
+	// Indexes are never wrapped. They are only masked when accessing the buffer, and the unsigned overflow keeps
+	// "m_tail - m_head" correct.
+	unsigned int m_tail; // write position
+	unsigned int m_head; // read position
+	T m_data[SIZE];
+
+public:
+
+	TStaticPow2FixedCapacityQueue()
+	{
+		m_tail = 0;
+		m_head = 0;
+	}
+
+	bool isEmpty() const
+	{
+		return m_tail == m_head;
+	}
+
+	bool isFull() const
+	{
+		return size() == SIZE;
+	}
+
+	int size() const
+	{
+		return static_cast<int>(m_tail - m_head);
+	}
+
+	int capacity() const
+	{
+		return SIZE;
+	}
+
+	bool push(const Type& val)
+	{
+		if (isFull())
+		{
+			return false;
+		}
+
+		m_data[m_tail & MASK] = val;
+		m_tail++;
+		return true;
+	}
+
+	bool pop(Type& outVal)
+	{
+		if (isEmpty())
+		{
+			return false;
+		}
+
+		outVal = m_data[m_head & MASK];
+		m_head++;
+		return true;
+	}
+
+	Type pop()
+	{
+		Type val;
+		bool ret = pop(val);
+		CZ_ASSERT(ret);
+		return val;
+	}
+
+	bool peek(Type& outVal) const
+	{
+		if (isEmpty())
+		{
+			return false;
+		}
+
+		outVal = m_data[m_head & MASK];
+		return true;
+	}
+
+	void clear()
+	{
+		m_head = m_tail = 0;
+	}
+
+	/**
+	 * Removes from the queue all items matching the specified value
+	 * @return number of items removed
+	 */
+	int remove(const Type& val)
+	{
+		// val can be an element of the queue itself, which can be overwritten below
+		const Type key(val);
+		int count = 0;
+		unsigned int dstIndex = m_head;
+		for (unsigned int srcIndex = m_head; srcIndex != m_tail; srcIndex++)
+		{
+			if (m_data[srcIndex & MASK] == key) {
+				count++;
+			}
+			else {
+				m_data[dstIndex & MASK] = m_data[srcIndex & MASK];
+				dstIndex++;
+			}
+		}
+
+		m_tail = dstIndex;
+		return count;
+	}
+
+	const Type& getAtIndex(int index) const
+	{
+		CZ_ASSERT(index < size());
+		return m_data[(m_head + index) & MASK];
+	}
+
+	Type& getAtIndex(int index)
+	{
+		CZ_ASSERT(index < size());
+		return m_data[(m_head + index) & MASK];
+	}
+
+	const Type& front() const
+	{
+		return getAtIndex(0);
+	}
+
+	Type& front()
+	{
+		return getAtIndex(0);
+	}
+
+	const Type& back() const
+	{
+		return getAtIndex(size()-1);
+	}
+
+	Type& back()
+	{
+		return getAtIndex(size()-1);
+	}
+
+	/**
+	 * Checks if the given value is in the queue
+	 */
+	bool find(const Type& val) const
+	{
+		for (unsigned int index = m_head; index != m_tail; index++)
 		{
-			if (getAtIndex(i) == val)
+			if (m_data[index & MASK] == val)
 			{
 				return true;
 			}
@@ -184,18 +590,370 @@ public:
 
 };
 
+#ifndef __AVR__
+
+/**
+ * Lock-free single-producer/single-consumer version of TFixedCapacityQueue.
+ *
+ * One thread/core/ISR can push while another thread/core pops, without any locking or masking interrupts.
+ * The producer only ever writes m_tail, and the consumer only ever writes m_head. Each side publishes its index with
+ * release semantics and reads the other side's index with acquire semantics, so the element write (or read) is always
+ * visible before the index that covers it.
+ *
+ * Rules:
+ *	- Only the producer can call push
+ *	- Only the consumer can call pop/peek/front
+ *	- isEmpty/isFull/size can be called from either side, but the result is only a snapshot
+ *	- clear is NOT thread safe, and should only be used when neither side is using the queue
+ *
+ * Like TFixedCapacityQueue, it expects the user to specify a buffer to use, and wastes 1 slot.
+ */
+template<typename T>
+class TSPSCFixedCapacityQueue
+{
+public:
+	using Type = T;
+	static_assert(std::is_pod<Type>::value, "Type must be a POD");
+
+protected:
+	T* m_data;
+	int m_capacity;
+	// Head and tail are kept apart, so the producer and consumer don't keep fighting over the same cache line
+	alignas(CZ_CACHELINE_SIZE) std::atomic<int> m_tail; // write position. Only written by the producer
+	alignas(CZ_CACHELINE_SIZE) std::atomic<int> m_head; // read position. Only written by the consumer
+
+	// Avoids the modulo in the hot paths, since the Cortex-M0+ doesn't have a hardware divider
+	int next(int index) const
+	{
+		return (index + 1 == m_capacity) ? 0 : index + 1;
+	}
+
+public:
+
+	/**
+	 * @param buffer Buffer to use to implement the queue
+	 * @param capacity How many elements fit in the buffer. Please note that queue wastes 1 slot, so the real queue capacity
+	 * will capacity - 1
+	 */
+	TSPSCFixedCapacityQueue(Type* buffer, int capacity)
+	{
+		CZ_ASSERT(capacity > 1);
+		m_data = buffer;
+		m_capacity = capacity;
+		m_tail.store(0, std::memory_order_relaxed);
+		m_head.store(0, std::memory_order_relaxed);
+	}
+
+	TSPSCFixedCapacityQueue(const TSPSCFixedCapacityQueue&) = delete;
+	TSPSCFixedCapacityQueue& operator=(const TSPSCFixedCapacityQueue&) = delete;
+
+	bool isEmpty() const
+	{
+		return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+	}
+
+	bool isFull() const
+	{
+		return size() == m_capacity - 1;
+	}
+
+	int size() const
+	{
+		int tail = m_tail.load(std::memory_order_acquire);
+		int head = m_head.load(std::memory_order_acquire);
+		return tail >= head ? tail - head : tail + m_capacity - head;
+	}
+
+	int capacity() const
+	{
+		return m_capacity;
+	}
+
+	/**
+	 * Producer side only
+	 */
+	bool push(const Type& val)
+	{
+		int tail = m_tail.load(std::memory_order_relaxed);
+		int nextTail = next(tail);
+		if (nextTail == m_head.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		m_data[tail] = val;
+		m_tail.store(nextTail, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Consumer side only
+	 */
+	bool pop(Type& outVal)
+	{
+		int head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		outVal = m_data[head];
+		m_head.store(next(head), std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Consumer side only
+	 */
+	Type pop()
+	{
+		Type val;
+		bool ret = pop(val);
+		CZ_ASSERT(ret);
+		return val;
+	}
+
+	/**
+	 * Consumer side only
+	 */
+	bool peek(Type& outVal) const
+	{
+		int head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		outVal = m_data[head];
+		return true;
+	}
+
+	/**
+	 * Consumer side only
+	 */
+	const Type& front() const
+	{
+		CZ_ASSERT(!isEmpty());
+		return m_data[m_head.load(std::memory_order_relaxed)];
+	}
+
+	/**
+	 * Not thread safe.
+	 */
+	void clear()
+	{
+		m_tail.store(0, std::memory_order_relaxed);
+		m_head.store(0, std::memory_order_relaxed);
+	}
+
+};
+
 template<typename T, int SIZE>
-class TStaticFixedCapacityQueue : public TFixedCapacityQueue<T>
+class TStaticSPSCFixedCapacityQueue : public TSPSCFixedCapacityQueue<T>
+{
+public:
+	using Type = T;
+	Type m_buffer[SIZE + 1]; // Using +1 because TSPSCFixedCapacityQueue wastes 1 slot
+
+	TStaticSPSCFixedCapacityQueue() : TSPSCFixedCapacityQueue<T>(m_buffer, SIZE + 1)
+	{
+	}
+};
+
+/**
+ * Lock-free bounded multi-producer/multi-consumer queue.
+ *
+ * Based on Dmitry Vyukov's design (https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue).
+ * Each slot has a sequence number that tells if it's ready to be written or read for a given position, so producers
+ * and consumers only compete on the position counters (one CAS per push/pop), and never on the data.
+ *
+ * Capacity must be a power of two, and no slot is wasted.
+ *
+ * There is no peek/front, because with several consumers the peeked element could be popped (and the slot reused by a
+ * producer) while it's being read.
+ *
+ * \note On the Cortex-M0+ (RP2040) there are no exclusive load/store instructions, so the CAS is implemented by the
+ * toolchain's atomic helpers. It's still correct, but don't expect the same scaling as on a host.
+ */
+template<typename T>
+class TMPMCFixedCapacityQueue
+{
+public:
+	using Type = T;
+	static_assert(std::is_pod<Type>::value, "Type must be a POD");
+
+	struct Cell
+	{
+		std::atomic<unsigned int> sequence;
+		Type data;
+	};
+
+protected:
+	Cell* m_cells;
+	unsigned int m_mask;
+	alignas(CZ_CACHELINE_SIZE) std::atomic<unsigned int> m_enqueuePos;
+	alignas(CZ_CACHELINE_SIZE) std::atomic<unsigned int> m_dequeuePos;
+
+public:
+
+	/**
+	 * @param buffer Buffer to use to implement the queue
+	 * @param capacity How many cells fit in the buffer. Must be a power of two.
+	 */
+	TMPMCFixedCapacityQueue(Cell* buffer, int capacity)
+	{
+		CZ_ASSERT(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+		m_cells = buffer;
+		m_mask = capacity - 1;
+		clear();
+	}
+
+	TMPMCFixedCapacityQueue(const TMPMCFixedCapacityQueue&) = delete;
+	TMPMCFixedCapacityQueue& operator=(const TMPMCFixedCapacityQueue&) = delete;
+
+	/**
+	 * Only a snapshot, since other threads can be pushing/popping
+	 */
+	bool isEmpty() const
+	{
+		return size() == 0;
+	}
+
+	/**
+	 * Only a snapshot, since other threads can be pushing/popping
+	 */
+	bool isFull() const
+	{
+		return size() == capacity();
+	}
+
+	/**
+	 * Only a snapshot, since other threads can be pushing/popping
+	 */
+	int size() const
+	{
+		unsigned int dequeuePos = m_dequeuePos.load(std::memory_order_acquire);
+		unsigned int enqueuePos = m_enqueuePos.load(std::memory_order_acquire);
+		int res = static_cast<int>(enqueuePos - dequeuePos);
+		// A pop can be in progress between the two loads, making it look like there are more positions dequeued than
+		// enqueued.
+		return res < 0 ? 0 : (res > capacity() ? capacity() : res);
+	}
+
+	int capacity() const
+	{
+		return static_cast<int>(m_mask + 1);
+	}
+
+	bool push(const Type& val)
+	{
+		Cell* cell;
+		unsigned int pos = m_enqueuePos.load(std::memory_order_relaxed);
+		while(true)
+		{
+			cell = &m_cells[pos & m_mask];
+			unsigned int seq = cell->sequence.load(std::memory_order_acquire);
+			int diff = static_cast<int>(seq - pos);
+			if (diff == 0)
+			{
+				// Slot is free for this position. Try to claim it
+				if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (diff < 0)
+			{
+				// Slot still holds an element from the previous lap, so the queue is full
+				return false;
+			}
+			else
+			{
+				// Another producer claimed this position
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->data = val;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(Type& outVal)
+	{
+		Cell* cell;
+		unsigned int pos = m_dequeuePos.load(std::memory_order_relaxed);
+		while(true)
+		{
+			cell = &m_cells[pos & m_mask];
+			unsigned int seq = cell->sequence.load(std::memory_order_acquire);
+			int diff = static_cast<int>(seq - (pos + 1));
+			if (diff == 0)
+			{
+				// Slot has an element for this position. Try to claim it
+				if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (diff < 0)
+			{
+				// Slot wasn't written yet, so the queue is empty
+				return false;
+			}
+			else
+			{
+				// Another consumer claimed this position
+				pos = m_dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		outVal = cell->data;
+		// Mark the slot as free for the producers in the next lap
+		cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	Type pop()
+	{
+		Type val;
+		bool ret = pop(val);
+		CZ_ASSERT(ret);
+		return val;
+	}
+
+	/**
+	 * Not thread safe.
+	 */
+	void clear()
+	{
+		for (unsigned int i = 0; i <= m_mask; i++)
+		{
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		m_enqueuePos.store(0, std::memory_order_relaxed);
+		m_dequeuePos.store(0, std::memory_order_relaxed);
+	}
+};
+
+template<typename T, int SIZE>
+class TStaticMPMCFixedCapacityQueue : public TMPMCFixedCapacityQueue<T>
 {
 public:
 	using Type = T;
-	Type m_buffer[SIZE + 1]; // Using +1 because TFixedCapacityQueue wastes 1 slot
+	using Cell = typename TMPMCFixedCapacityQueue<T>::Cell;
+	static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+	Cell m_buffer[SIZE];
 
-	TStaticFixedCapacityQueue() : TFixedCapacityQueue<T>(m_buffer, SIZE + 1)
+	TStaticMPMCFixedCapacityQueue() : TMPMCFixedCapacityQueue<T>(m_buffer, SIZE)
 	{
+		// m_buffer is only constructed after the base class, so the sequence numbers need to be initialized again
+		this->clear();
 	}
 };
 
+#endif // __AVR__
+
 void runQueueTests();
 
 
@@ -0,0 +1,496 @@
+/** @file */
+
+#pragma once
+
+#include "crazygaze/micromuc/czmicromuc.h"
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+//
+// Implementation used by the find/count/fill kernels. This is decided at compile time, from what the compiler is
+// targeting, but can be forced by defining CZ_SIMD (e.g: -DCZ_SIMD=CZ_SIMD_SWAR).
+//
+#define CZ_SIMD_NONE 0 // Plain loops
+#define CZ_SIMD_SWAR 1 // Several elements per machine word ("SIMD within a register")
+#define CZ_SIMD_SSE2 2
+#define CZ_SIMD_AVX2 3
+#define CZ_SIMD_NEON 4 // AArch64 only
+
+#if !defined(CZ_SIMD)
+	#if defined(__AVX2__)
+		#define CZ_SIMD CZ_SIMD_AVX2
+	#elif defined(__SSE2__) || defined(_M_X64)
+		#define CZ_SIMD CZ_SIMD_SSE2
+	#elif defined(__ARM_NEON) && defined(__aarch64__)
+		#define CZ_SIMD CZ_SIMD_NEON
+	#elif defined(__AVR__) || (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+		// On 8 bits CPUs, working with words is slower than with single bytes
+		#define CZ_SIMD CZ_SIMD_NONE
+	#else
+		#define CZ_SIMD CZ_SIMD_SWAR
+	#endif
+#endif
+
+#if CZ_SIMD==CZ_SIMD_SSE2 || CZ_SIMD==CZ_SIMD_AVX2
+	#include <immintrin.h>
+#elif CZ_SIMD==CZ_SIMD_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace cz::simd
+{
+
+	/*! Tells if the kernels can work on T's bit patterns directly.
+	That is, integral, enum and pointer types, where two values are equal only if their bits are equal.
+	Other types fallback to plain loops using operator==.
+	*/
+	template<typename T>
+	struct TIsSupported : std::integral_constant<bool,
+		(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value) &&
+		(sizeof(T)==1 || sizeof(T)==2 || sizeof(T)==4 || sizeof(T)==8)>
+	{
+	};
+
+	namespace detail
+	{
+		template<int Size> struct TUInt;
+		template<> struct TUInt<1> { using Type = uint8_t; };
+		template<> struct TUInt<2> { using Type = uint16_t; };
+		template<> struct TUInt<4> { using Type = uint32_t; };
+		template<> struct TUInt<8> { using Type = uint64_t; };
+
+		template<typename T>
+		typename TUInt<sizeof(T)>::Type toBits(const T& val)
+		{
+			typename TUInt<sizeof(T)>::Type bits;
+			memcpy(&bits, &val, sizeof(T));
+			return bits;
+		}
+
+		template<typename M>
+		int countTrailingZeros(M mask)
+		{
+			return sizeof(M)>sizeof(unsigned) ? __builtin_ctzll(mask) : __builtin_ctz(static_cast<unsigned>(mask));
+		}
+
+		template<typename M>
+		int popCount(M mask)
+		{
+#if defined(__POPCNT__) || defined(__aarch64__)
+			return sizeof(M)>sizeof(unsigned) ? __builtin_popcountll(mask) : __builtin_popcount(static_cast<unsigned>(mask));
+#else
+			// Without a popcount instruction, the builtins are library calls, which are a lot slower than this
+			using U = typename TUInt<sizeof(M)>::Type;
+			constexpr U m1 = static_cast<U>(~U(0)) / 3; // 0x5555...
+			constexpr U m2 = static_cast<U>(~U(0)) / 5; // 0x3333...
+			constexpr U m4 = static_cast<U>(~U(0)) / 17; // 0x0F0F...
+			constexpr U h01 = static_cast<U>(~U(0)) / 255; // 0x0101...
+			U x = static_cast<U>(mask);
+			x = x - ((x >> 1) & m1);
+			x = (x & m2) + ((x >> 2) & m2);
+			x = (x + (x >> 4)) & m4;
+			return static_cast<int>(static_cast<U>(x * h01) >> (sizeof(U)*8 - 8));
+#endif
+		}
+
+		//
+		// Plain loops. Used for unsupported types and for the leftovers of the other implementations
+		//
+		template<typename T>
+		const T* findScalar(const T* p, const T* end, const T& val)
+		{
+			while (p<end && !(*p==val))
+				p++;
+			return p;
+		}
+
+		template<typename T>
+		int countScalar(const T* p, const T* end, const T& val)
+		{
+			int count = 0;
+			for (; p<end; p++)
+			{
+				if (*p==val)
+					count++;
+			}
+			return count;
+		}
+
+		template<typename T>
+		void fillScalar(T* p, const T& val, int count)
+		{
+			while (count--)
+				*p++ = val;
+		}
+
+		//
+		// SWAR. Compares all the elements in a machine word at once.
+		//
+		using Word = uintptr_t;
+
+		template<typename T>
+		struct TSwar
+		{
+			using Lane = typename TUInt<sizeof(T)>::Type;
+			static constexpr int LaneBits = sizeof(T)*8;
+			static constexpr int LanesPerWord = sizeof(Word)/sizeof(T);
+			// Lowest bit of each lane set (e.g: 0x01010101)
+			static constexpr Word Ones = static_cast<Word>(~Word(0)) / static_cast<Word>(Lane(~Lane(0)));
+			// All bits of each lane set, except the highest (e.g: 0x7F7F7F7F). Not used if lanes are as big as a word.
+			static constexpr Word Low = LanesPerWord>=2 ? ~(Ones << ((LaneBits-1) % (sizeof(Word)*8))) : 0;
+
+			static Word broadcast(const T& val)
+			{
+				return static_cast<Word>(toBits(val)) * Ones;
+			}
+
+			static Word load(const T* p)
+			{
+				Word w;
+				memcpy(&w, __builtin_assume_aligned(p, sizeof(Word)), sizeof(Word));
+				return w;
+			}
+
+			// Sets the highest bit of each lane that is 0, and clears all the other bits.
+			// This is exact (no false positives caused by borrows), so it can be used to count.
+			static Word zeroLanes(Word x)
+			{
+				Word y = (x & Low) + Low;
+				return ~(y | x | Low);
+			}
+
+			// Adds the values of all lanes, if the total fits in a lane (e.g: lanes that are 0 or 1)
+			// Multiplying by Ones accumulates all the lanes in the highest one
+			static int sumLanes(Word x)
+			{
+				return static_cast<int>((x * Ones) >> (sizeof(Word)*8 - LaneBits));
+			}
+
+			static bool isAligned(const void* p)
+			{
+				return (reinterpret_cast<uintptr_t>(p) & (sizeof(Word)-1))==0;
+			}
+		};
+
+		template<typename T>
+		const T* findSwar(const T* p, const T* end, const T& val)
+		{
+			using S = TSwar<T>;
+			if constexpr (S::LanesPerWord<2)
+			{
+				return findScalar(p, end, val);
+			}
+			else
+			{
+				while (p<end && !S::isAligned(p))
+				{
+					if (*p==val)
+						return p;
+					p++;
+				}
+
+				const Word pattern = S::broadcast(val);
+				for (; end-p>=S::LanesPerWord; p+=S::LanesPerWord)
+				{
+					Word zeros = S::zeroLanes(S::load(p) ^ pattern);
+					if (zeros)
+						return p + countTrailingZeros(zeros)/S::LaneBits;
+				}
+
+				return findScalar(p, end, val);
+			}
+		}
+
+		template<typename T>
+		int countSwar(const T* p, const T* end, const T& val)
+		{
+			using S = TSwar<T>;
+			if constexpr (S::LanesPerWord<2)
+			{
+				return countScalar(p, end, val);
+			}
+			else
+			{
+				int count = 0;
+				while (p<end && !S::isAligned(p))
+				{
+					if (*p==val)
+						count++;
+					p++;
+				}
+
+				const Word pattern = S::broadcast(val);
+				for (; end-p>=S::LanesPerWord; p+=S::LanesPerWord)
+					count += S::sumLanes(S::zeroLanes(S::load(p) ^ pattern) >> (S::LaneBits-1));
+
+				return count + countScalar(p, end, val);
+			}
+		}
+
+		template<typename T>
+		void fillSwar(T* p, const T& val, int count)
+		{
+			using S = TSwar<T>;
+			if constexpr (sizeof(T)==1)
+			{
+				memset(p, toBits(val), count);
+			}
+			else if constexpr (S::LanesPerWord<2)
+			{
+				fillScalar(p, val, count);
+			}
+			else
+			{
+				while (count && !S::isAligned(p))
+				{
+					*p++ = val;
+					count--;
+				}
+
+				const Word pattern = S::broadcast(val);
+				for (; count>=S::LanesPerWord; count-=S::LanesPerWord, p+=S::LanesPerWord)
+					memcpy(__builtin_assume_aligned(p, sizeof(Word)), &pattern, sizeof(Word));
+
+				fillScalar(p, val, count);
+			}
+		}
+
+		//
+		// Vector implementations.
+		// The Ops classes wrap the instructions for each instruction set, so find/count/fill are written only once.
+		// Ops::movemask returns BitsPerByte bits per byte of the vector.
+		//
+#if CZ_SIMD==CZ_SIMD_SSE2
+		struct Sse2Ops
+		{
+			using Vec = __m128i;
+			using Mask = uint32_t;
+			static constexpr int Bytes = 16;
+			static constexpr int BitsPerByte = 1;
+
+			static Vec load(const void* p) { return _mm_loadu_si128(static_cast<const Vec*>(p)); }
+			static void store(void* p, Vec v) { _mm_storeu_si128(static_cast<Vec*>(p), v); }
+			static Mask movemask(Vec v) { return static_cast<Mask>(_mm_movemask_epi8(v)); }
+
+			template<int Size, typename U>
+			static Vec broadcast(U bits)
+			{
+				if constexpr (Size==1) return _mm_set1_epi8(static_cast<char>(bits));
+				else if constexpr (Size==2) return _mm_set1_epi16(static_cast<short>(bits));
+				else if constexpr (Size==4) return _mm_set1_epi32(static_cast<int>(bits));
+				else return _mm_set1_epi64x(static_cast<long long>(bits));
+			}
+
+			template<int Size>
+			static Vec cmpeq(Vec a, Vec b)
+			{
+				if constexpr (Size==1) return _mm_cmpeq_epi8(a, b);
+				else if constexpr (Size==2) return _mm_cmpeq_epi16(a, b);
+				else if constexpr (Size==4) return _mm_cmpeq_epi32(a, b);
+				else
+				{
+					// SSE2 doesn't have 64 bits compares, so both 32 bits halves need to match
+					Vec c = _mm_cmpeq_epi32(a, b);
+					return _mm_and_si128(c, _mm_shuffle_epi32(c, _MM_SHUFFLE(2, 3, 0, 1)));
+				}
+			}
+		};
+#endif
+
+#if CZ_SIMD==CZ_SIMD_AVX2
+		struct Avx2Ops
+		{
+			using Vec = __m256i;
+			using Mask = uint32_t;
+			static constexpr int Bytes = 32;
+			static constexpr int BitsPerByte = 1;
+
+			static Vec load(const void* p) { return _mm256_loadu_si256(static_cast<const Vec*>(p)); }
+			static void store(void* p, Vec v) { _mm256_storeu_si256(static_cast<Vec*>(p), v); }
+			static Mask movemask(Vec v) { return static_cast<Mask>(_mm256_movemask_epi8(v)); }
+
+			template<int Size, typename U>
+			static Vec broadcast(U bits)
+			{
+				if constexpr (Size==1) return _mm256_set1_epi8(static_cast<char>(bits));
+				else if constexpr (Size==2) return _mm256_set1_epi16(static_cast<short>(bits));
+				else if constexpr (Size==4) return _mm256_set1_epi32(static_cast<int>(bits));
+				else return _mm256_set1_epi64x(static_cast<long long>(bits));
+			}
+
+			template<int Size>
+			static Vec cmpeq(Vec a, Vec b)
+			{
+				if constexpr (Size==1) return _mm256_cmpeq_epi8(a, b);
+				else if constexpr (Size==2) return _mm256_cmpeq_epi16(a, b);
+				else if constexpr (Size==4) return _mm256_cmpeq_epi32(a, b);
+				else return _mm256_cmpeq_epi64(a, b);
+			}
+		};
+#endif
+
+#if CZ_SIMD==CZ_SIMD_NEON
+		struct NeonOps
+		{
+			using Vec = uint8x16_t;
+			using Mask = uint64_t;
+			static constexpr int Bytes = 16;
+			static constexpr int BitsPerByte = 4;
+
+			static Vec load(const void* p) { return vld1q_u8(static_cast<const uint8_t*>(p)); }
+			static void store(void* p, Vec v) { vst1q_u8(static_cast<uint8_t*>(p), v); }
+
+			// NEON doesn't have a movemask, but narrowing each 16 bits to 8 gives 4 bits per byte
+			static Mask movemask(Vec v)
+			{
+				return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+			}
+
+			template<int Size, typename U>
+			static Vec broadcast(U bits)
+			{
+				if constexpr (Size==1) return vdupq_n_u8(static_cast<uint8_t>(bits));
+				else if constexpr (Size==2) return vreinterpretq_u8_u16(vdupq_n_u16(static_cast<uint16_t>(bits)));
+				else if constexpr (Size==4) return vreinterpretq_u8_u32(vdupq_n_u32(static_cast<uint32_t>(bits)));
+				else return vreinterpretq_u8_u64(vdupq_n_u64(static_cast<uint64_t>(bits)));
+			}
+
+			template<int Size>
+			static Vec cmpeq(Vec a, Vec b)
+			{
+				if constexpr (Size==1) return vceqq_u8(a, b);
+				else if constexpr (Size==2) return vreinterpretq_u8_u16(vceqq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+				else if constexpr (Size==4) return vreinterpretq_u8_u32(vceqq_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+				else return vreinterpretq_u8_u64(vceqq_u64(vreinterpretq_u64_u8(a), vreinterpretq_u64_u8(b)));
+			}
+		};
+#endif
+
+		template<typename Ops, typename T>
+		struct TVec
+		{
+			using Mask = typename Ops::Mask;
+			static constexpr int LanesPerVec = Ops::Bytes/sizeof(T);
+			static constexpr int BitsPerLane = sizeof(T)*Ops::BitsPerByte;
+			// One bit per lane, since movemask gives several bits per lane
+			static constexpr Mask LaneBits = static_cast<Mask>(~Mask(0)) / ((Mask(1) << BitsPerLane) - 1);
+
+			static Mask matches(const T* p, typename Ops::Vec pattern)
+			{
+				return Ops::movemask(Ops::template cmpeq<sizeof(T)>(Ops::load(p), pattern)) & LaneBits;
+			}
+		};
+
+		template<typename Ops, typename T>
+		const T* findVec(const T* p, const T* end, const T& val)
+		{
+			using V = TVec<Ops, T>;
+			const auto pattern = Ops::template broadcast<sizeof(T)>(toBits(val));
+			for (; end-p>=V::LanesPerVec; p+=V::LanesPerVec)
+			{
+				typename V::Mask mask = V::matches(p, pattern);
+				if (mask)
+					return p + countTrailingZeros(mask)/V::BitsPerLane;
+			}
+			return findScalar(p, end, val);
+		}
+
+		template<typename Ops, typename T>
+		int countVec(const T* p, const T* end, const T& val)
+		{
+			using V = TVec<Ops, T>;
+			const auto pattern = Ops::template broadcast<sizeof(T)>(toBits(val));
+			int count = 0;
+			for (; end-p>=V::LanesPerVec; p+=V::LanesPerVec)
+				count += popCount(V::matches(p, pattern));
+			return count + countScalar(p, end, val);
+		}
+
+		template<typename Ops, typename T>
+		void fillVec(T* p, const T& val, int count)
+		{
+			using V = TVec<Ops, T>;
+			if (count<V::LanesPerVec)
+			{
+				fillScalar(p, val, count);
+				return;
+			}
+
+			const auto pattern = Ops::template broadcast<sizeof(T)>(toBits(val));
+			T* last = p + count - V::LanesPerVec;
+			for (; p<last; p+=V::LanesPerVec)
+				Ops::store(p, pattern);
+			// Whatever is left is done with a store that overlaps what was already written
+			Ops::store(last, pattern);
+		}
+
+#if CZ_SIMD==CZ_SIMD_AVX2
+		using DefaultOps = Avx2Ops;
+#elif CZ_SIMD==CZ_SIMD_SSE2
+		using DefaultOps = Sse2Ops;
+#elif CZ_SIMD==CZ_SIMD_NEON
+		using DefaultOps = NeonOps;
+#endif
+
+	} // namespace detail
+
+	/*! Finds the first element equal to val in [start, end)
+	\return Pointer to the element, or end if not found
+	*/
+	template<typename T>
+	const T* find(const T* start, const T* end, const T& val)
+	{
+		if constexpr (!TIsSupported<T>::value)
+			return detail::findScalar(start, end, val);
+#if CZ_SIMD==CZ_SIMD_NONE
+		else
+			return detail::findScalar(start, end, val);
+#elif CZ_SIMD==CZ_SIMD_SWAR
+		else
+			return detail::findSwar(start, end, val);
+#else
+		else
+			return detail::findVec<detail::DefaultOps>(start, end, val);
+#endif
+	}
+
+	/*! Counts how many elements in [start, end) are equal to val */
+	template<typename T>
+	int count(const T* start, const T* end, const T& val)
+	{
+		if constexpr (!TIsSupported<T>::value)
+			return detail::countScalar(start, end, val);
+#if CZ_SIMD==CZ_SIMD_NONE
+		else
+			return detail::countScalar(start, end, val);
+#elif CZ_SIMD==CZ_SIMD_SWAR
+		else
+			return detail::countSwar(start, end, val);
+#else
+		else
+			return detail::countVec<detail::DefaultOps>(start, end, val);
+#endif
+	}
+
+	/*! Assigns val to count elements, starting at start.
+	The elements need to exist already, unless T is a supported type (see TIsSupported), which doesn't need construction.
+	*/
+	template<typename T>
+	void fill(T* start, const T& val, int count)
+	{
+		if constexpr (!TIsSupported<T>::value)
+			detail::fillScalar(start, val, count);
+#if CZ_SIMD==CZ_SIMD_NONE
+		else
+			detail::fillScalar(start, val, count);
+#elif CZ_SIMD==CZ_SIMD_SWAR
+		else
+			detail::fillSwar(start, val, count);
+#else
+		else
+			detail::fillVec<detail::DefaultOps>(start, val, count);
+#endif
+	}
+
+} // namespace cz::simd
@@ -0,0 +1,300 @@
+/** @file */
+
+#pragma once
+
+#include "crazygaze/micromuc/czmicromuc.h"
+#include "crazygaze/micromuc/Array.h"
+
+namespace cz
+{
+
+	/*! Handle to an element of a TSlotMap.
+	The lower 16 bits are the slot index, and the upper 16 bits the slot generation. The generation changes every time
+	the slot is reused, so handles to removed elements are detected as invalid.
+	A default constructed handle is invalid (generation 0 is never used).
+	*/
+	struct SlotMapHandle
+	{
+		uint32_t value = 0;
+
+		SlotMapHandle() = default;
+
+		explicit SlotMapHandle(uint32_t value_) : value(value_)
+		{
+		}
+
+		SlotMapHandle(uint16_t index, uint16_t generation)
+			: value(static_cast<uint32_t>(generation) << 16 | index)
+		{
+		}
+
+		uint16_t index() const
+		{
+			return static_cast<uint16_t>(value & 0xFFFF);
+		}
+
+		uint16_t generation() const
+		{
+			return static_cast<uint16_t>(value >> 16);
+		}
+
+		/*! Tells if the handle was ever set. It doesn't mean the element still exists. For that, see TSlotMap::contains */
+		bool isSet() const
+		{
+			return value!=0;
+		}
+
+		bool operator==(const SlotMapHandle& other) const
+		{
+			return value==other.value;
+		}
+
+		bool operator!=(const SlotMapHandle& other) const
+		{
+			return value!=other.value;
+		}
+	};
+
+	/*! Container that gives stable handles to its elements, and keeps the elements packed in a contiguous array.
+	Inserting and removing elements is O(1). Removing an element moves the last element to its place (as with
+	TArray::removeAtIndexAndFillWithLast), but the handles of the other elements stay valid, so there is no need to keep
+	side tables to fix up indices.
+	Iterating with begin/end goes through the live elements only, in no particular order.
+	Up to 65535 elements are supported.
+	\tparam Type Element type
+	\tparam Allocator Where the memory comes from. See TArray
+	*/
+	template<typename Type, typename Allocator = MallocAllocator>
+	class TSlotMap
+	{
+	public:
+
+		static constexpr int MaxSize = 0xFFFF;
+
+		TSlotMap()
+		{
+		}
+
+		/*! Constructor
+		\param allocator Allocator to use for the internal arrays
+		*/
+		explicit TSlotMap(const Allocator& allocator)
+			: mElements(allocator)
+			, mElementSlots(allocator)
+			, mSlots(allocator)
+		{
+		}
+
+		/*! Number of elements */
+		int size() const
+		{
+			return mElements.size();
+		}
+
+		/*! Tells if there are no elements */
+		bool empty() const
+		{
+			return mElements.size()==0;
+		}
+
+		/*! Makes sure there is enough space for the specified number of elements, without allocating more memory
+		\return false if out of memory
+		*/
+		bool reserve(int count)
+		{
+			CZ_ASSERT(count<=MaxSize);
+			return mElements.reserve(count) && mElementSlots.reserve(count) && mSlots.reserve(count);
+		}
+
+		/*! Iteration over the live elements, in no particular order.
+		Removing an element invalidates the pointers to the last element.
+		*/
+		Type* begin()
+		{
+			return mElements.begin();
+		}
+
+		Type* end()
+		{
+			return mElements.end();
+		}
+
+		const Type* begin() const
+		{
+			return mElements.begin();
+		}
+
+		const Type* end() const
+		{
+			return mElements.end();
+		}
+
+		/*! Access the elements by their position in the packed array (0 to size()-1)
+		This is NOT the same as the handle's index. Use together with handleAt to iterate and get handles.
+		*/
+		Type& operator[](int index)
+		{
+			return mElements[index];
+		}
+
+		const Type& operator[](int index) const
+		{
+			return mElements[index];
+		}
+
+		/*! Returns the handle of the element at the specified position in the packed array */
+		SlotMapHandle handleAt(int index) const
+		{
+			uint16_t slotIndex = mElementSlots[index];
+			return SlotMapHandle(slotIndex, mSlots[slotIndex].generation);
+		}
+
+		/*! Adds an element
+		\return Handle to the element, or an unset handle if out of memory
+		*/
+		SlotMapHandle insert(const Type& val)
+		{
+			return emplace(val);
+		}
+
+		SlotMapHandle insert(Type&& val)
+		{
+			return emplace(std::move(val));
+		}
+
+		/*! Adds an element, constructing it in place
+		\return Handle to the element, or an unset handle if out of memory
+		*/
+		template<typename... Args>
+		SlotMapHandle emplace(Args&&... args)
+		{
+			if (mElements.size()==MaxSize)
+				return SlotMapHandle();
+
+			// Get a slot first, since that's the only step that can fail without having to undo anything
+			uint16_t slotIndex;
+			if (mFreeHead!=NoSlot)
+			{
+				slotIndex = mFreeHead;
+			}
+			else
+			{
+				if (!mSlots.push(Slot{NoSlot, 1}))
+					return SlotMapHandle();
+				slotIndex = static_cast<uint16_t>(mSlots.size()-1);
+				mSlots[slotIndex].next = mFreeHead;
+				mFreeHead = slotIndex;
+			}
+
+			if (!mElementSlots.push(slotIndex))
+				return SlotMapHandle();
+			if (!mElements.emplace_back(std::forward<Args>(args)...))
+			{
+				mElementSlots.pop();
+				return SlotMapHandle();
+			}
+
+			Slot& slot = mSlots[slotIndex];
+			mFreeHead = slot.next;
+			slot.elementIndex = static_cast<uint16_t>(mElements.size()-1);
+			return SlotMapHandle(slotIndex, slot.generation);
+		}
+
+		/*! Tells if the handle refers to a live element */
+		bool contains(SlotMapHandle handle) const
+		{
+			return findIndex(handle)!=-1;
+		}
+
+		/*! Returns a pointer to the element, or nullptr if the handle is not valid anymore */
+		Type* get(SlotMapHandle handle)
+		{
+			int index = findIndex(handle);
+			return index==-1 ? nullptr : &mElements[index];
+		}
+
+		const Type* get(SlotMapHandle handle) const
+		{
+			int index = findIndex(handle);
+			return index==-1 ? nullptr : &mElements[index];
+		}
+
+		/*! Returns the position of the element in the packed array, or -1 if the handle is not valid anymore */
+		int findIndex(SlotMapHandle handle) const
+		{
+			uint16_t slotIndex = handle.index();
+			if (slotIndex>=mSlots.size())
+				return -1;
+			const Slot& slot = mSlots[slotIndex];
+			// Free slots have their generation already bumped, so this also fails for removed elements
+			return slot.generation==handle.generation() ? slot.elementIndex : -1;
+		}
+
+		/*! Removes the element
+		The last element in the packed array is moved to its place, but its handle stays valid.
+		\return true if the element existed, false otherwise
+		*/
+		bool erase(SlotMapHandle handle)
+		{
+			int index = findIndex(handle);
+			if (index==-1)
+				return false;
+			eraseAt(index);
+			return true;
+		}
+
+		/*! Removes the element at the specified position in the packed array.
+		Useful to remove elements while iterating. The last element is moved to that position, so the current position
+		needs to be checked again.
+		*/
+		void eraseAt(int index)
+		{
+			uint16_t slotIndex = mElementSlots[index];
+			mElements.removeAtIndexAndFillWithLast(index);
+			mElementSlots.removeAtIndexAndFillWithLast(index);
+			if (index<mElements.size())
+				mSlots[mElementSlots[index]].elementIndex = static_cast<uint16_t>(index);
+			freeSlot(slotIndex);
+		}
+
+		/*! Removes all elements. All existing handles become invalid */
+		void clear()
+		{
+			for (int i=0; i<mElementSlots.size(); i++)
+				freeSlot(mElementSlots[i]);
+			mElements.clear();
+			mElementSlots.clear();
+		}
+
+	private:
+
+		static constexpr uint16_t NoSlot = 0xFFFF;
+
+		struct Slot
+		{
+			union
+			{
+				uint16_t elementIndex; // Used while the slot is in use
+				uint16_t next; // Next free slot, while the slot is free
+			};
+			uint16_t generation;
+		};
+
+		void freeSlot(uint16_t slotIndex)
+		{
+			Slot& slot = mSlots[slotIndex];
+			slot.generation++;
+			if (slot.generation==0)
+				slot.generation = 1;
+			slot.next = mFreeHead;
+			mFreeHead = slotIndex;
+		}
+
+		TArray<Type, Allocator> mElements;
+		// Slot of each element
+		TArray<uint16_t, Allocator> mElementSlots;
+		TArray<Slot, Allocator> mSlots;
+		uint16_t mFreeHead = NoSlot;
+	};
+
+} // namespace cz
@@ -0,0 +1,383 @@
+/** @file */
+
+#pragma once
+
+#include "crazygaze/micromuc/czmicromuc.h"
+#include "crazygaze/micromuc/Array.h"
+#include <tuple>
+#include <utility>
+
+namespace cz
+{
+
+	/*! Non owning view of contiguous elements */
+	template<typename T>
+	struct TSpan
+	{
+		T* data;
+		int size;
+
+		T* begin() const
+		{
+			return data;
+		}
+
+		T* end() const
+		{
+			return data+size;
+		}
+
+		T& operator[](int index) const
+		{
+			CZ_ASSERT(index>=0 && index<size);
+			return data[index];
+		}
+	};
+
+	/*! Structure of arrays container.
+	Each field is stored in its own contiguous column, so loops that only touch some of the fields don't waste memory
+	bandwidth/cache on the others.
+	All the columns have the same size and capacity, and grow together. Growing works the same way as in TArray.
+	Use column<I>() to get a column as a TSpan (for the hot loops), and row(index) to get a tuple of references to all
+	the fields of an element. E.g:
+	\code
+	cz::TSoAArray<float, uint32_t> sensors;
+	sensors.push(1.5f, 10);
+	float sum = 0;
+	for (float v : sensors.column<0>())
+		sum += v;
+	auto [value, timestamp] = sensors.row(0);
+	\endcode
+	See TSoAArray, for the version with the default allocator and growth policy.
+	\tparam Allocator Where the memory comes from. See TArray
+	\tparam GrowthPolicy How the capacity grows. See TArray
+	\tparam Fields Type of each column
+	*/
+	template<typename Allocator, typename GrowthPolicy, typename... Fields>
+	class TBasicSoAArray : private Allocator
+	{
+		static_assert(sizeof...(Fields)>0, "TSoAArray needs at least one field");
+
+		using Indices = std::index_sequence_for<Fields...>;
+		static constexpr int NumColumns = sizeof...(Fields);
+
+	public:
+
+		/*! Type of the specified column */
+		template<int I>
+		using FieldType = typename std::tuple_element<I, std::tuple<Fields...>>::type;
+
+		/*! Tuple of references to all the fields of an element */
+		using Row = std::tuple<Fields&...>;
+		using ConstRow = std::tuple<const Fields&...>;
+
+		TBasicSoAArray()
+		{
+		}
+
+		/*! Constructor
+		\param allocator Allocator to use
+		*/
+		explicit TBasicSoAArray(const Allocator& allocator)
+			: Allocator(allocator)
+		{
+		}
+
+		/*! Construct the array, copying from another array. The allocator is copied too.*/
+		TBasicSoAArray(const TBasicSoAArray& other)
+			: Allocator(other.getAllocator())
+		{
+			append(other);
+		}
+
+		/*! Construct the array, taking the memory and allocator of another array. The other array is left empty.*/
+		TBasicSoAArray(TBasicSoAArray&& other) noexcept
+			: Allocator(std::move(static_cast<Allocator&>(other)))
+			, mColumns(other.mColumns)
+			, mSize(other.mSize)
+			, mCapacity(other.mCapacity)
+		{
+			other.mColumns = std::tuple<Fields*...>();
+			other.mSize = 0;
+			other.mCapacity = 0;
+		}
+
+		~TBasicSoAArray()
+		{
+			clear();
+			setCapacity(0);
+		}
+
+		TBasicSoAArray& operator=(const TBasicSoAArray& other)
+		{
+			if (this!=&other)
+			{
+				clear();
+				append(other);
+			}
+			return *this;
+		}
+
+		/*! Releases the current contents, and takes the memory and allocator of the other array.*/
+		TBasicSoAArray& operator=(TBasicSoAArray&& other) noexcept
+		{
+			if (this!=&other)
+			{
+				TBasicSoAArray tmp(std::move(other));
+				swap(tmp);
+			}
+			return *this;
+		}
+
+		/*! Returns the allocator used by the array */
+		const Allocator& getAllocator() const
+		{
+			return *this;
+		}
+
+		/*! Swaps the contents (and allocators) of two arrays. No elements are copied or moved.*/
+		void swap(TBasicSoAArray& other) noexcept
+		{
+			std::swap(static_cast<Allocator&>(*this), static_cast<Allocator&>(other));
+			std::swap(mColumns, other.mColumns);
+			std::swap(mSize, other.mSize);
+			std::swap(mCapacity, other.mCapacity);
+		}
+
+		/*! Returns how many elements there are in the array */
+		int size() const
+		{
+			return mSize;
+		}
+
+		/*! Returns how many elements the array can contain without allocating more memory */
+		int capacity() const
+		{
+			return mCapacity;
+		}
+
+		/*! Grows the array if necessary, to have enough capacity for the specified number of elements
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool reserve(int newcapacity)
+		{
+			if (newcapacity>mCapacity)
+				return setCapacity(newcapacity);
+			return true;
+		}
+
+		/*! Reduces the capacity to "size" */
+		void shrink_to_fit()
+		{
+			setCapacity(mSize);
+		}
+
+		/*! Removes all elements from the array */
+		void clear()
+		{
+			destroyRange(0, mSize, Indices());
+			mSize = 0;
+		}
+
+		/*! Returns the specified column */
+		template<int I>
+		TSpan<FieldType<I>> column()
+		{
+			return TSpan<FieldType<I>>{std::get<I>(mColumns), mSize};
+		}
+
+		template<int I>
+		TSpan<const FieldType<I>> column() const
+		{
+			return TSpan<const FieldType<I>>{std::get<I>(mColumns), mSize};
+		}
+
+		/*! Returns a field of the specified element */
+		template<int I>
+		FieldType<I>& at(int index)
+		{
+			CZ_ASSERT(index>=0 && index<mSize);
+			return std::get<I>(mColumns)[index];
+		}
+
+		template<int I>
+		const FieldType<I>& at(int index) const
+		{
+			CZ_ASSERT(index>=0 && index<mSize);
+			return std::get<I>(mColumns)[index];
+		}
+
+		/*! Returns references to all the fields of the specified element */
+		Row row(int index)
+		{
+			CZ_ASSERT(index>=0 && index<mSize);
+			return makeRow<Row>(mColumns, index, Indices());
+		}
+
+		ConstRow row(int index) const
+		{
+			CZ_ASSERT(index>=0 && index<mSize);
+			return makeRow<ConstRow>(mColumns, index, Indices());
+		}
+
+		/*! Adds a new element to the end of the array
+		\param vals One value per column
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		template<typename... Args>
+		bool push(Args&&... vals)
+		{
+			static_assert(sizeof...(Args)==NumColumns, "TSoAArray::push needs one value per column");
+			if (mSize==mCapacity)
+			{
+				// The values can be references to elements of the array itself, so they need to be copied before growing
+				return pushAndGrow(Fields(std::forward<Args>(vals))...);
+			}
+
+			constructAt(mSize, Indices(), std::forward<Args>(vals)...);
+			mSize++;
+			return true;
+		}
+
+		/*! Removes the last element from the array
+		\return true on success, false if the array was empty
+		*/
+		bool pop()
+		{
+			if (mSize==0)
+				return false;
+			mSize--;
+			destroyRange(mSize, 1, Indices());
+			return true;
+		}
+
+		/*! Removes the element at the specified index, moving the last element to its place */
+		bool removeAtIndexAndFillWithLast(int index)
+		{
+			if (index<0 || index>=mSize)
+				return false;
+
+			destroyRange(index, 1, Indices());
+			if (index<mSize-1)
+				relocateElement(index, mSize-1, Indices());
+			mSize--;
+			return true;
+		}
+
+		/*! Appends all the elements of another array
+		\return true if successful, false otherwise (e.g: Out of memory)*/
+		bool append(const TBasicSoAArray& other)
+		{
+			if (!reserve(mSize+other.mSize))
+				return false;
+			int count = other.mSize; // In case other is this
+			for (int i=0; i<count; i++)
+				pushCopy(other, i, Indices());
+			return true;
+		}
+
+	private:
+
+		bool pushAndGrow(Fields&&... vals)
+		{
+			if (!growFor(mSize+1))
+				return false;
+			constructAt(mSize, Indices(), std::move(vals)...);
+			mSize++;
+			return true;
+		}
+
+		template<typename R, typename Columns, size_t... I>
+		static R makeRow(const Columns& columns, int index, std::index_sequence<I...>)
+		{
+			return R(std::get<I>(columns)[index]...);
+		}
+
+		template<size_t... I, typename... Args>
+		void constructAt(int index, std::index_sequence<I...>, Args&&... vals)
+		{
+			(TArrayElementCreation<Fields>::construct(std::get<I>(mColumns)+index, std::forward<Args>(vals)), ...);
+		}
+
+		template<size_t... I>
+		void pushCopy(const TBasicSoAArray& other, int index, std::index_sequence<I...>)
+		{
+			constructAt(mSize, Indices(), static_cast<const Fields&>(std::get<I>(other.mColumns)[index])...);
+			mSize++;
+		}
+
+		template<size_t... I>
+		void destroyRange(int index, int count, std::index_sequence<I...>)
+		{
+			if (count>0)
+				(TArrayElementCreation<Fields>::destroy(std::get<I>(mColumns)+index, count), ...);
+		}
+
+		template<size_t... I>
+		void relocateElement(int dst, int src, std::index_sequence<I...>)
+		{
+			(TArrayElementCreation<Fields>::relocate(std::get<I>(mColumns)+dst, std::get<I>(mColumns)+src, 1), ...);
+		}
+
+		template<size_t... I>
+		void moveColumns(void* const* newColumns, std::index_sequence<I...>)
+		{
+			(TArrayElementCreation<Fields>::relocate(newColumns[I], std::get<I>(mColumns), mSize), ...);
+			((std::get<I>(mColumns) = static_cast<Fields*>(newColumns[I])), ...);
+		}
+
+		template<size_t... I>
+		void getColumns(void** columns, std::index_sequence<I...>) const
+		{
+			((columns[I] = std::get<I>(mColumns)), ...);
+		}
+
+		bool setCapacity(int newCapacity)
+		{
+			CZ_ASSERT(newCapacity>=mSize);
+			if (newCapacity==mCapacity)
+				return true;
+
+			static constexpr size_t fieldSizes[NumColumns] = {sizeof(Fields)...};
+			void* newColumns[NumColumns] = {};
+			if (newCapacity)
+			{
+				// All columns are allocated before anything is moved, so on failure the array is left as it was
+				for (int i=0; i<NumColumns; i++)
+				{
+					newColumns[i] = Allocator::allocate(fieldSizes[i]*newCapacity);
+					if (!newColumns[i])
+					{
+						while (i--)
+							Allocator::deallocate(newColumns[i], fieldSizes[i]*newCapacity);
+						return false;
+					}
+				}
+			}
+
+			void* oldColumns[NumColumns];
+			getColumns(oldColumns, Indices());
+			moveColumns(newColumns, Indices());
+			if (mCapacity)
+			{
+				for (int i=0; i<NumColumns; i++)
+					Allocator::deallocate(oldColumns[i], fieldSizes[i]*mCapacity);
+			}
+
+			mCapacity = newCapacity;
+			return true;
+		}
+
+		bool growFor(int required)
+		{
+			return setCapacity(GrowthPolicy::calcCapacity(mCapacity, required));
+		}
+
+		std::tuple<Fields*...> mColumns;
+		int mSize = 0;
+		int mCapacity = 0;
+	};
+
+	/*! TBasicSoAArray with the default allocator and growth policy */
+	template<typename... Fields>
+	using TSoAArray = TBasicSoAArray<MallocAllocator, TGeometricGrowth<>, Fields...>;
+
+} // namespace cz
@@ -47,6 +47,19 @@
 	#define _BREAK() __builtin_trap() 
 #endif
 
+//
+// Alignment used to keep data written by different cores/threads apart (e.g: a lock-free queue's head and tail), so
+// they don't share a cache line.
+// Cortex-M0+/AVR don't have a data cache, so separating into different words is enough.
+//
+#if !defined(CZ_CACHELINE_SIZE)
+	#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__) || defined(_M_X64) || defined(_M_IX86)
+		#define CZ_CACHELINE_SIZE 64
+	#else
+		#define CZ_CACHELINE_SIZE 4
+	#endif
+#endif
+
 //
 // assert macros
 //
@@ -0,0 +1,216 @@
+#include <crazygaze/micromuc/Allocator.h>
+#include <crazygaze/micromuc/Array.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][allocator]"
+
+namespace
+{
+
+bool isAligned(void* ptr)
+{
+	return (reinterpret_cast<uintptr_t>(ptr) & (cz::ALLOCATOR_ALIGNMENT - 1)) == 0;
+}
+
+}
+
+TEST_CASE("ArenaAllocator", TEST_TAG)
+{
+	cz::TStaticArenaAllocator<128> arena;
+	CHECK(arena.capacity() == 128);
+	CHECK(arena.used() == 0);
+
+	SECTION("Allocations are aligned and don't overlap")
+	{
+		uint8_t* a = static_cast<uint8_t*>(arena.allocate(3));
+		uint8_t* b = static_cast<uint8_t*>(arena.allocate(5));
+		CHECK(a && b);
+		CHECK(isAligned(a) && isAligned(b));
+		CHECK(b >= a + 3);
+		CHECK(arena.used() == static_cast<size_t>(b + 5 - a));
+	}
+
+	SECTION("Fails when full")
+	{
+		CHECK(arena.allocate(100) != nullptr);
+		CHECK(arena.allocate(100) == nullptr);
+		CHECK(arena.allocate(static_cast<size_t>(-1)) == nullptr);
+	}
+
+	SECTION("Only the last allocation is released by deallocate")
+	{
+		void* a = arena.allocate(16);
+		void* b = arena.allocate(16);
+		size_t used = arena.used();
+		arena.deallocate(a, 16);
+		CHECK(arena.used() == used);
+		arena.deallocate(b, 16);
+		CHECK(arena.used() < used);
+		CHECK(arena.allocate(16) == b);
+	}
+
+	SECTION("reset")
+	{
+		void* a = arena.allocate(64);
+		arena.allocate(32);
+		CHECK(arena.peak() >= 96);
+		arena.reset();
+		CHECK(arena.used() == 0);
+		CHECK(arena.allocate(8) == a);
+		CHECK(arena.peak() >= 96);
+	}
+}
+
+TEST_CASE("PoolAllocator", TEST_TAG)
+{
+	cz::TStaticPoolAllocator<20, 3> pool;
+	CHECK(pool.capacity() == 3);
+	CHECK(pool.blockSize() >= 20);
+	CHECK(pool.blockSize() % cz::ALLOCATOR_ALIGNMENT == 0);
+
+	void* a = pool.allocate(20);
+	void* b = pool.allocate(1);
+	void* c = pool.allocate(10);
+	CHECK(a && b && c);
+	CHECK(isAligned(a) && isAligned(b) && isAligned(c));
+	CHECK(a != b && b != c && a != c);
+	CHECK(pool.used() == 3);
+	CHECK(pool.allocate(1) == nullptr);
+
+	pool.deallocate(b, 1);
+	CHECK(pool.used() == 2);
+	CHECK(pool.allocate(pool.blockSize() + 1) == nullptr);
+	CHECK(pool.allocate(4) == b);
+
+	pool.deallocate(a, 20);
+	pool.deallocate(b, 1);
+	pool.deallocate(c, 10);
+	CHECK(pool.used() == 0);
+}
+
+TEST_CASE("Array-allocators", TEST_TAG)
+{
+	// The default allocator doesn't take any space
+	CHECK(sizeof(cz::TArray<int>) == sizeof(void*) + 2 * sizeof(int));
+
+	SECTION("Arena")
+	{
+		cz::TStaticArenaAllocator<1024> arena;
+		{
+			cz::TArray<int, cz::TAllocatorRef<cz::ArenaAllocator>> a(arena);
+			for (int i = 0; i < 100; i++)
+			{
+				CHECK(a.push(i));
+			}
+			CHECK(a.size() == 100);
+			CHECK(a[0] == 0 && a[99] == 99);
+			CHECK(arena.used() > 0);
+			CHECK(&a.getAllocator().get() == &arena);
+
+			// The arena doesn't have space to grow past this, so nothing is added
+			CHECK(!a.push(1, 200));
+			CHECK(a.size() == 100);
+		}
+		arena.reset();
+		CHECK(arena.used() == 0);
+	}
+
+	SECTION("Arena runs out of memory while resizing")
+	{
+		cz::TStaticArenaAllocator<256> arena;
+		cz::TArray<int, cz::TAllocatorRef<cz::ArenaAllocator>> a(arena);
+		CHECK(a.resize(10));
+		CHECK(a.size() == 10);
+		CHECK(!a.resize(1000));
+		// Keeps what fit
+		CHECK(a.size() > 10);
+		CHECK(a.size() < 1000);
+		CHECK(a.size() <= a.capacity());
+		CHECK(a[0] == 0 && a[a.size() - 1] == 0);
+		CHECK(a.resize(5));
+		CHECK(a.size() == 5);
+	}
+
+	SECTION("TInlineArray runs out of memory")
+	{
+		cz::TStaticArenaAllocator<256> arena;
+		using Array = cz::TInlineArray<int, 4, cz::TAllocatorRef<cz::ArenaAllocator>>;
+		Array a(arena);
+		CHECK(!a.resize(1000));
+		CHECK(a.size() > 4);
+		CHECK(a.size() < 1000);
+		CHECK(!a.isInline());
+
+		// Either all the elements are copied or none
+		Array b(a);
+		CHECK(b.size() == 0);
+		// The inline storage doesn't need the allocator
+		CHECK(b.push(1, 4));
+		CHECK(b.isInline());
+	}
+
+	SECTION("Copying into a nearly full arena")
+	{
+		cz::TStaticArenaAllocator<256> arena;
+		using Array = cz::TArray<int, cz::TAllocatorRef<cz::ArenaAllocator>>;
+		Array a(arena);
+		for (int i = 0; i < 30; i++)
+		{
+			CHECK(a.push(i));
+		}
+		// Leaves space for 24 ints
+		CHECK(arena.allocate(256 - arena.used() - 24 * sizeof(int)) != nullptr);
+
+		// Not enough space for 30 elements, so the copy is left empty instead of truncated
+		Array b(a);
+		CHECK(b.size() == 0);
+
+		// Copies that fit work as usual
+		Array c(arena);
+		CHECK(c.push(1, 2));
+		Array d(c);
+		CHECK(d.size() == 2);
+		CHECK(d == c);
+
+		// Assigning doesn't keep the old contents either
+		d = a;
+		CHECK(d.size() == 0);
+	}
+
+	SECTION("Arena grows in place")
+	{
+		cz::TStaticArenaAllocator<1024> arena;
+		cz::TArray<int, cz::TAllocatorRef<cz::ArenaAllocator>> a(arena);
+		a.push(0);
+		const int* data = a.begin();
+		a.push(0, 100);
+		CHECK(a.begin() == data);
+		CHECK(arena.used() == a.capacity() * sizeof(int));
+		CHECK(arena.peak() == arena.used());
+	}
+
+	SECTION("Pool")
+	{
+		cz::TStaticPoolAllocator<16 * sizeof(int), 2> pool;
+		using Array = cz::TArray<int, cz::TAllocatorRef<cz::PoolAllocator>>;
+		{
+			Array a(pool);
+			Array b(4, pool);
+			CHECK(pool.used() == 1);
+			a.push(1);
+			b.push(2);
+			CHECK(pool.used() == 2);
+
+			// Copies use the same allocator, so it fails to allocate
+			Array c(a);
+			CHECK(c.size() == 0);
+
+			// Can't grow past the block size
+			CHECK(a.push(0, 15));
+			CHECK(!a.push(0));
+			CHECK(a.size() == 16);
+		}
+		CHECK(pool.used() == 0);
+	}
+}
@@ -0,0 +1,406 @@
+#include <crazygaze/micromuc/Array.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+#ifndef __AVR__
+	#include <string>
+	#include <vector>
+#endif
+
+#define TEST_TAG "[czmicromuc][array][benchmark]"
+
+#ifndef __AVR__
+
+namespace
+{
+
+constexpr int gNumPushes = 20000;
+constexpr int gNumInserts = 2000;
+
+template<typename T>
+T makeValue(int i)
+{
+	return static_cast<T>(i);
+}
+
+template<>
+std::string makeValue<std::string>(int i)
+{
+	// Long enough to not fit in the small string buffer
+	return std::string("Some string long enough to need heap memory ") + std::to_string(i);
+}
+
+// Grows an array from empty, one element at a time
+template<typename A, typename T>
+__attribute__((noinline)) int growArray(A& a, const T* values)
+{
+	for(int i = 0; i < gNumPushes; i++)
+	{
+		a.push_back(values[i]);
+	}
+	return static_cast<int>(a.size());
+}
+
+// Inserts elements at the front, so all existing elements need to be moved every time
+template<typename T>
+__attribute__((noinline)) int insertFront(cz::TArray<T>& a, const T& val)
+{
+	for(int i = 0; i < gNumInserts; i++)
+	{
+		a.insertAtIndex(0, val);
+	}
+	return a.size();
+}
+
+template<typename T>
+__attribute__((noinline)) int insertFront(std::vector<T>& a, const T& val)
+{
+	for(int i = 0; i < gNumInserts; i++)
+	{
+		a.insert(a.begin(), val);
+	}
+	return static_cast<int>(a.size());
+}
+
+template<typename T>
+void runBenchmarks(const char* typeName)
+{
+	std::vector<T> values;
+	values.reserve(gNumPushes);
+	for(int i = 0; i < gNumPushes; i++)
+	{
+		values.push_back(makeValue<T>(i));
+	}
+
+	char name[64];
+	cz::test::Stopwatch watch;
+
+	{
+		cz::TArray<T> a;
+		watch.reset();
+		volatile int res = growArray(a, values.data());
+		unsigned long elapsed = watch.elapsedMicros();
+		(void)res;
+		snprintf(name, sizeof(name), "TArray<%s> grow", typeName);
+		cz::test::logBenchmark(name, gNumPushes, elapsed);
+	}
+
+	{
+		std::vector<T> a;
+		watch.reset();
+		volatile int res = growArray(a, values.data());
+		unsigned long elapsed = watch.elapsedMicros();
+		(void)res;
+		snprintf(name, sizeof(name), "std::vector<%s> grow", typeName);
+		cz::test::logBenchmark(name, gNumPushes, elapsed);
+	}
+
+	{
+		cz::TArray<T> a;
+		watch.reset();
+		volatile int res = insertFront(a, values[0]);
+		unsigned long elapsed = watch.elapsedMicros();
+		(void)res;
+		snprintf(name, sizeof(name), "TArray<%s> insert at front", typeName);
+		cz::test::logBenchmark(name, gNumInserts, elapsed);
+	}
+
+	{
+		std::vector<T> a;
+		watch.reset();
+		volatile int res = insertFront(a, values[0]);
+		unsigned long elapsed = watch.elapsedMicros();
+		(void)res;
+		snprintf(name, sizeof(name), "std::vector<%s> insert at front", typeName);
+		cz::test::logBenchmark(name, gNumInserts, elapsed);
+	}
+}
+
+}
+
+TEST_CASE("Array-grow and insert", TEST_TAG)
+{
+	runBenchmarks<int>("int");
+	runBenchmarks<std::string>("std::string");
+}
+
+namespace
+{
+
+constexpr int gNumFrames = 200;
+constexpr int gArraysPerFrame = 20;
+
+/**
+ * Wraps an allocator to count allocations
+ */
+template<typename A>
+struct TCountingAllocator : public A
+{
+	using A::A;
+	static inline int ms_count = 0;
+
+	void* allocate(size_t size)
+	{
+		ms_count++;
+		return A::allocate(size);
+	}
+};
+
+// Simulates frames where a few short lived arrays are created, filled and destroyed
+template<typename Allocator>
+__attribute__((noinline)) int runFrame(const Allocator& allocator)
+{
+	int sum = 0;
+	for(int i = 0; i < gArraysPerFrame; i++)
+	{
+		cz::TArray<int, Allocator> a(allocator);
+		for(int j = 0; j < 8 + i; j++)
+		{
+			a.push(j);
+		}
+		sum += a.size();
+	}
+	return sum;
+}
+
+}
+
+TEST_CASE("Array-allocators per frame", TEST_TAG)
+{
+	cz::test::Stopwatch watch;
+	unsigned long elapsed;
+	char name[80];
+
+	{
+		using Allocator = TCountingAllocator<cz::MallocAllocator>;
+		Allocator::ms_count = 0;
+		Allocator allocator;
+		watch.reset();
+		for(int frame = 0; frame < gNumFrames; frame++)
+		{
+			volatile int res = runFrame<Allocator>(allocator);
+			(void)res;
+		}
+		elapsed = watch.elapsedMicros();
+		snprintf(name, sizeof(name), "TArray malloc frames (%d allocations)", Allocator::ms_count);
+		cz::test::logBenchmark(name, gNumFrames * gArraysPerFrame, elapsed);
+	}
+
+	{
+		static cz::TStaticArenaAllocator<8192> arena;
+		using Allocator = TCountingAllocator<cz::TAllocatorRef<cz::ArenaAllocator>>;
+		Allocator::ms_count = 0;
+		Allocator allocator(arena);
+		watch.reset();
+		for(int frame = 0; frame < gNumFrames; frame++)
+		{
+			volatile int res = runFrame<Allocator>(allocator);
+			(void)res;
+			arena.reset();
+		}
+		elapsed = watch.elapsedMicros();
+		snprintf(name, sizeof(name), "TArray arena frames (%d allocations, %lu bytes peak)", Allocator::ms_count,
+			static_cast<unsigned long>(arena.peak()));
+		cz::test::logBenchmark(name, gNumFrames * gArraysPerFrame, elapsed);
+	}
+
+	{
+		static cz::TStaticPoolAllocator<64 * sizeof(int), 4> pool;
+		using Allocator = TCountingAllocator<cz::TAllocatorRef<cz::PoolAllocator>>;
+		Allocator::ms_count = 0;
+		Allocator allocator(pool);
+		watch.reset();
+		for(int frame = 0; frame < gNumFrames; frame++)
+		{
+			volatile int res = runFrame<Allocator>(allocator);
+			(void)res;
+		}
+		elapsed = watch.elapsedMicros();
+		snprintf(name, sizeof(name), "TArray pool frames (%d allocations)", Allocator::ms_count);
+		cz::test::logBenchmark(name, gNumFrames * gArraysPerFrame, elapsed);
+		CHECK(pool.used() == 0);
+	}
+}
+
+namespace
+{
+
+constexpr int gNumOuter = 1000;
+constexpr int gInnerSize = 16;
+constexpr int gNumRebuilds = 20;
+
+using Nested = cz::TArray<cz::TArray<int>>;
+
+void fillNested(Nested& nested)
+{
+	for(int i = 0; i < gNumOuter; i++)
+	{
+		cz::TArray<int> inner;
+		inner.push(i, gInnerSize);
+		nested.push(std::move(inner));
+	}
+}
+
+// Rebuilds the nested array in reverse order, by copying the inner arrays
+__attribute__((noinline)) int rebuildCopy(Nested& nested)
+{
+	Nested res;
+	for(int i = nested.size() - 1; i >= 0; i--)
+	{
+		res.push(nested[i]);
+	}
+	nested = res;
+	return nested.size();
+}
+
+// Rebuilds the nested array in reverse order, by moving the inner arrays
+__attribute__((noinline)) int rebuildMove(Nested& nested)
+{
+	Nested res;
+	for(int i = nested.size() - 1; i >= 0; i--)
+	{
+		res.push(std::move(nested[i]));
+	}
+	nested = std::move(res);
+	return nested.size();
+}
+
+template<typename F>
+void runRebuildBenchmark(const char* name, F&& f)
+{
+	Nested nested;
+	fillNested(nested);
+	cz::test::Stopwatch watch;
+	for(int i = 0; i < gNumRebuilds; i++)
+	{
+		volatile int res = f(nested);
+		(void)res;
+	}
+	unsigned long elapsed = watch.elapsedMicros();
+	cz::test::logBenchmark(name, gNumOuter * gNumRebuilds, elapsed);
+	CHECK(nested.size() == gNumOuter && nested[0].size() == gInnerSize);
+}
+
+}
+
+TEST_CASE("Array-nested rebuild", TEST_TAG)
+{
+	runRebuildBenchmark("TArray<TArray<int>> rebuild by copy", rebuildCopy);
+	runRebuildBenchmark("TArray<TArray<int>> rebuild by move", rebuildMove);
+}
+
+namespace
+{
+
+constexpr int gNumGrowPushes = 4000;
+
+// Same as an int, but not trivially relocatable, so the array can't use reallocate
+struct NonRelocatableInt
+{
+	NonRelocatableInt(int v) : v(v) {}
+	NonRelocatableInt(const NonRelocatableInt& other) : v(other.v) {}
+	int v;
+};
+
+template<typename T, typename GrowthPolicy>
+void runGrowthBenchmark(const char* name)
+{
+	cz::test::PeakTrackingAllocator::reset();
+	cz::test::Stopwatch watch;
+	{
+		cz::TArray<T, cz::test::PeakTrackingAllocator, GrowthPolicy> a;
+		for(int i = 0; i < gNumGrowPushes; i++)
+		{
+			a.push(T(i));
+		}
+	}
+	unsigned long elapsed = watch.elapsedMicros();
+
+	char buf[100];
+	snprintf(buf, sizeof(buf), "%s (%d allocations, %lu bytes peak)", name, cz::test::PeakTrackingAllocator::ms_count,
+		static_cast<unsigned long>(cz::test::PeakTrackingAllocator::ms_peak));
+	cz::test::logBenchmark(buf, gNumGrowPushes, elapsed);
+	CHECK(cz::test::PeakTrackingAllocator::ms_used == 0);
+}
+
+}
+
+TEST_CASE("Array-growth policies", TEST_TAG)
+{
+	runGrowthBenchmark<int, cz::TGeometricGrowth<>>("TArray<int> x2 growth (realloc)");
+	runGrowthBenchmark<NonRelocatableInt, cz::TGeometricGrowth<>>("TArray<NonRelocatableInt> x2 growth");
+	runGrowthBenchmark<int, cz::TGeometricGrowth<3, 2>>("TArray<int> x1.5 growth (realloc)");
+	runGrowthBenchmark<int, cz::TFixedStepGrowth<256>>("TArray<int> +256 growth (realloc)");
+	runGrowthBenchmark<int, cz::ExactGrowth>("TArray<int> exact growth (realloc)");
+}
+
+namespace
+{
+
+constexpr int gNumEntries = 2000;
+constexpr int gNumTicks = 20;
+
+struct Entry
+{
+	uint32_t expireTick;
+	uint32_t data;
+};
+
+void fillEntries(cz::TArray<Entry>& entries)
+{
+	entries.clear();
+	for(int i = 0; i < gNumEntries; i++)
+	{
+		// A quarter of the entries expire every tick
+		entries.push(Entry{static_cast<uint32_t>((i * 7) % 4), static_cast<uint32_t>(i)});
+	}
+}
+
+__attribute__((noinline)) int expireOneByOne(cz::TArray<Entry>& entries, uint32_t tick)
+{
+	int count = 0;
+	for(int i = 0; i < entries.size(); )
+	{
+		if (entries[i].expireTick == tick)
+		{
+			entries.removeAtIndex(i);
+			count++;
+		}
+		else
+		{
+			i++;
+		}
+	}
+	return count;
+}
+
+__attribute__((noinline)) int expireEraseIf(cz::TArray<Entry>& entries, uint32_t tick)
+{
+	return entries.eraseIf([tick](const Entry& e) { return e.expireTick == tick; });
+}
+
+template<typename F>
+void runExpireBenchmark(const char* name, F&& f)
+{
+	cz::TArray<Entry> entries;
+	unsigned long elapsed = 0;
+	int removed = 0;
+	for(int tick = 0; tick < gNumTicks; tick++)
+	{
+		fillEntries(entries);
+		cz::test::Stopwatch watch;
+		removed += f(entries, tick % 4);
+		elapsed += watch.elapsedMicros();
+	}
+	cz::test::logBenchmark(name, removed, elapsed);
+	CHECK(removed == gNumEntries / 4 * gNumTicks);
+}
+
+}
+
+TEST_CASE("Array-expire entries", TEST_TAG)
+{
+	runExpireBenchmark("TArray removeAtIndex loop (per removed entry)", expireOneByOne);
+	runExpireBenchmark("TArray eraseIf (per removed entry)", expireEraseIf);
+}
+
+#endif
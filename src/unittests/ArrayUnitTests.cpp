@@ -0,0 +1,604 @@
+#include <crazygaze/micromuc/Array.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+#include <string>
+
+#define TEST_TAG "[czmicromuc][array]"
+
+namespace
+{
+
+using cz::test::equals;
+using cz::test::Tracked;
+
+/**
+ * Same as Tracked, but the move constructor can throw, so the arrays should copy instead
+ */
+struct ThrowingMove : Tracked
+{
+	using Tracked::Tracked;
+	ThrowingMove(const ThrowingMove& other) = default;
+	ThrowingMove(ThrowingMove&& other) noexcept(false) : Tracked(std::move(other)) {}
+	ThrowingMove& operator=(const ThrowingMove& other) = default;
+};
+
+}
+
+TEST_CASE("Array-trivially copyable", TEST_TAG)
+{
+	cz::TArray<int> a;
+
+	SECTION("grow")
+	{
+		for (int i = 0; i < 100; i++)
+		{
+			a.push(i);
+		}
+		CHECK(a.size() == 100);
+		bool ok = true;
+		for (int i = 0; i < 100; i++)
+		{
+			ok = ok && a[i] == i;
+		}
+		CHECK(ok);
+	}
+
+	SECTION("insert/remove")
+	{
+		a.push(1);
+		a.push(2);
+		a.push(3);
+		CHECK(a.insertAtIndex(0, 0));
+		CHECK(a.insertAtIndex(2, 10));
+		CHECK(a.insertAtIndex(5, 4));
+		CHECK(!a.insertAtIndex(7, 4));
+		CHECK(equals(a, {0, 1, 10, 2, 3, 4}));
+
+		CHECK(a.removeAtIndex(2));
+		CHECK(a.removeAtIndex(0));
+		CHECK(a.removeAtIndex(3));
+		CHECK(equals(a, {1, 2, 3}));
+
+		CHECK(a.removeAtIndexAndFillWithLast(0));
+		CHECK(equals(a, {3, 2}));
+	}
+
+	SECTION("insert an element of the array itself")
+	{
+		a.push(1);
+		a.push(2);
+		a.push(3);
+		a.insertAtIndex(0, a[1]);
+		CHECK(equals(a, {2, 1, 2, 3}));
+		a.insertAtIndex(1, a[3]);
+		CHECK(equals(a, {2, 3, 1, 2, 3}));
+	}
+
+	SECTION("copy/append")
+	{
+		a.push(1);
+		a.push(2);
+		cz::TArray<int> b(a);
+		b.append(a);
+		CHECK(equals(b, {1, 2, 1, 2}));
+	}
+
+	SECTION("static array")
+	{
+		cz::TStaticArray<int, 4, true> s;
+		s.push(1);
+		s.push(3);
+		CHECK(s.insertAtIndex(1, 2));
+		CHECK(s.insertAtIndex(0, 0));
+		CHECK(!s.insertAtIndex(0, 0));
+		CHECK(equals(s, {0, 1, 2, 3}));
+		CHECK(s.removeAtIndex(1));
+		CHECK(equals(s, {0, 2, 3}));
+	}
+}
+
+TEST_CASE("Array-non trivially copyable", TEST_TAG)
+{
+	Tracked::reset();
+
+	SECTION("Growing moves the elements instead of copying")
+	{
+		cz::TArray<Tracked> a;
+		for (int i = 0; i < 100; i++)
+		{
+			a.emplace_back(i);
+		}
+		CHECK(Tracked::ms_copies == 0);
+		CHECK(Tracked::ms_alive == 100);
+		CHECK(a[0] == 0 && a[99] == 99);
+	}
+	CHECK(Tracked::ms_alive == 0);
+
+	SECTION("insert/remove only copy the inserted value")
+	{
+		cz::TArray<Tracked> a;
+		a.emplace_back(1);
+		a.emplace_back(2);
+		a.emplace_back(3);
+		Tracked::ms_copies = 0;
+		a.insertAtIndex(0, Tracked(0));
+		a.insertAtIndex(2, a[3]);
+		CHECK(Tracked::ms_copies == 2);
+		CHECK(equals(a, {0, 1, 3, 2, 3}));
+
+		a.removeAtIndex(0);
+		a.removeAtIndexAndFillWithLast(0);
+		CHECK(Tracked::ms_copies == 2);
+		CHECK(equals(a, {3, 3, 2}));
+
+		Tracked out;
+		CHECK(a.pop(out));
+		CHECK(out == 2);
+		CHECK(Tracked::ms_copies == 2);
+		CHECK(Tracked::ms_alive == 3);
+	}
+	CHECK(Tracked::ms_alive == 0);
+
+	SECTION("static array")
+	{
+		cz::TStaticArray<Tracked, 4, true> s;
+		s.push(Tracked(1));
+		s.push(Tracked(3));
+		Tracked::ms_copies = 0;
+		s.insertAtIndex(1, Tracked(2));
+		s.removeAtIndex(0);
+		CHECK(Tracked::ms_copies == 1);
+		CHECK(equals(s, {2, 3}));
+	}
+	CHECK(Tracked::ms_alive == 0);
+
+	SECTION("Elements are copied if the move constructor can throw")
+	{
+		cz::TArray<ThrowingMove> a(2);
+		a.emplace_back(0);
+		a.emplace_back(1);
+		Tracked::ms_copies = 0;
+		a.emplace_back(2);
+		CHECK(Tracked::ms_copies == 2);
+		CHECK(equals(a, {0, 1, 2}));
+	}
+	CHECK(Tracked::ms_alive == 0);
+}
+
+TEST_CASE("InlineArray", TEST_TAG)
+{
+	Tracked::reset();
+
+	SECTION("Stays inline until it overflows")
+	{
+		cz::TInlineArray<int, 4> a;
+		CHECK(a.isInline());
+		CHECK(a.capacity() == 4);
+		CHECK(reinterpret_cast<const char*>(a.begin()) >= reinterpret_cast<const char*>(&a));
+		CHECK(reinterpret_cast<const char*>(a.begin()) < reinterpret_cast<const char*>(&a + 1));
+
+		for (int i = 0; i < 4; i++)
+		{
+			a.push(i);
+		}
+		CHECK(a.isInline());
+
+		a.push(a[0]);
+		CHECK(!a.isInline());
+		CHECK(a.capacity() == 8);
+		CHECK(equals(a, {0, 1, 2, 3, 0}));
+
+		CHECK(a.insertAtIndex(0, 10));
+		CHECK(a.removeAtIndex(1));
+		CHECK(a.removeAtIndexAndFillWithLast(0));
+		CHECK(equals(a, {0, 1, 2, 3}));
+
+		// Moves back to the inline storage
+		a.shrink_to_fit();
+		CHECK(a.isInline());
+		CHECK(equals(a, {0, 1, 2, 3}));
+	}
+
+	SECTION("insert when full")
+	{
+		cz::TInlineArray<int, 2> a;
+		a.push(1);
+		a.push(2);
+		CHECK(a.insertAtIndex(1, a[1]));
+		CHECK(equals(a, {1, 2, 2}));
+		CHECK(!a.insertAtIndex(4, 0));
+	}
+
+	SECTION("copy/append/find")
+	{
+		cz::TInlineArray<int, 2> a;
+		a.push(1);
+		a.push(2);
+		cz::TInlineArray<int, 2> b(a);
+		CHECK(b == a);
+		CHECK(b.isInline());
+		b.append(a);
+		CHECK(equals(b, {1, 2, 1, 2}));
+		a = b;
+		CHECK(a == b);
+		int idx;
+		CHECK(a.find(2, idx) && idx == 1);
+		CHECK(!a.find(3));
+		CHECK(a.removeIfExists(1) == 2);
+		CHECK(equals(a, {2, 2}));
+	}
+
+	SECTION("Non trivially copyable elements are moved when spilling to the heap")
+	{
+		{
+			cz::TInlineArray<Tracked, 2> a;
+			a.emplace_back(1);
+			a.emplace_back(2);
+			a.emplace_back(3);
+			CHECK(Tracked::ms_copies == 0);
+			CHECK(Tracked::ms_alive == 3);
+			a.resize(1);
+			a.shrink_to_fit();
+			CHECK(a.isInline());
+			CHECK(equals(a, {1}));
+			CHECK(Tracked::ms_copies == 0);
+			CHECK(Tracked::ms_alive == 1);
+		}
+		CHECK(Tracked::ms_alive == 0);
+	}
+}
+
+TEST_CASE("Array-move", TEST_TAG)
+{
+	Tracked::reset();
+
+	SECTION("move construction/assignment steal the memory")
+	{
+		cz::TArray<Tracked> a;
+		a.emplace_back(1);
+		a.emplace_back(2);
+		const Tracked* data = a.begin();
+
+		cz::TArray<Tracked> b(std::move(a));
+		CHECK(a.size() == 0 && a.capacity() == 0);
+		CHECK(b.begin() == data);
+		CHECK(equals(b, {1, 2}));
+
+		cz::TArray<Tracked> c;
+		c.emplace_back(3);
+		c = std::move(b);
+		CHECK(b.size() == 0);
+		CHECK(c.begin() == data);
+		CHECK(equals(c, {1, 2}));
+		CHECK(Tracked::ms_copies == 0);
+		CHECK(Tracked::ms_alive == 2);
+
+		swap(a, c);
+		CHECK(c.size() == 0);
+		CHECK(equals(a, {1, 2}));
+	}
+	CHECK(Tracked::ms_alive == 0);
+
+	SECTION("rvalue push")
+	{
+		cz::TArray<Tracked> a;
+		Tracked t(1);
+		a.push(std::move(t));
+		CHECK(t.n == -1);
+		a.push_back(Tracked(2));
+		cz::TStaticArray<Tracked, 2, true> s;
+		s.push(Tracked(1));
+		s.push_back(Tracked(2));
+		CHECK(!s.push(Tracked(3)));
+		CHECK(Tracked::ms_copies == 0);
+		CHECK(equals(a, {1, 2}));
+		CHECK(equals(s, {1, 2}));
+	}
+	CHECK(Tracked::ms_alive == 0);
+
+	SECTION("push an element of the array itself while growing")
+	{
+		cz::TArray<Tracked> a(1);
+		a.emplace_back(1);
+		a.push(a[0]);
+		a.push(a[1]);
+		CHECK(equals(a, {1, 1, 1}));
+	}
+	CHECK(Tracked::ms_alive == 0);
+
+	SECTION("emplace_back an element of the array itself while growing")
+	{
+		// Long enough to not fit in the small string buffer, so a dangling reference would read freed memory
+		cz::TArray<std::string> a(1);
+		a.emplace_back("A string that doesn't fit in the small string buffer");
+		CHECK(a.capacity() == 1);
+		a.emplace_back(a[0]);
+		a.emplace_back(a[1]);
+		CHECK(a.size() == 3);
+		CHECK(a[2] == a[0]);
+		CHECK(a[1] == "A string that doesn't fit in the small string buffer");
+	}
+
+	SECTION("emplace_back an element of the inline storage while moving to the heap")
+	{
+		cz::TInlineArray<std::string, 2> a;
+		a.emplace_back("A string that doesn't fit in the small string buffer");
+		a.emplace_back("Another string that doesn't fit in the small string buffer");
+		CHECK(a.isInline());
+		a.emplace_back(a[0]);
+		CHECK(!a.isInline());
+		CHECK(a.size() == 3);
+		CHECK(a[2] == "A string that doesn't fit in the small string buffer");
+		CHECK(a[0] == a[2]);
+	}
+
+	SECTION("arrays of arrays")
+	{
+		cz::TArray<cz::TArray<Tracked>> a;
+		for (int i = 0; i < 40; i++)
+		{
+			cz::TArray<Tracked> inner;
+			inner.emplace_back(i);
+			a.push(std::move(inner));
+		}
+		CHECK(Tracked::ms_copies == 0);
+		CHECK(Tracked::ms_alive == 40);
+		CHECK(a[39][0] == 39);
+	}
+	CHECK(Tracked::ms_alive == 0);
+
+	SECTION("TInlineArray")
+	{
+		cz::TInlineArray<Tracked, 2> inl;
+		inl.emplace_back(1);
+		cz::TInlineArray<Tracked, 2> heap;
+		heap.emplace_back(1);
+		heap.emplace_back(2);
+		heap.emplace_back(3);
+		const Tracked* heapData = heap.begin();
+
+		cz::TInlineArray<Tracked, 2> a(std::move(inl));
+		CHECK(a.isInline() && inl.isInline());
+		CHECK(inl.size() == 0);
+		CHECK(equals(a, {1}));
+
+		a = std::move(heap);
+		CHECK(!a.isInline() && heap.isInline());
+		CHECK(a.begin() == heapData);
+		CHECK(heap.size() == 0);
+		CHECK(equals(a, {1, 2, 3}));
+
+		a.push(Tracked(4));
+		CHECK(Tracked::ms_copies == 0);
+		CHECK(Tracked::ms_alive == 4);
+	}
+	CHECK(Tracked::ms_alive == 0);
+}
+
+TEST_CASE("Array-growth", TEST_TAG)
+{
+	static_assert(cz::TIsTriviallyRelocatable<int>::value, "");
+	static_assert(cz::TIsTriviallyRelocatable<cz::TArray<Tracked>>::value, "");
+	static_assert(!cz::TIsTriviallyRelocatable<Tracked>::value, "");
+	static_assert(!cz::TIsTriviallyRelocatable<cz::TInlineArray<int, 2>>::value, "");
+
+	SECTION("Geometric")
+	{
+		cz::TArray<int, cz::MallocAllocator, cz::TGeometricGrowth<3, 2, 4>> a;
+		a.push(0);
+		CHECK(a.capacity() == 4);
+		a.push(0, 4);
+		CHECK(a.capacity() == 6);
+		a.push(0, 2);
+		CHECK(a.capacity() == 9);
+	}
+
+	SECTION("Fixed step")
+	{
+		cz::TArray<int, cz::MallocAllocator, cz::TFixedStepGrowth<10>> a;
+		a.push(0);
+		CHECK(a.capacity() == 10);
+		a.push(0, 10);
+		CHECK(a.capacity() == 20);
+		a.push(0, 30);
+		CHECK(a.capacity() == 41);
+	}
+
+	SECTION("Exact")
+	{
+		cz::TArray<int, cz::MallocAllocator, cz::ExactGrowth> a;
+		for (int i = 0; i < 5; i++)
+		{
+			a.push(i);
+			CHECK(a.capacity() == i + 1);
+		}
+		a.push(a[4], 3);
+		CHECK(a.capacity() == 8);
+		CHECK(equals(a, {0, 1, 2, 3, 4, 4, 4, 4}));
+
+		cz::TArray<int, cz::MallocAllocator, cz::ExactGrowth> b;
+		b.append(a);
+		b.append(b);
+		CHECK(b.capacity() == 16);
+		CHECK(b.size() == 16);
+		CHECK(b[15] == 4);
+	}
+
+	SECTION("Non trivially relocatable elements survive reallocation")
+	{
+		Tracked::reset();
+		{
+			cz::TArray<Tracked, cz::MallocAllocator, cz::ExactGrowth> a;
+			for (int i = 0; i < 10; i++)
+			{
+				a.emplace_back(i);
+			}
+			a.shrink_to_fit();
+			CHECK(a[9] == 9);
+			CHECK(Tracked::ms_copies == 0);
+		}
+		CHECK(Tracked::ms_alive == 0);
+	}
+}
+
+namespace
+{
+
+template<typename A>
+void testRanges(A& a)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		a.push(i);
+	}
+
+	const int src[] = {10, 11, 12};
+	CHECK(a.insertRange(2, src, 3));
+	CHECK(equals(a, {0, 1, 10, 11, 12, 2, 3, 4, 5}));
+	CHECK(a.insertRange(a.size(), src, 1));
+	CHECK(a.insertRange(0, src, 0));
+	CHECK(!a.insertRange(a.size() + 1, src, 1));
+	CHECK(!a.insertRange(-1, src, 1));
+	CHECK(equals(a, {0, 1, 10, 11, 12, 2, 3, 4, 5, 10}));
+
+	// Source range crossing the insertion point
+	CHECK(a.eraseRange(2, 3));
+	CHECK(equals(a, {0, 1, 2, 3, 4, 5, 10}));
+	CHECK(a.insertRange(2, &a[1], 3));
+	CHECK(equals(a, {0, 1, 1, 2, 3, 2, 3, 4, 5, 10}));
+
+	CHECK(a.eraseRange(0, 2));
+	CHECK(a.eraseRange(a.size() - 1, 1));
+	CHECK(a.eraseRange(3, 0));
+	CHECK(!a.eraseRange(5, 4));
+	CHECK(!a.eraseRange(-1, 1));
+	CHECK(equals(a, {1, 2, 3, 2, 3, 4, 5}));
+
+	CHECK(a.eraseIf([](int v) { return v == 2 || v == 5; }) == 3);
+	CHECK(equals(a, {1, 3, 3, 4}));
+	CHECK(a.removeIfExists(3) == 2);
+	CHECK(equals(a, {1, 4}));
+	CHECK(a.eraseIf([](int) { return true; }) == 2);
+	CHECK(a.size() == 0);
+}
+
+}
+
+TEST_CASE("Array-ranges", TEST_TAG)
+{
+	Tracked::reset();
+
+	SECTION("TArray")
+	{
+		cz::TArray<int> a;
+		testRanges(a);
+	}
+
+	SECTION("TArray growing with a source in the array")
+	{
+		cz::TArray<int, cz::MallocAllocator, cz::ExactGrowth> a;
+		a.push(1);
+		a.push(2);
+		CHECK(a.insertRange(1, a.begin(), 2));
+		CHECK(equals(a, {1, 1, 2, 2}));
+	}
+
+	SECTION("TStaticArray")
+	{
+		cz::TStaticArray<int, 10, true> a;
+		testRanges(a);
+		int src[11] = {};
+		CHECK(!a.insertRange(0, src, 11));
+	}
+
+	SECTION("TInlineArray")
+	{
+		cz::TInlineArray<int, 4> a;
+		testRanges(a);
+	}
+
+	SECTION("Non trivially copyable")
+	{
+		{
+			cz::TArray<Tracked> a;
+			for (int i = 0; i < 10; i++)
+			{
+				a.emplace_back(i);
+			}
+			Tracked::ms_copies = 0;
+
+			int calls = 0;
+			CHECK(a.eraseIf([&calls](const Tracked& v) { calls++; return v.n % 3 == 0; }) == 4);
+			CHECK(calls == 10);
+			CHECK(equals(a, {1, 2, 4, 5, 7, 8}));
+			CHECK(Tracked::ms_alive == 6);
+
+			CHECK(a.eraseRange(1, 2));
+			CHECK(equals(a, {1, 5, 7, 8}));
+
+			const Tracked src[2] = {Tracked(10), Tracked(11)};
+			CHECK(a.insertRange(1, src, 2));
+			CHECK(equals(a, {1, 10, 11, 5, 7, 8}));
+			CHECK(Tracked::ms_copies == 2);
+			CHECK(Tracked::ms_alive == 8);
+		}
+		CHECK(Tracked::ms_alive == 0);
+	}
+}
+
+namespace
+{
+
+struct CalibrationPoint
+{
+	int16_t raw;
+	int16_t value;
+};
+
+constexpr cz::TConstexprArray<uint8_t, 5> gPins = {{2, 3, 5, 7, 3}};
+constexpr auto gSquares = cz::makeConstexprArray<uint16_t, 16>([](int i) { return static_cast<uint16_t>(i * i); });
+constexpr cz::TConstexprArray<CalibrationPoint, 3> gCalibration = {{{0, -40}, {512, 25}, {1023, 125}}};
+
+constexpr int sum(const cz::TConstexprArray<uint16_t, 16>& a)
+{
+	int res = 0;
+	for (auto v : a)
+	{
+		res += v;
+	}
+	return res;
+}
+
+}
+
+TEST_CASE("Array-constexpr", TEST_TAG)
+{
+	// Everything here is evaluated at compile time
+	static_assert(std::is_trivially_default_constructible<cz::TConstexprArray<int, 4>>::value, "");
+	static_assert(std::is_trivially_destructible<cz::TConstexprArray<int, 4>>::value, "");
+	static_assert(sizeof(gSquares) == sizeof(uint16_t) * 16, "");
+	static_assert(gPins.size() == 5 && gPins[3] == 7, "");
+	static_assert(gSquares[15] == 225, "");
+	static_assert(sum(gSquares) == 1240, "");
+	static_assert(gCalibration[1].value == 25, "");
+	static_assert(gCalibration.end() - gCalibration.begin() == 3, "");
+
+	CHECK(gPins.size() == 5);
+	CHECK(gPins.capacity() == 5);
+	CHECK(gPins[0] == 2);
+	int index = -1;
+	CHECK(gPins.find(5, index) && index == 2);
+	CHECK(!gPins.find(4));
+	CHECK(gPins.count(3) == 2);
+	CHECK(sum(gSquares) == 1240);
+
+	// Can also be used as a mutable array
+	cz::TConstexprArray<int, 3> a = {{1, 2, 3}};
+	a[1] = 20;
+	int total = 0;
+	for (int v : a)
+	{
+		total += v;
+	}
+	CHECK(total == 24);
+}
@@ -0,0 +1,95 @@
+#include <crazygaze/micromuc/BitArray.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][bitarray][benchmark]"
+
+namespace
+{
+
+#ifdef __AVR__
+constexpr int gNumChannels = 64;
+constexpr int gNumScans = 500;
+#else
+constexpr int gNumChannels = 1024;
+constexpr int gNumScans = 20000;
+#endif
+
+// How many channels are active. Scans are usually done with few channels active
+constexpr int gNumActive = 8;
+
+// What we did before TStaticBitArray: one bool per channel
+__attribute__((noinline)) int scanBools(const cz::TStaticArray<bool, gNumChannels>& active)
+{
+	int sum = 0;
+	for (int i = 0; i < gNumChannels; i++)
+	{
+		if (active[i])
+		{
+			sum += i;
+		}
+	}
+	return sum;
+}
+
+__attribute__((noinline)) int scanBits(const cz::TStaticBitArray<gNumChannels>& active)
+{
+	int sum = 0;
+	for (int i : active.setBits())
+	{
+		sum += i;
+	}
+	return sum;
+}
+
+}
+
+TEST_CASE("BitArray-active channels", TEST_TAG)
+{
+	cz::TStaticArray<bool, gNumChannels> bools;
+	cz::TStaticBitArray<gNumChannels> bits;
+	bools.setAll(false);
+	int expected = 0;
+	for (int i = 0; i < gNumActive; i++)
+	{
+		int channel = (i * 37 + 5) % gNumChannels;
+		bools[channel] = true;
+		bits.set(channel);
+		expected += channel;
+	}
+
+	CZ_LOG(logDefault, Log, "%d channels. bools: %u bytes, bits: %u bytes", gNumChannels,
+		static_cast<unsigned>(sizeof(bools)), static_cast<unsigned>(sizeof(bits)));
+
+	{
+		cz::test::Stopwatch watch;
+		for (int i = 0; i < gNumScans; i++)
+		{
+			volatile int res = scanBools(bools);
+			CHECK(res == expected);
+		}
+		cz::test::logBenchmark("TStaticArray<bool> active channels scan", gNumScans, watch.elapsedMicros());
+	}
+
+	{
+		cz::test::Stopwatch watch;
+		for (int i = 0; i < gNumScans; i++)
+		{
+			volatile int res = scanBits(bits);
+			CHECK(res == expected);
+		}
+		cz::test::logBenchmark("TStaticBitArray active channels scan", gNumScans, watch.elapsedMicros());
+	}
+
+	{
+		cz::test::Stopwatch watch;
+		int total = 0;
+		for (int i = 0; i < gNumScans; i++)
+		{
+			volatile int res = bits.count();
+			total += res;
+		}
+		cz::test::logBenchmark("TStaticBitArray count", gNumScans, watch.elapsedMicros());
+		CHECK(total == gNumScans * gNumActive);
+	}
+}
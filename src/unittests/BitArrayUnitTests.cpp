@@ -0,0 +1,249 @@
+#include <crazygaze/micromuc/BitArray.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][bitarray]"
+
+namespace
+{
+
+// Collects the set bits with setBits(), and checks findFirstSet/findNextSet give the same
+template<typename B>
+cz::TArray<int> setBitsOf(const B& bits)
+{
+	cz::TArray<int> res;
+	for (int i : bits.setBits())
+	{
+		res.push(i);
+	}
+
+	int n = 0;
+	for (int i = bits.findFirstSet(); i != -1; i = bits.findNextSet(i + 1))
+	{
+		CHECK(n < res.size() && res[n] == i);
+		n++;
+	}
+	CHECK(n == res.size());
+	return res;
+}
+
+template<typename B>
+void testBasics(B& bits)
+{
+	const int size = bits.size();
+	CHECK(bits.none());
+	CHECK(!bits.any());
+	CHECK(bits.count() == 0);
+	CHECK(bits.findFirstSet() == -1);
+	CHECK(bits.findFirstClear() == 0);
+	CHECK(setBitsOf(bits).size() == 0);
+
+	// Set the bits around the word boundaries
+	cz::TArray<int> expected;
+	for (int i = 0; i < size; i++)
+	{
+		int bitInWord = i % cz::BitsPerWord;
+		if (bitInWord == 0 || bitInWord == 1 || bitInWord == cz::BitsPerWord - 1 || i == size - 1)
+		{
+			bits.set(i);
+			expected.push(i);
+		}
+	}
+
+	CHECK(bits.count() == expected.size());
+	CHECK(bits.any());
+	CHECK(bits.findFirstSet() == 0);
+	cz::TArray<int> found = setBitsOf(bits);
+	CHECK(found.size() == expected.size());
+	for (int i = 0; i < found.size() && i < expected.size(); i++)
+	{
+		CHECK(found[i] == expected[i]);
+	}
+
+	for (int i = 0; i < size; i++)
+	{
+		CHECK(bits.test(i) == expected.find(i));
+		CHECK(bits[i] == bits.test(i));
+	}
+
+	CHECK(bits.findNextSet(size) == -1);
+	CHECK(bits.findNextSet(size - 1) == size - 1);
+	if (size > 2)
+	{
+		CHECK(bits.findNextSet(2) == (size > cz::BitsPerWord - 1 ? cz::BitsPerWord - 1 : size - 1));
+	}
+
+	bits.clear(0);
+	CHECK(!bits.test(0));
+	CHECK(bits.findFirstClear() == 0);
+	CHECK(bits.findFirstSet() == (size > 1 ? 1 : -1));
+	bits.flip(0);
+	CHECK(bits.test(0));
+	bits.set(0, false);
+	CHECK(!bits.test(0));
+	bits.set(0, true);
+	CHECK(bits.test(0));
+
+	bits.setAll();
+	CHECK(bits.all());
+	CHECK(bits.count() == size);
+	CHECK(bits.findFirstClear() == -1);
+	CHECK(setBitsOf(bits).size() == size);
+
+	bits.clear(size - 1);
+	CHECK(!bits.all());
+	CHECK(bits.findFirstClear() == size - 1);
+
+	// Flipping all must not set the unused bits of the last word
+	bits.flipAll();
+	CHECK(bits.count() == 1);
+	CHECK(bits.findFirstSet() == size - 1);
+
+	bits.clearAll();
+	CHECK(bits.none());
+}
+
+}
+
+TEST_CASE("BitArray-static", TEST_TAG)
+{
+	SECTION("size")
+	{
+		CHECK(sizeof(cz::TStaticBitArray<1>) == sizeof(cz::BitWord));
+		CHECK(sizeof(cz::TStaticBitArray<64>) == 64 / 8);
+		CHECK(sizeof(cz::TStaticBitArray<65>) == (64 / 8) + sizeof(cz::BitWord));
+		CHECK(cz::TStaticBitArray<65>::NUM_WORDS == 64 / cz::BitsPerWord + 1);
+	}
+
+	SECTION("basics")
+	{
+		cz::TStaticBitArray<1> b1;
+		testBasics(b1);
+		cz::TStaticBitArray<cz::BitsPerWord> b2;
+		testBasics(b2);
+		cz::TStaticBitArray<100> b3;
+		testBasics(b3);
+	}
+
+	SECTION("bulk operations")
+	{
+		cz::TStaticBitArray<40> a;
+		cz::TStaticBitArray<40> b;
+		a.set(1);
+		a.set(20);
+		a.set(39);
+		b.set(20);
+		b.set(30);
+
+		cz::TStaticBitArray<40> tmp = a;
+		tmp &= b;
+		CHECK(tmp.count() == 1 && tmp.test(20));
+
+		tmp = a;
+		tmp |= b;
+		CHECK(tmp.count() == 4 && tmp.test(1) && tmp.test(20) && tmp.test(30) && tmp.test(39));
+
+		tmp = a;
+		tmp ^= b;
+		CHECK(tmp.count() == 3 && tmp.test(1) && tmp.test(30) && tmp.test(39));
+
+		tmp = a;
+		tmp.clearBits(b);
+		CHECK(tmp.count() == 2 && tmp.test(1) && tmp.test(39));
+
+		CHECK(a == a);
+		CHECK(a != b);
+		tmp = a;
+		CHECK(tmp == a);
+	}
+}
+
+TEST_CASE("BitArray-dynamic", TEST_TAG)
+{
+	SECTION("basics")
+	{
+		for (int size : {1, cz::BitsPerWord - 1, cz::BitsPerWord, cz::BitsPerWord + 1, 100})
+		{
+			cz::TBitArray<> bits(size);
+			CHECK(bits.size() == size);
+			CHECK(bits.capacity() >= size);
+			testBasics(bits);
+		}
+	}
+
+	SECTION("resize and push")
+	{
+		cz::TBitArray<> bits;
+		CHECK(bits.size() == 0);
+		CHECK(bits.none());
+		CHECK(bits.findFirstSet() == -1);
+		CHECK(bits.findFirstClear() == -1);
+		CHECK(bits.all());
+
+		for (int i = 0; i < 70; i++)
+		{
+			CHECK(bits.push(i % 3 == 0));
+		}
+		CHECK(bits.size() == 70);
+		CHECK(bits.count() == 24);
+		CHECK(bits.test(69));
+		CHECK(!bits.test(68));
+
+		// Shrinking drops the bits at the end, and growing again brings back 0s, not the old bits
+		CHECK(bits.resize(10));
+		CHECK(bits.count() == 4);
+		CHECK(bits.resize(70));
+		CHECK(bits.count() == 4);
+		CHECK(bits.findNextSet(10) == -1);
+
+		bits.setAll();
+		CHECK(bits.resize(5));
+		CHECK(bits.count() == 5);
+		CHECK(bits.resize(6));
+		CHECK(bits.count() == 5);
+		CHECK(!bits.test(5));
+
+		CHECK(bits.resize(0));
+		CHECK(bits.none());
+		bits.shrink_to_fit();
+		CHECK(bits.capacity() == 0);
+	}
+
+	SECTION("copy and move")
+	{
+		cz::TBitArray<> a(50);
+		a.set(3);
+		a.set(45);
+
+		cz::TBitArray<> b(a);
+		CHECK(b == a);
+		b.clear(3);
+		CHECK(b != a);
+		b = a;
+		CHECK(b == a);
+
+		cz::TBitArray<> c(std::move(b));
+		CHECK(c == a);
+		CHECK(b.size() == 0);
+
+		cz::TBitArray<> d;
+		d = std::move(c);
+		CHECK(d == a);
+		CHECK(c.size() == 0);
+	}
+
+	SECTION("mixing static and dynamic")
+	{
+		cz::TStaticBitArray<33> s;
+		cz::TBitArray<> d(33);
+		s.set(32);
+		d.set(0);
+		d |= s;
+		CHECK(d.count() == 2);
+		s &= d;
+		CHECK(s.count() == 1);
+		CHECK(!(s == d));
+		s.set(0);
+		CHECK(s == d);
+	}
+}
@@ -0,0 +1,153 @@
+#include <crazygaze/micromuc/BitQueue.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][bitqueue][benchmark]"
+
+namespace
+{
+
+constexpr unsigned int gFrameBits = 4000;
+constexpr int gNumFrames = 500;
+
+// Start at an odd bit position, so the head/tail are never byte aligned
+constexpr unsigned int gOffsetBits = 3;
+
+uint8_t gFrame[gFrameBits / 8];
+
+// Same as what pushBits(const uint8_t*, numBits) did before the word copy, so we have something to compare against
+__attribute__((noinline)) void pushBytes(cz::FixedCapacityBitQueue& q, const uint8_t* src, unsigned int numBits)
+{
+	while (numBits)
+	{
+		unsigned int todo = std::min(numBits, 8U);
+		q.pushBits(*src, todo);
+		src++;
+		numBits -= todo;
+	}
+}
+
+__attribute__((noinline)) void popBytes(cz::FixedCapacityBitQueue& q, uint8_t* dst, unsigned int numBits)
+{
+	while (numBits)
+	{
+		unsigned int todo = std::min(numBits, 8U);
+		q.pop(dst, todo);
+		dst++;
+		numBits -= todo;
+	}
+}
+
+}
+
+TEST_CASE("BitQueue-push/pop throughput", TEST_TAG)
+{
+	static cz::TStaticFixedBitCapacityQueue<gFrameBits + gOffsetBits> q;
+	static uint8_t out[gFrameBits / 8];
+
+	for (unsigned int i = 0; i < sizeof(gFrame); i++)
+	{
+		gFrame[i] = static_cast<uint8_t>(i * 7);
+	}
+
+	q.clear();
+	q.forcePushBits(uint8_t(0), gOffsetBits);
+	q.dropBits(gOffsetBits);
+
+	cz::test::Stopwatch watch;
+	unsigned long pushTime = 0;
+	unsigned long popTime = 0;
+	for (int i = 0; i < gNumFrames; i++)
+	{
+		watch.reset();
+		pushBytes(q, gFrame, gFrameBits);
+		pushTime += watch.elapsedMicros();
+		watch.reset();
+		popBytes(q, out, gFrameBits);
+		popTime += watch.elapsedMicros();
+	}
+	CHECK(memcmp(gFrame, out, sizeof(out)) == 0);
+	cz::test::logThroughput("BitQueue push 8 bits at a time", uint64_t(gFrameBits) * gNumFrames, "bits", pushTime);
+	cz::test::logThroughput("BitQueue pop 8 bits at a time", uint64_t(gFrameBits) * gNumFrames, "bits", popTime);
+
+	pushTime = popTime = 0;
+	memset(out, 0, sizeof(out));
+	for (int i = 0; i < gNumFrames; i++)
+	{
+		watch.reset();
+		q.pushBits(gFrame, gFrameBits);
+		pushTime += watch.elapsedMicros();
+		watch.reset();
+		q.pop(out, gFrameBits);
+		popTime += watch.elapsedMicros();
+	}
+	CHECK(memcmp(gFrame, out, sizeof(out)) == 0);
+	cz::test::logThroughput("BitQueue bulk push", uint64_t(gFrameBits) * gNumFrames, "bits", pushTime);
+	cz::test::logThroughput("BitQueue bulk pop", uint64_t(gFrameBits) * gNumFrames, "bits", popTime);
+}
+
+TEST_CASE("BitQueue-find preamble", TEST_TAG)
+{
+	constexpr unsigned int numBits = 4096;
+	constexpr uint32_t preamble = 0xA55A;
+	static cz::TStaticFixedBitCapacityQueue<numBits> q;
+
+	// Fill the queue with a pattern that doesn't contain the preamble, and put the preamble at the very end
+	q.clear();
+	while (q.availableCapacity() > 16)
+	{
+		q.pushValue(0u, 1);
+	}
+	q.pushValue(preamble, 16);
+	CHECK(q.isFull());
+
+	constexpr int numRuns = 10;
+	cz::test::Stopwatch watch;
+	unsigned int found = 0;
+
+	// getAtIndex, copying 16 bits at every position
+	for (int run = 0; run < numRuns; run++)
+	{
+		for (unsigned int i = 0; i + 16 <= q.size(); i++)
+		{
+			uint16_t val;
+			q.getAtIndex(i, reinterpret_cast<uint8_t*>(&val), 16);
+			if (val == preamble)
+			{
+				found += i;
+				break;
+			}
+		}
+	}
+	cz::test::logBenchmark("BitQueue find preamble with getAtIndex (per position)", numRuns * (numBits - 15), watch.elapsedMicros());
+	CHECK(found == numRuns * (numBits - 16));
+
+	// Cursor::match at every position
+	found = 0;
+	watch.reset();
+	for (int run = 0; run < numRuns; run++)
+	{
+		auto c = q.cursor();
+		while (!c.match(preamble, 16))
+		{
+			c.skip(1);
+		}
+		found += c.position();
+	}
+	cz::test::logBenchmark("BitQueue find preamble with Cursor::match (per position)", numRuns * (numBits - 15), watch.elapsedMicros());
+	CHECK(found == numRuns * (numBits - 16));
+
+	// Cursor::find
+	found = 0;
+	watch.reset();
+	for (int run = 0; run < numRuns; run++)
+	{
+		auto c = q.cursor();
+		if (c.find(preamble, 16))
+		{
+			found += c.position();
+		}
+	}
+	cz::test::logBenchmark("BitQueue find preamble with Cursor::find (per position)", numRuns * (numBits - 15), watch.elapsedMicros());
+	CHECK(found == numRuns * (numBits - 16));
+}
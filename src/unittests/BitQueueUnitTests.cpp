@@ -0,0 +1,415 @@
+#include <crazygaze/micromuc/BitQueue.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][bitqueue]"
+
+namespace
+{
+
+// Small deterministic PRNG, so failures are reproducible
+struct Random
+{
+	uint32_t state = 0x12345678;
+	uint32_t next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	uint32_t next(uint32_t maxInclusive)
+	{
+		return next() % (maxInclusive + 1);
+	}
+};
+
+bool getBit(const uint8_t* data, unsigned int pos)
+{
+	return (data[pos / 8] >> (pos % 8)) & 1;
+}
+
+void setBit(uint8_t* data, unsigned int pos, bool val)
+{
+	data[pos / 8] = (data[pos / 8] & ~(1 << (pos % 8))) | (val << (pos % 8));
+}
+
+/**
+ * Reference model: Bits pushed are appended to a linear array, and never wrap.
+ */
+struct ReferenceBitQueue
+{
+	static constexpr unsigned int MAX_BITS = 32768;
+	uint8_t bits[MAX_BITS / 8];
+	unsigned int head = 0;
+	unsigned int tail = 0;
+
+	void reset()
+	{
+		head = 0;
+		tail = 0;
+	}
+
+	unsigned int size() const
+	{
+		return tail - head;
+	}
+
+	void push(const uint8_t* src, unsigned int numBits)
+	{
+		for (unsigned int i = 0; i < numBits; i++)
+			setBit(bits, tail++, getBit(src, i));
+	}
+
+	bool matches(unsigned int index, const uint8_t* data, unsigned int numBits) const
+	{
+		for (unsigned int i = 0; i < numBits; i++)
+		{
+			if (getBit(bits, head + index + i) != getBit(data, i))
+				return false;
+		}
+		return true;
+	}
+};
+
+}
+
+TEST_CASE("BitQueue-bulk operations against reference", TEST_TAG)
+{
+	Random rnd;
+	const unsigned int capacities[] = {2, 7, 8, 9, 31, 32, 33, 64, 65, 100, 129, 257, 511};
+
+	for (unsigned int capacityBits : capacities)
+	{
+		uint8_t buffer[64];
+		cz::FixedCapacityBitQueue q(buffer, capacityBits);
+		// Static, since it's too big for the stack on the boards
+		static ReferenceBitQueue ref;
+		ref.reset();
+		unsigned int maxBits = capacityBits - 1;
+		bool ok = true;
+
+		while (ok && ref.tail < ReferenceBitQueue::MAX_BITS - 2 * capacityBits)
+		{
+			uint8_t src[72];
+			uint8_t dst[72];
+			for (auto&& b : src)
+				b = static_cast<uint8_t>(rnd.next());
+
+			switch (rnd.next(3))
+			{
+				case 0: // push
+				{
+					unsigned int n = rnd.next(maxBits);
+					bool fits = n <= maxBits - ref.size();
+					ok = ok && (q.pushBits(src, n) == fits);
+					if (fits)
+						ref.push(src, n);
+				}
+				break;
+
+				case 1: // forcePush
+				{
+					unsigned int n = rnd.next(maxBits);
+					q.forcePushBits(src, n);
+					ref.push(src, n);
+					if (ref.size() > maxBits)
+						ref.head = ref.tail - maxBits;
+				}
+				break;
+
+				case 2: // pop. Bits in dst after the popped ones should be preserved
+				{
+					unsigned int n = rnd.next(maxBits);
+					memset(dst, 0xA5, sizeof(dst));
+					unsigned int popped = q.pop(dst, n);
+					ok = ok && popped == std::min(n, ref.size());
+					ok = ok && ref.matches(0, dst, popped);
+					for (unsigned int i = popped; i < popped + 16; i++)
+						ok = ok && getBit(dst, i) == getBit((const uint8_t*)"\xA5\xA5\xA5\xA5\xA5\xA5\xA5\xA5", i % 64);
+					ref.head += popped;
+				}
+				break;
+
+				case 3: // getAtIndex
+				{
+					unsigned int s = ref.size();
+					unsigned int index = rnd.next(s);
+					unsigned int n = rnd.next(s - index);
+					ok = ok && q.getAtIndex(index, dst, n);
+					ok = ok && ref.matches(index, dst, n);
+				}
+				break;
+			}
+
+			ok = ok && q.size() == ref.size();
+		}
+
+		CHECK(ok);
+	}
+}
+
+TEST_CASE("BitQueue-pushValue/popValue", TEST_TAG)
+{
+	cz::TStaticFixedBitCapacityQueue<200> q;
+
+	SECTION("Fields of different widths")
+	{
+		// Move the head/tail so the fields wrap around the end of the buffer
+		q.forcePushBits(uint8_t(0), 5);
+		for (int i = 0; i < 39; i++)
+		{
+			q.forcePushBits(uint8_t(0), 5);
+			q.dropBits(5);
+		}
+		q.dropBits(5);
+
+		CHECK(q.pushValue(uint16_t(0x1ABC), 13));
+		CHECK(q.pushValue(0xABCDEFu, 24));
+		CHECK(q.pushValue(0xDEADBEEFu, 32));
+		CHECK(q.pushValue(0x0123456789ABCDEFull, 64));
+		CHECK(q.pushValue(true, 1));
+		CHECK(q.size() == 13 + 24 + 32 + 64 + 1);
+
+		CHECK(q.popValue<uint16_t>(13) == 0x1ABC);
+		CHECK(q.popValue<uint32_t>(24) == 0xABCDEF);
+		CHECK(q.popValue<uint32_t>(32) == 0xDEADBEEF);
+		CHECK(q.popValue<uint64_t>(64) == 0x0123456789ABCDEFull);
+		CHECK(q.popValue<bool>(1) == true);
+		CHECK(q.isEmpty());
+	}
+
+	SECTION("Only the lower numBits are pushed")
+	{
+		CHECK(q.pushValue(0xFFFFFFFFu, 4));
+		CHECK(q.size() == 4);
+		CHECK(q.popValue<uint32_t>(4) == 0xF);
+	}
+
+	SECTION("Signed values are sign extended")
+	{
+		CHECK(q.pushValue(int16_t(-1000), 13));
+		CHECK(q.pushValue(int32_t(1000), 13));
+		CHECK(q.pushValue(int64_t(-5), 40));
+		CHECK(q.popValue<int16_t>(13) == -1000);
+		CHECK(q.popValue<int32_t>(13) == 1000);
+		CHECK(q.popValue<int64_t>(40) == -5);
+	}
+
+	SECTION("Same bit order as pushBits")
+	{
+		const uint8_t bytes[3] = {0x12, 0x34, 0x56};
+		CHECK(q.pushBits(bytes, 20));
+		CHECK(q.popValue<uint32_t>(20) == 0x63412);
+		CHECK(q.pushValue(0x63412u, 20));
+		uint8_t out[3] = {};
+		CHECK(q.pop(out, 20) == 20);
+		CHECK(out[0] == 0x12 && out[1] == 0x34 && out[2] == 0x06);
+	}
+
+	SECTION("Not enough space or bits")
+	{
+		for (int i = 0; i < 6; i++)
+			CHECK(q.pushValue(uint32_t(i), 32));
+		CHECK(q.pushValue(uint16_t(0), 9) == false);
+		CHECK(q.pushValue(uint8_t(0xFF), 8));
+		CHECK(q.isFull());
+
+		uint64_t val = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			CHECK(q.popValue(val, 64));
+		}
+		CHECK(q.popValue(val, 9) == false);
+		CHECK(q.popValue(val, 8));
+		CHECK(val == 0xFF);
+	}
+}
+
+TEST_CASE("BitQueue-Cursor", TEST_TAG)
+{
+	cz::TStaticFixedBitCapacityQueue<100> q;
+
+	// Move the head/tail so the data wraps around the end of the buffer
+	q.forcePushBits(uint8_t(0), 7);
+	for (int i = 0; i < 12; i++)
+	{
+		q.forcePushBits(uint8_t(0), 7);
+		q.dropBits(7);
+	}
+	q.dropBits(7);
+
+	q.pushValue(0x5u, 3);
+	q.pushValue(0xABCDu, 16);
+	q.pushValue(0x3u, 2);
+	q.pushValue(0xABCDu, 16);
+
+	SECTION("readBits/skip")
+	{
+		auto c = q.cursor();
+		CHECK(c.position() == 0);
+		CHECK(c.remaining() == 37);
+		uint32_t val;
+		CHECK(c.readBits(val, 3) && val == 0x5);
+		CHECK(c.readBits(val, 16) && val == 0xABCD);
+		CHECK(c.position() == 19);
+		CHECK(c.skip(2));
+		CHECK(c.readBits(val, 16) && val == 0xABCD);
+		CHECK(c.remaining() == 0);
+		CHECK(c.readBits(val, 1) == false);
+		CHECK(c.skip(1) == false);
+
+		// The queue is not changed
+		CHECK(q.size() == 37);
+		CHECK(q.popValue<uint32_t>(3) == 0x5);
+	}
+
+	SECTION("match/find")
+	{
+		auto c = q.cursor();
+		CHECK(c.match(0x5, 3));
+		CHECK(c.match(0x5 | (0xABCD << 3), 19));
+		CHECK(c.match(0x4, 3) == false);
+		CHECK(c.position() == 0);
+
+		CHECK(c.find(0xABCD, 16));
+		CHECK(c.position() == 3);
+		CHECK(c.skip(1));
+		CHECK(c.find(0xABCD, 16));
+		CHECK(c.position() == 21);
+
+		// Dropping up to the cursor leaves the match at the head
+		q.dropBits(c.position());
+		CHECK(q.popValue<uint32_t>(16) == 0xABCD);
+	}
+
+	SECTION("find not found")
+	{
+		auto c = q.cursor();
+		CHECK(c.find(0xFFFF, 16) == false);
+		CHECK(c.remaining() == 15);
+		auto c2 = q.cursor();
+		CHECK(c2.skip(30));
+		CHECK(c2.find(0xABCD, 16) == false);
+		CHECK(c2.position() == 30);
+	}
+}
+
+TEST_CASE("SPSCBitQueue-push/pop", TEST_TAG)
+{
+	cz::TStaticSPSCFixedBitCapacityQueue<40> q;
+	CHECK(q.isEmpty());
+	CHECK(q.capacity() == 40);
+	CHECK(q.availableCapacity() == 40);
+
+	SECTION("Should wrap around")
+	{
+		for (int i = 0; i < 50; i++)
+		{
+			CHECK(q.pushValue(uint32_t(i * 3), 13));
+			CHECK(q.pushBits(uint8_t(i), 5));
+			const uint8_t bytes[2] = {uint8_t(i), uint8_t(~i)};
+			CHECK(q.pushBits(bytes, 16));
+			CHECK(q.size() == 34);
+
+			CHECK(q.popValue<uint32_t>(13) == uint32_t(i * 3) % (1 << 13));
+			uint8_t b = 0;
+			CHECK(q.popValue(b, 5) && b == (i & 0x1F));
+			uint8_t out[2];
+			CHECK(q.getAtIndex(0, out, 16));
+			CHECK(out[0] == uint8_t(i) && out[1] == uint8_t(~i));
+			CHECK(q.pop(out, 16) == 16);
+			CHECK(out[0] == uint8_t(i) && out[1] == uint8_t(~i));
+			CHECK(q.isEmpty());
+		}
+		CHECK(q.droppedBits() == 0);
+	}
+
+	SECTION("Overflow drops the new bits and never touches the head")
+	{
+		CHECK(q.pushValue(0xABCDEFu, 24));
+		CHECK(q.pushValue(0xFFFFu, 16));
+		CHECK(q.pushBits(uint8_t(1), 1) == false);
+		CHECK(q.pushValue(0u, 9) == false);
+		CHECK(q.droppedBits() == 10);
+		CHECK(q.popValue<uint32_t>(24) == 0xABCDEF);
+		CHECK(q.pushValue(0x123u, 9));
+		CHECK(q.popValue<uint32_t>(16) == 0xFFFF);
+		CHECK(q.popValue<uint32_t>(9) == 0x123);
+	}
+
+	SECTION("dropBits/clear")
+	{
+		q.pushValue(0xFFu, 8);
+		q.dropBits(3);
+		CHECK(q.size() == 5);
+		q.dropBits(100);
+		CHECK(q.isEmpty());
+		q.pushValue(0xFFu, 8);
+		q.clear();
+		CHECK(q.isEmpty());
+	}
+}
+
+#if CZ_TEST_HAS_CONCURRENCY
+
+TEST_CASE("SPSCBitQueue-stress", TEST_TAG)
+{
+	constexpr uint32_t numItems = 500000;
+	// 13 bits per item, so items are never byte aligned
+	constexpr unsigned int itemBits = 13;
+	static cz::TStaticSPSCFixedBitCapacityQueue<301> q;
+	q.clear();
+
+	auto producer = []()
+	{
+		for (uint32_t i = 0; i < numItems; )
+		{
+			// Alternate between the value and the bulk push
+			bool ok;
+			if (i & 1)
+			{
+				ok = q.pushValue(i, itemBits);
+			}
+			else
+			{
+				uint16_t val = static_cast<uint16_t>(i);
+				uint8_t bytes[2] = {uint8_t(val), uint8_t(val >> 8)};
+				ok = q.pushBits(bytes, itemBits);
+			}
+
+			if (ok)
+				i++;
+			else
+				cz::test::spinPause();
+		}
+	};
+
+	uint32_t received = 0;
+	uint32_t errors = 0;
+	auto consumer = [&received, &errors]()
+	{
+		while (received != numItems)
+		{
+			uint32_t val;
+			if (q.popValue(val, itemBits))
+			{
+				if (val != (received & ((1 << itemBits) - 1)))
+					errors++;
+				received++;
+			}
+			else
+			{
+				cz::test::spinPause();
+			}
+		}
+	};
+
+	cz::test::runConcurrently(producer, consumer);
+	CHECK(received == numItems);
+	CHECK(errors == 0);
+	CHECK(q.isEmpty());
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include <crazygaze/micromuc/ChunkedArray.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][chunkedarray][benchmark]"
+
+namespace
+{
+
+#if CZ_TEST_HOST
+constexpr int gNumEvents = 50000;
+#elif defined(__AVR__)
+constexpr int gNumEvents = 200;
+#else
+// TArray needs the old and new blocks while growing, so this peaks at about 48KB
+constexpr int gNumEvents = 4000;
+#endif
+
+struct Event
+{
+	uint32_t time;
+	uint16_t type;
+	uint16_t data;
+};
+
+template<typename A>
+__attribute__((noinline)) bool logEvents(A& log)
+{
+	bool ok = true;
+	for(int i = 0; i < gNumEvents; i++)
+	{
+		ok &= log.push(Event{static_cast<uint32_t>(i), static_cast<uint16_t>(i % 7), static_cast<uint16_t>(i)});
+	}
+	return ok;
+}
+
+template<typename A>
+__attribute__((noinline)) uint32_t sumEvents(const A& log)
+{
+	uint32_t sum = 0;
+	for(auto&& e : log)
+	{
+		sum += e.data;
+	}
+	return sum;
+}
+
+template<typename A>
+uint32_t runLogBenchmark(const char* name)
+{
+	cz::test::PeakTrackingAllocator::reset();
+	char buf[100];
+	uint32_t sum;
+	{
+		A log;
+		cz::test::Stopwatch watch;
+		bool ok = logEvents(log);
+		unsigned long elapsed = watch.elapsedMicros();
+		CHECK(ok);
+		CHECK(log.size() == gNumEvents);
+		snprintf(buf, sizeof(buf), "%s append (%d allocations, %lu bytes peak)", name,
+			cz::test::PeakTrackingAllocator::ms_count,
+			static_cast<unsigned long>(cz::test::PeakTrackingAllocator::ms_peak));
+		cz::test::logBenchmark(buf, gNumEvents, elapsed);
+
+		watch.reset();
+		sum = sumEvents(log);
+		elapsed = watch.elapsedMicros();
+		snprintf(buf, sizeof(buf), "%s iterate", name);
+		cz::test::logBenchmark(buf, gNumEvents, elapsed);
+	}
+	CHECK(cz::test::PeakTrackingAllocator::ms_used == 0);
+	return sum;
+}
+
+}
+
+TEST_CASE("ChunkedArray-event log", TEST_TAG)
+{
+	uint32_t sumArray = runLogBenchmark<cz::TArray<Event, cz::test::PeakTrackingAllocator>>("TArray<Event>");
+	uint32_t sumChunked =
+		runLogBenchmark<cz::TChunkedArray<Event, 256, cz::test::PeakTrackingAllocator>>("TChunkedArray<Event, 256>");
+	CHECK(sumArray == sumChunked);
+}
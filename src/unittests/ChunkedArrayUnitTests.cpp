@@ -0,0 +1,157 @@
+#include <crazygaze/micromuc/ChunkedArray.h>
+#include <crazygaze/micromuc/Allocator.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+#include <string>
+
+#define TEST_TAG "[czmicromuc][chunkedarray]"
+
+using cz::test::equals;
+
+TEST_CASE("ChunkedArray", TEST_TAG)
+{
+	SECTION("basics")
+	{
+		cz::TChunkedArray<int, 4> a;
+		CHECK(a.size() == 0);
+		CHECK(a.capacity() == 0);
+		CHECK(a.begin() == a.end());
+
+		for (int i = 0; i < 10; i++)
+		{
+			CHECK(a.push(i));
+		}
+		CHECK(a.size() == 10);
+		CHECK(a.capacity() == 12);
+		CHECK(equals(a, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+		CHECK(a[5] == 5);
+		CHECK(a.front() == 0);
+		CHECK(a.back() == 9);
+
+		int idx = -1;
+		CHECK(a.find(6, idx) && idx == 6);
+		CHECK(!a.find(10));
+
+		int val;
+		CHECK(a.pop(val) && val == 9);
+		CHECK(a.removeAtIndexAndFillWithLast(1));
+		CHECK(equals(a, {0, 8, 2, 3, 4, 5, 6, 7}));
+
+		a.clear();
+		CHECK(a.size() == 0);
+		CHECK(a.capacity() == 12);
+		a.shrink_to_fit();
+		CHECK(a.capacity() == 0);
+	}
+
+	SECTION("elements are never moved")
+	{
+		cz::TChunkedArray<int, 8> a;
+		a.push(0);
+		int* first = &a[0];
+		int* ptrs[100];
+		for (int i = 0; i < 100; i++)
+		{
+			a.push(i + 1);
+			ptrs[i] = &a.last();
+		}
+		// Pushing an element of the array itself
+		a.push(a[0]);
+
+		bool ok = first == &a[0];
+		for (int i = 0; i < 100; i++)
+		{
+			ok = ok && ptrs[i] == &a[i + 1] && *ptrs[i] == i + 1;
+		}
+		CHECK(ok);
+		CHECK(a.last() == 0);
+	}
+
+	SECTION("reserve and resize")
+	{
+		cz::TChunkedArray<int, 16> a;
+		CHECK(a.reserve(17));
+		CHECK(a.capacity() == 32);
+		a.resize(20);
+		CHECK(a.size() == 20);
+		CHECK(a[19] == 0);
+		a.resize(3);
+		CHECK(a.size() == 3);
+		a.shrink_to_fit();
+		CHECK(a.capacity() == 16);
+	}
+
+	SECTION("copy and move")
+	{
+		cz::TChunkedArray<std::string, 2> a;
+		for (int i = 0; i < 5; i++)
+		{
+			a.push(std::to_string(i) + " with some padding to avoid the small string optimization");
+		}
+
+		cz::TChunkedArray<std::string, 2> b(a);
+		CHECK(b.size() == 5);
+		CHECK(b[4] == a[4]);
+
+		const std::string* p = &a[3];
+		cz::TChunkedArray<std::string, 2> c(std::move(a));
+		CHECK(a.size() == 0);
+		CHECK(&c[3] == p);
+
+		b = c;
+		CHECK(b.size() == 5);
+		c.push("x");
+		b = std::move(c);
+		CHECK(b.size() == 6);
+		CHECK(b.last() == "x");
+
+		int count = 0;
+		for (auto&& s : b)
+		{
+			count += s.size() ? 1 : 0;
+		}
+		CHECK(count == 6);
+	}
+
+	SECTION("append")
+	{
+		cz::TChunkedArray<int, 2> a;
+		const int data[] = {1, 2, 3};
+		CHECK(a.append(data, 3));
+		CHECK(a.append(a));
+		CHECK(equals(a, {1, 2, 3, 1, 2, 3}));
+	}
+
+	SECTION("out of memory")
+	{
+		cz::TStaticArenaAllocator<256> arena;
+		cz::TChunkedArray<int, 8, cz::TAllocatorRef<cz::ArenaAllocator>> a(arena);
+		for (int i = 0; i < 10; i++)
+		{
+			CHECK(a.push(i));
+		}
+
+		// The chunk table has space for 16 chunks, but the arena runs out before that. The chunks that were allocated
+		// are kept, and the elements are not touched
+		CHECK(!a.reserve(16 * 8));
+		int capacity = a.capacity();
+		CHECK(capacity > 16 && capacity < 16 * 8);
+		CHECK(a.size() == 10);
+		CHECK(a[0] == 0 && a[9] == 9);
+
+		// The reserved chunks are used without allocating
+		size_t used = arena.used();
+		CHECK(a.resize(capacity));
+		CHECK(arena.used() == used);
+
+		// resize keeps the elements that fit
+		CHECK(!a.resize(capacity + 100));
+		CHECK(a.size() == capacity);
+		CHECK(a[9] == 9 && a.last() == 0);
+		CHECK(!a.push(1));
+		CHECK(a.size() == capacity);
+
+		CHECK(a.resize(3));
+		CHECK(equals(a, {0, 1, 2}));
+	}
+}
@@ -0,0 +1,61 @@
+#include <crazygaze/micromuc/Deque.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][deque][benchmark]"
+
+namespace
+{
+
+#ifdef __AVR__
+constexpr int gBurstSize = 32;
+constexpr int gNumBursts = 50;
+#else
+constexpr int gBurstSize = 128;
+constexpr int gNumBursts = 400;
+#endif
+
+// Work list that gets bursts of items, and processes half of each burst before the next one arrives, so it grows
+// to hold several bursts.
+template<typename W, typename PopFront>
+__attribute__((noinline)) uint32_t processBursts(W& work, PopFront&& popFront)
+{
+	uint32_t sum = 0;
+	for (int burst = 0; burst < gNumBursts; burst++)
+	{
+		for (int i = 0; i < gBurstSize; i++)
+		{
+			work.push_back(i);
+		}
+
+		int todo = burst == gNumBursts - 1 ? work.size() : gBurstSize / 2;
+		for (int i = 0; i < todo; i++)
+		{
+			sum += work.front();
+			popFront(work);
+		}
+	}
+	return sum;
+}
+
+template<typename W, typename PopFront>
+uint32_t runBurstBenchmark(const char* name, PopFront&& popFront)
+{
+	W work;
+	cz::test::Stopwatch watch;
+	volatile uint32_t sum = processBursts(work, popFront);
+	cz::test::logBenchmark(name, gBurstSize * gNumBursts, watch.elapsedMicros());
+	return sum;
+}
+
+}
+
+TEST_CASE("Deque-bursty work list", TEST_TAG)
+{
+	// What we did before TDeque: TArray with removeAtIndex(0), which moves all the other elements
+	uint32_t sumArray = runBurstBenchmark<cz::TArray<int>>("TArray<int> push_back+removeAtIndex(0)",
+		[](cz::TArray<int>& a) { a.removeAtIndex(0); });
+	uint32_t sumDeque = runBurstBenchmark<cz::TDeque<int>>("TDeque<int> push_back+pop_front",
+		[](cz::TDeque<int>& d) { d.pop_front(); });
+	CHECK(sumArray == sumDeque);
+}
@@ -0,0 +1,220 @@
+#include <crazygaze/micromuc/Deque.h>
+#include <crazygaze/micromuc/Allocator.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+#include <string>
+
+#define TEST_TAG "[czmicromuc][deque]"
+
+namespace
+{
+
+using cz::test::equals;
+
+std::string makeString(int i)
+{
+	return std::to_string(i) + " with some padding to avoid the small string optimization";
+}
+
+}
+
+TEST_CASE("Deque", TEST_TAG)
+{
+	SECTION("basics")
+	{
+		cz::TDeque<int> d;
+		CHECK(d.isEmpty());
+		CHECK(d.size() == 0);
+		CHECK(d.capacity() == 0);
+		CHECK(d.begin() == d.end());
+		CHECK(!d.popFront());
+		CHECK(!d.popBack());
+		CHECK(!d.find(0));
+
+		CHECK(d.pushBack(1));
+		CHECK(d.pushBack(2));
+		CHECK(d.pushFront(0));
+		CHECK(d.pushFront(-1));
+		CHECK(equals(d, {-1, 0, 1, 2}));
+		CHECK(d.front() == -1);
+		CHECK(d.back() == 2);
+		CHECK(d.capacity() == 8);
+
+		int val;
+		CHECK(d.popFront(val) && val == -1);
+		CHECK(d.popBack(val) && val == 2);
+		CHECK(equals(d, {0, 1}));
+
+		d.clear();
+		CHECK(d.isEmpty());
+		CHECK(d.capacity() == 8);
+		d.shrink_to_fit();
+		CHECK(d.capacity() == 0);
+	}
+
+	SECTION("wrapping and growing")
+	{
+		cz::TDeque<int> d;
+		// Move the head around the buffer before it grows, so growing needs to unwrap the elements
+		for (int i = 0; i < 6; i++)
+		{
+			d.pushBack(i);
+		}
+		for (int i = 0; i < 5; i++)
+		{
+			d.popFront();
+		}
+		for (int i = 6; i < 13; i++)
+		{
+			d.pushBack(i);
+		}
+		CHECK(d.capacity() == 8);
+		CHECK(equals(d, {5, 6, 7, 8, 9, 10, 11, 12}));
+
+		int idx = -1;
+		CHECK(d.find(6, idx) && idx == 1);
+		CHECK(d.find(12, idx) && idx == 7);
+		CHECK(!d.find(4));
+
+		d.pushFront(4);
+		CHECK(d.capacity() == 16);
+		CHECK(equals(d, {4, 5, 6, 7, 8, 9, 10, 11, 12}));
+		CHECK(d.find(12, idx) && idx == 8);
+
+		// Pushing to the front wraps the head to the end of the buffer
+		d.clear();
+		d.pushFront(1);
+		d.pushFront(0);
+		d.pushBack(2);
+		CHECK(equals(d, {0, 1, 2}));
+		CHECK(d.find(2, idx) && idx == 2);
+	}
+
+	SECTION("work list")
+	{
+		// Compare against a TArray, with pushes and pops at both ends
+		cz::TDeque<int> d;
+		cz::TArray<int> a;
+		bool ok = true;
+		for (int i = 0; i < 1000; i++)
+		{
+			switch ((i * 7) % 5)
+			{
+				case 0: d.pushFront(i); a.insertAtIndex(0, i); break;
+				case 1:
+				case 2: d.pushBack(i); a.push(i); break;
+				case 3: d.popFront(); a.removeAtIndex(0); break;
+				case 4: d.popBack(); a.pop(); break;
+			}
+
+			ok = ok && d.size() == a.size();
+			for (int j = 0; ok && j < a.size(); j++)
+			{
+				ok = d[j] == a[j];
+			}
+		}
+		CHECK(ok);
+	}
+
+	SECTION("pushing an element of the deque itself")
+	{
+		cz::TDeque<std::string> d;
+		for (int i = 0; i < 8; i++)
+		{
+			d.push_back(makeString(i));
+		}
+		CHECK(d.size() == d.capacity());
+		d.push_back(d.front());
+		d.push_front(d.back());
+		CHECK(d.size() == 10);
+		CHECK(d.front() == makeString(0));
+		CHECK(d.back() == makeString(0));
+		CHECK(d[1] == makeString(0));
+	}
+
+	SECTION("copy and move")
+	{
+		cz::TDeque<std::string> a;
+		for (int i = 0; i < 5; i++)
+		{
+			a.push_front(makeString(i));
+		}
+
+		cz::TDeque<std::string> b(a);
+		CHECK(b.size() == 5);
+		CHECK(b[4] == a[4]);
+		CHECK(b.front() == makeString(4));
+
+		const std::string* p = &a[3];
+		cz::TDeque<std::string> c(std::move(a));
+		CHECK(a.size() == 0);
+		CHECK(&c[3] == p);
+
+		b = c;
+		CHECK(b.size() == 5);
+		c.push_back("x");
+		b = std::move(c);
+		CHECK(b.size() == 6);
+		CHECK(b.back() == "x");
+
+		CHECK(b.append(b));
+		CHECK(b.size() == 12);
+		CHECK(b[6] == makeString(4));
+		CHECK(b.back() == "x");
+	}
+
+	SECTION("reserve")
+	{
+		cz::TDeque<int> d;
+		CHECK(d.reserve(9));
+		CHECK(d.capacity() == 16);
+		CHECK(d.reserve(3));
+		CHECK(d.capacity() == 16);
+		d.pushBack(1);
+		d.shrink_to_fit();
+		CHECK(d.capacity() == 8);
+	}
+
+	SECTION("out of memory")
+	{
+		cz::TStaticArenaAllocator<512> arena;
+		cz::TDeque<std::string, cz::TAllocatorRef<cz::ArenaAllocator>> d(arena);
+		// Full, and wrapped around the end of the buffer
+		for (int i = 0; i < 8; i++)
+		{
+			CHECK(d.pushBack(makeString(i)));
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			CHECK(d.popFront());
+			CHECK(d.pushBack(makeString(8 + i)));
+		}
+		CHECK(d.size() == d.capacity());
+
+		// Use up what's left of the arena, so it can't grow
+		while (arena.allocate(1))
+		{
+		}
+
+		// Failing to grow at either end leaves the elements as they were, including when adding elements of the
+		// deque itself
+		int capacity = d.capacity();
+		CHECK(!d.emplace_front(makeString(-1)));
+		CHECK(!d.pushFront(d.back()));
+		CHECK(!d.pushBack(d.front()));
+		CHECK(d.size() == capacity);
+		CHECK(d.capacity() == capacity);
+		bool ok = true;
+		for (int i = 0; i < capacity; i++)
+		{
+			ok = ok && d[i] == makeString(3 + i);
+		}
+		CHECK(ok);
+
+		// It can still be used within its capacity
+		CHECK(d.popBack());
+		CHECK(d.emplace_front(makeString(2)));
+		CHECK(d.front() == makeString(2));
+		CHECK(d.back() == makeString(capacity + 1));
+	}
+}
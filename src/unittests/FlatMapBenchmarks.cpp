@@ -0,0 +1,82 @@
+#include <crazygaze/micromuc/FlatMap.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][flatmap][benchmark]"
+
+namespace
+{
+
+constexpr int gNumLookups = 20000;
+
+struct Device
+{
+	uint32_t id;
+	uint32_t pin;
+	bool operator==(const Device& other) const { return id == other.id; }
+};
+
+// Linear search in a TArray, which is what we had before TFlatMap
+template<int N>
+__attribute__((noinline)) uint32_t lookupLinear(const cz::TArray<Device>& devices)
+{
+	uint32_t sum = 0;
+	for(int i = 0; i < gNumLookups; i++)
+	{
+		int idx;
+		if (devices.find(Device{static_cast<uint32_t>((i * 7919) % N) * 3, 0}, idx))
+			sum += devices[idx].pin;
+	}
+	return sum;
+}
+
+template<int N>
+__attribute__((noinline)) uint32_t lookupFlat(const cz::TStaticFlatMap<uint32_t, uint32_t, N>& devices)
+{
+	uint32_t sum = 0;
+	for(int i = 0; i < gNumLookups; i++)
+	{
+		if (const uint32_t* pin = devices.find(static_cast<uint32_t>((i * 7919) % N) * 3))
+			sum += *pin;
+	}
+	return sum;
+}
+
+template<int N>
+void runLookupBenchmark()
+{
+	cz::TArray<Device> linear;
+	static cz::TStaticFlatMap<uint32_t, uint32_t, N> flat;
+	flat.clear();
+	for(int i = 0; i < N; i++)
+	{
+		uint32_t id = static_cast<uint32_t>((i * 31) % N) * 3;
+		linear.push(Device{id, static_cast<uint32_t>(i)});
+		flat.addUnsorted(id, static_cast<uint32_t>(i));
+	}
+	flat.sort();
+
+	char name[64];
+	cz::test::Stopwatch watch;
+	volatile uint32_t sumLinear = lookupLinear<N>(linear);
+	unsigned long elapsed = watch.elapsedMicros();
+	snprintf(name, sizeof(name), "TArray::find, %d entries", N);
+	cz::test::logBenchmark(name, gNumLookups, elapsed);
+
+	watch.reset();
+	volatile uint32_t sumFlat = lookupFlat<N>(flat);
+	elapsed = watch.elapsedMicros();
+	snprintf(name, sizeof(name), "TStaticFlatMap::find, %d entries", N);
+	cz::test::logBenchmark(name, gNumLookups, elapsed);
+
+	CHECK(sumLinear == sumFlat);
+}
+
+}
+
+TEST_CASE("FlatMap-lookup", TEST_TAG)
+{
+	runLookupBenchmark<8>();
+	runLookupBenchmark<32>();
+	runLookupBenchmark<128>();
+}
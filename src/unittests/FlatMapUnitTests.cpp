@@ -0,0 +1,159 @@
+#include <crazygaze/micromuc/FlatMap.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][flatmap]"
+
+namespace
+{
+
+using cz::test::equals;
+
+template<class S>
+void testSet(S& s)
+{
+	CHECK(s.empty());
+	CHECK(s.insert(5));
+	CHECK(s.insert(1));
+	CHECK(s.insert(3));
+	CHECK(!s.insert(3));
+	CHECK(equals(s, {1, 3, 5}));
+	CHECK(s.isSorted());
+
+	CHECK(s.contains(3));
+	CHECK(!s.contains(4));
+	CHECK(s.indexOf(5) == 2);
+	CHECK(s.indexOf(0) == -1);
+	CHECK(s.indexOf(6) == -1);
+	CHECK(s.lowerBound(4) == 2);
+	CHECK(s.find(1) && *s.find(1) == 1);
+	CHECK(s.find(2) == nullptr);
+
+	CHECK(s.erase(3));
+	CHECK(!s.erase(3));
+	CHECK(equals(s, {1, 5}));
+
+	s.clear();
+	const int keys[] = {9, 2, 7, 2, 4, 9};
+	CHECK(s.assign(keys, 6));
+	CHECK(equals(s, {2, 4, 7, 9}));
+
+	for (int i = 0; i < 3; i++)
+	{
+		s.addUnsorted(10 - i);
+	}
+	CHECK(!s.isSorted());
+	s.sort();
+	CHECK(equals(s, {2, 4, 7, 8, 9, 10}));
+
+	CHECK(s.eraseIf([](int v) { return v % 2 == 0; }) == 4);
+	CHECK(equals(s, {7, 9}));
+}
+
+}
+
+TEST_CASE("FlatSet", TEST_TAG)
+{
+	SECTION("dynamic")
+	{
+		cz::TFlatSet<int> s;
+		testSet(s);
+	}
+
+	SECTION("static")
+	{
+		cz::TStaticFlatSet<int, 8> s;
+		testSet(s);
+		CHECK(s.capacity() == 8);
+		for (int i = 0; i < 6; i++)
+		{
+			CHECK(s.insert(i));
+		}
+		CHECK(s.size() == 8);
+		CHECK(!s.insert(100));
+		CHECK(!s.addUnsorted(100));
+	}
+
+	SECTION("custom compare")
+	{
+		cz::TFlatSet<int, std::greater<int>> s;
+		s.insert(1);
+		s.insert(3);
+		s.insert(2);
+		CHECK(equals(s, {3, 2, 1}));
+		CHECK(s.contains(2));
+	}
+}
+
+TEST_CASE("FlatMap", TEST_TAG)
+{
+	SECTION("dynamic")
+	{
+		cz::TFlatMap<int, const char*> m;
+		CHECK(m.insert(20, "twenty"));
+		CHECK(m.insert(10, "ten"));
+		CHECK(!m.insert(10, "TEN"));
+		CHECK(m.set(30, "thirty"));
+		CHECK(m.set(10, "TEN"));
+		CHECK(m.size() == 3);
+		CHECK(m.isSorted());
+
+		CHECK(m.find(10) && strcmp(*m.find(10), "TEN") == 0);
+		CHECK(m.find(15) == nullptr);
+		*m.find(20) = "Twenty";
+
+		int expected[] = {10, 20, 30};
+		int idx = 0;
+		for (auto&& e : m)
+		{
+			CHECK(e.key == expected[idx++]);
+		}
+		CHECK(strcmp(m[1].value, "Twenty") == 0);
+
+		CHECK(m.erase(20));
+		CHECK(!m.contains(20));
+		CHECK(m.size() == 2);
+	}
+
+	SECTION("bulk build")
+	{
+		cz::TStaticFlatMap<uint8_t, int, 8> m;
+		CHECK(m.addUnsorted(7, 70));
+		CHECK(m.addUnsorted(3, 30));
+		CHECK(m.addUnsorted(7, 71));
+		CHECK(m.addUnsorted(1, 10));
+		m.sort();
+		CHECK(m.isSorted());
+		CHECK(m.size() == 3);
+		// Duplicates keep the first added
+		CHECK(*m.find(7) == 70);
+		CHECK(*m.find(1) == 10);
+
+		const cz::TFlatMapEntry<uint8_t, int> entries[] = {{5, 50}, {2, 20}};
+		CHECK(m.assign(entries, 2));
+		CHECK(m.size() == 2);
+		CHECK(m[0].key == 2 && m[1].key == 5);
+		CHECK(!m.contains(7));
+	}
+
+	SECTION("bulk build with many duplicates")
+	{
+		// Scrambled keys with several duplicates each, to check sort is stable regardless of the order
+		cz::TStaticFlatMap<int, int, 64> m;
+		for (int i = 0; i < 64; i++)
+		{
+			CHECK(m.addUnsorted((i * 37) % 16, i));
+		}
+		m.sort();
+		CHECK(m.isSorted());
+		CHECK(m.size() == 16);
+		bool ok = true;
+		for (int i = 0; i < 16; i++)
+		{
+			// The first i with (i*37)%16 == key
+			int first = (i * 13) % 16;
+			ok = ok && m[i].key == i && m[i].value == first;
+		}
+		CHECK(ok);
+	}
+}
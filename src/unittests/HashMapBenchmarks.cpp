@@ -0,0 +1,166 @@
+#include <crazygaze/micromuc/HashMap.h>
+#include <crazygaze/micromuc/FlatMap.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#ifndef __AVR__
+	#include <unordered_map>
+#endif
+
+#define TEST_TAG "[czmicromuc][hashmap][benchmark]"
+
+namespace
+{
+
+constexpr int gNumLookups = 20000;
+
+// Smallest power of 2 number of slots to keep the load at or below 75%
+constexpr int slotsFor(int n)
+{
+	int slots = 16;
+	while (slots * 3 < n * 4)
+		slots *= 2;
+	return slots;
+}
+
+uint32_t sensorId(int i)
+{
+	return static_cast<uint32_t>(i) * 2654435761u;
+}
+
+template<typename M>
+__attribute__((noinline)) uint32_t lookup(const M& m, int n)
+{
+	uint32_t sum = 0;
+	for(int i = 0; i < gNumLookups; i++)
+	{
+		if (const uint32_t* v = m.find(sensorId((i * 7919) % n)))
+			sum += *v;
+	}
+	return sum;
+}
+
+#ifndef __AVR__
+__attribute__((noinline)) uint32_t lookupStd(const std::unordered_map<uint32_t, uint32_t>& m, int n)
+{
+	uint32_t sum = 0;
+	for(int i = 0; i < gNumLookups; i++)
+	{
+		auto it = m.find(sensorId((i * 7919) % n));
+		if (it != m.end())
+			sum += it->second;
+	}
+	return sum;
+}
+#endif
+
+template<int N>
+void runLookupBenchmark()
+{
+	static cz::TStaticFlatMap<uint32_t, uint32_t, N> flat;
+	static cz::TStaticHashMap<uint32_t, uint32_t, slotsFor(N)> hash;
+	flat.clear();
+	hash.clear();
+	for(int i = 0; i < N; i++)
+	{
+		flat.addUnsorted(sensorId(i), static_cast<uint32_t>(i));
+		hash.insert(sensorId(i), static_cast<uint32_t>(i));
+	}
+	flat.sort();
+
+	char name[64];
+	cz::test::Stopwatch watch;
+	volatile uint32_t sumFlat = lookup(flat, N);
+	unsigned long elapsed = watch.elapsedMicros();
+	snprintf(name, sizeof(name), "TStaticFlatMap::find, %d entries", N);
+	cz::test::logBenchmark(name, gNumLookups, elapsed);
+
+	watch.reset();
+	volatile uint32_t sumHash = lookup(hash, N);
+	elapsed = watch.elapsedMicros();
+	snprintf(name, sizeof(name), "TStaticHashMap::find, %d entries", N);
+	cz::test::logBenchmark(name, gNumLookups, elapsed);
+	CHECK(sumFlat == sumHash);
+
+#ifndef __AVR__
+	std::unordered_map<uint32_t, uint32_t> stdMap;
+	for(int i = 0; i < N; i++)
+	{
+		stdMap[sensorId(i)] = static_cast<uint32_t>(i);
+	}
+	watch.reset();
+	volatile uint32_t sumStd = lookupStd(stdMap, N);
+	elapsed = watch.elapsedMicros();
+	snprintf(name, sizeof(name), "std::unordered_map::find, %d entries", N);
+	cz::test::logBenchmark(name, gNumLookups, elapsed);
+	CHECK(sumFlat == sumStd);
+#endif
+}
+
+const char* const gCommands[] = {
+	"ping", "reset", "status", "led_on", "led_off", "read_temp", "read_humidity", "set_interval",
+	"get_interval", "calibrate", "sleep", "wake", "version", "uptime", "log_level", "reboot"};
+constexpr int gNumCommands = sizeof(gCommands) / sizeof(gCommands[0]);
+
+}
+
+TEST_CASE("HashMap-sensor lookup", TEST_TAG)
+{
+	runLookupBenchmark<8>();
+	runLookupBenchmark<32>();
+	runLookupBenchmark<128>();
+}
+
+TEST_CASE("HashMap-command lookup", TEST_TAG)
+{
+	cz::TStaticHashMap<const char*, int, 32> byName;
+	cz::TStaticHashMap<uint32_t, int, 32, cz::IdentityHash> byHash;
+	for(int i = 0; i < gNumCommands; i++)
+	{
+		byName.insert(gCommands[i], i);
+		byHash.insert(cz::Hash::fnv_32a_str(gCommands[i]), i);
+	}
+
+	// Copies of the names, as if they were received through a serial port
+	char received[gNumCommands][16];
+	for(int i = 0; i < gNumCommands; i++)
+	{
+		strcpy(received[i], gCommands[i]);
+	}
+
+	cz::test::Stopwatch watch;
+	int sumLinear = 0;
+	for(int i = 0; i < gNumLookups; i++)
+	{
+		const char* cmd = received[i % gNumCommands];
+		for(int j = 0; j < gNumCommands; j++)
+		{
+			if (strcmp(gCommands[j], cmd) == 0)
+			{
+				sumLinear += j;
+				break;
+			}
+		}
+	}
+	cz::test::logBenchmark("Linear strcmp", gNumLookups, watch.elapsedMicros());
+
+	watch.reset();
+	int sumName = 0;
+	for(int i = 0; i < gNumLookups; i++)
+	{
+		sumName += *byName.find(received[i % gNumCommands]);
+	}
+	cz::test::logBenchmark("TStaticHashMap<const char*>::find", gNumLookups, watch.elapsedMicros());
+
+	watch.reset();
+	int sumHash = 0;
+	for(int i = 0; i < gNumLookups; i++)
+	{
+		// Still needs to hash the received string
+		sumHash += *byHash.find(cz::Hash::fnv_32a_str(received[i % gNumCommands]));
+	}
+	cz::test::logBenchmark("TStaticHashMap<uint32_t, IdentityHash>::find", gNumLookups, watch.elapsedMicros());
+
+	CHECK(sumLinear == sumName);
+	CHECK(sumLinear == sumHash);
+}
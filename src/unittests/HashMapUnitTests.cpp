@@ -0,0 +1,199 @@
+#include <crazygaze/micromuc/HashMap.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+#include <string>
+
+#define TEST_TAG "[czmicromuc][hashmap]"
+
+using namespace cz;
+
+namespace
+{
+
+/**
+ * Hashes everything to a few buckets, to force collisions and wrap around
+ */
+struct BadHash
+{
+	uint32_t operator()(int key) const
+	{
+		return static_cast<uint32_t>(key % 3) + 6;
+	}
+};
+
+template<typename M>
+void testBasics(M& m)
+{
+	CHECK(m.empty());
+	CHECK(m.find(1) == nullptr);
+	CHECK(m.insert(1, 10));
+	CHECK(m.insert(2, 20));
+	CHECK(!m.insert(1, 11));
+	CHECK(m.set(3, 30));
+	CHECK(m.set(1, 11));
+	CHECK(m.size() == 3);
+	CHECK(*m.find(1) == 11);
+	CHECK(*m.find(2) == 20);
+	CHECK(m.contains(3));
+	CHECK(!m.contains(4));
+
+	*m.find(2) = 21;
+	int sum = 0;
+	for (auto&& e : m)
+	{
+		sum += e.key * 100 + e.value;
+	}
+	CHECK(sum == 111 + 221 + 330);
+
+	CHECK(m.erase(2));
+	CHECK(!m.erase(2));
+	CHECK(m.size() == 2);
+	CHECK(!m.contains(2));
+	m.clear();
+	CHECK(m.empty());
+	CHECK(!m.contains(1));
+}
+
+// Inserts and removes keys, checking against a simple reference
+template<typename M>
+void testChurn(M& m, int numKeys)
+{
+	bool ref[64] = {};
+	uint32_t rnd = 12345;
+	bool ok = true;
+	for (int i = 0; i < 2000; i++)
+	{
+		rnd = rnd * 1103515245 + 12345;
+		int key = static_cast<int>((rnd >> 16) % numKeys);
+		if (ref[key])
+		{
+			ok = ok && m.erase(key);
+			ref[key] = false;
+		}
+		else
+		{
+			ok = ok && m.insert(key, key * 2);
+			ref[key] = true;
+		}
+
+		for (int k = 0; k < numKeys; k++)
+		{
+			const int* v = m.find(k);
+			ok = ok && (ref[k] ? (v && *v == k * 2) : v == nullptr);
+		}
+	}
+	CHECK(ok);
+}
+
+}
+
+TEST_CASE("HashMap-static", TEST_TAG)
+{
+	SECTION("basics")
+	{
+		cz::TStaticHashMap<int, int, 8> m;
+		CHECK(m.capacity() == 8);
+		testBasics(m);
+	}
+
+	SECTION("full")
+	{
+		cz::TStaticHashMap<int, int, 4> m;
+		for (int i = 0; i < 4; i++)
+		{
+			CHECK(m.insert(i, i));
+		}
+		CHECK(!m.insert(4, 4));
+		CHECK(!m.set(4, 4));
+		CHECK(m.set(3, 33));
+		CHECK(!m.contains(4));
+		CHECK(*m.find(3) == 33);
+	}
+
+	SECTION("collisions and removal without tombstones")
+	{
+		cz::TStaticHashMap<int, int, 8, BadHash> m;
+		testChurn(m, 8);
+	}
+
+	SECTION("string keys")
+	{
+		cz::TStaticHashMap<const char*, int, 8> m;
+		char buf[8];
+		strcpy(buf, "ping");
+		CHECK(m.insert("ping", 1));
+		CHECK(m.insert("pong", 2));
+		CHECK(m.find(buf) && *m.find(buf) == 1);
+		CHECK(cz::THash<const char*>()("ping") == "ping"_fnv1a);
+	}
+
+	SECTION("prehashed keys")
+	{
+		cz::TStaticHashMap<uint32_t, int, 8, cz::IdentityHash> m;
+		CHECK(m.insert("ping"_fnv1a, 1));
+		CHECK(m.insert("pong"_fnv1a, 2));
+		CHECK(*m.find(cz::Hash::fnv_32a_str("pong")) == 2);
+	}
+}
+
+TEST_CASE("HashMap-growable", TEST_TAG)
+{
+	SECTION("basics")
+	{
+		cz::THashMap<int, int> m;
+		CHECK(m.capacity() == 0);
+		testBasics(m);
+	}
+
+	SECTION("grows")
+	{
+		cz::THashMap<int, int> m;
+		for (int i = 0; i < 1000; i++)
+		{
+			CHECK(m.insert(i, i));
+		}
+		CHECK(m.size() == 1000);
+		CHECK(m.capacity() == 2048);
+		bool ok = true;
+		for (int i = 0; i < 1000; i++)
+		{
+			ok = ok && m.find(i) && *m.find(i) == i;
+		}
+		CHECK(ok);
+		CHECK(!m.contains(1000));
+	}
+
+	SECTION("reserve")
+	{
+		cz::THashMap<int, int> m;
+		CHECK(m.reserve(100));
+		int capacity = m.capacity();
+		CHECK(capacity == 256);
+		for (int i = 0; i < 100; i++)
+		{
+			m.insert(i, i);
+		}
+		CHECK(m.capacity() == capacity);
+	}
+
+	SECTION("collisions")
+	{
+		cz::THashMap<int, int, BadHash> m;
+		testChurn(m, 64);
+	}
+
+	SECTION("non POD values")
+	{
+		cz::THashMap<int, std::string> m;
+		for (int i = 0; i < 100; i++)
+		{
+			m.insert(i, std::string("Some long string to avoid the small buffer ") + std::to_string(i));
+		}
+		for (int i = 0; i < 100; i += 2)
+		{
+			m.erase(i);
+		}
+		CHECK(m.size() == 50);
+		CHECK(*m.find(99) == "Some long string to avoid the small buffer 99");
+	}
+}
@@ -0,0 +1,121 @@
+#include <crazygaze/micromuc/PriorityQueue.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][priorityqueue][benchmark]"
+
+namespace
+{
+
+#if CZ_TEST_HOST
+constexpr int gNumTimers = 10000;
+#elif defined(__AVR__)
+constexpr int gNumTimers = 100;
+#else
+// The sorted array and the queue are static, and take about 24 bytes per timer
+constexpr int gNumTimers = 1000;
+#endif
+
+struct Timer
+{
+	uint32_t deadline;
+	int id;
+};
+
+struct EarlierDeadline
+{
+	bool operator()(const Timer& a, const Timer& b) const
+	{
+		return a.deadline < b.deadline;
+	}
+};
+
+using SortedTimers = cz::TStaticArray<Timer, gNumTimers, true>;
+using TimerQueue = cz::TStaticPriorityQueue<Timer, gNumTimers, EarlierDeadline>;
+
+uint32_t deadlineOf(int i)
+{
+	return (static_cast<uint32_t>(i) * 2654435761u) >> 8;
+}
+
+// What we did before TPriorityQueue: keep the timers sorted with insertAtIndex, and pop from the front
+__attribute__((noinline)) void insertSorted(SortedTimers& timers)
+{
+	for (int i = 0; i < gNumTimers; i++)
+	{
+		Timer t{deadlineOf(i), i};
+		int index = 0;
+		while (index < timers.size() && timers[index].deadline <= t.deadline)
+		{
+			index++;
+		}
+		timers.insertAtIndex(index, t);
+	}
+}
+
+// Returns the last deadline, or 0 if the timers didn't come out in order
+__attribute__((noinline)) uint32_t popSorted(SortedTimers& timers)
+{
+	uint32_t last = 0;
+	bool ordered = true;
+	while (timers.size())
+	{
+		ordered = ordered && timers[0].deadline >= last;
+		last = timers[0].deadline;
+		timers.removeAtIndex(0);
+	}
+	return ordered ? last : 0;
+}
+
+__attribute__((noinline)) void insertQueue(TimerQueue& timers)
+{
+	for (int i = 0; i < gNumTimers; i++)
+	{
+		timers.push(Timer{deadlineOf(i), i});
+	}
+}
+
+__attribute__((noinline)) uint32_t popQueue(TimerQueue& timers)
+{
+	uint32_t last = 0;
+	bool ordered = true;
+	Timer t;
+	while (timers.pop(t))
+	{
+		ordered = ordered && t.deadline >= last;
+		last = t.deadline;
+	}
+	return ordered ? last : 0;
+}
+
+}
+
+TEST_CASE("PriorityQueue-timers", TEST_TAG)
+{
+	static SortedTimers sorted;
+	static TimerQueue queue;
+	char name[80];
+
+	cz::test::Stopwatch watch;
+	insertSorted(sorted);
+	snprintf(name, sizeof(name), "Sorted TStaticArray insert (%d timers)", gNumTimers);
+	cz::test::logBenchmark(name, gNumTimers, watch.elapsedMicros());
+
+	watch.reset();
+	uint32_t lastSorted = popSorted(sorted);
+	snprintf(name, sizeof(name), "Sorted TStaticArray pop (%d timers)", gNumTimers);
+	cz::test::logBenchmark(name, gNumTimers, watch.elapsedMicros());
+
+	watch.reset();
+	insertQueue(queue);
+	snprintf(name, sizeof(name), "TStaticPriorityQueue push (%d timers)", gNumTimers);
+	cz::test::logBenchmark(name, gNumTimers, watch.elapsedMicros());
+
+	watch.reset();
+	uint32_t lastQueue = popQueue(queue);
+	snprintf(name, sizeof(name), "TStaticPriorityQueue pop (%d timers)", gNumTimers);
+	cz::test::logBenchmark(name, gNumTimers, watch.elapsedMicros());
+
+	CHECK(lastSorted != 0);
+	CHECK(lastSorted == lastQueue);
+}
@@ -0,0 +1,225 @@
+#include <crazygaze/micromuc/PriorityQueue.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+#include <string>
+
+#define TEST_TAG "[czmicromuc][priorityqueue]"
+
+namespace
+{
+
+// Pops all the elements, checking they come out in order
+template<typename Q>
+bool popsInOrder(Q& q, int expectedCount)
+{
+	int count = 0;
+	bool ok = true;
+	int previous = 0;
+	int val;
+	while (q.pop(val))
+	{
+		ok = ok && (count == 0 || previous <= val);
+		previous = val;
+		count++;
+	}
+	return ok && count == expectedCount && q.empty();
+}
+
+struct Timer
+{
+	uint32_t deadline;
+	int id;
+};
+
+struct EarlierDeadline
+{
+	bool operator()(const Timer& a, const Timer& b) const
+	{
+		return a.deadline < b.deadline;
+	}
+};
+
+}
+
+TEST_CASE("PriorityQueue", TEST_TAG)
+{
+	SECTION("basics")
+	{
+		cz::TPriorityQueue<int> q;
+		CHECK(q.empty());
+		CHECK(!q.pop());
+
+		const int values[] = {5, 3, 8, 1, 9, 2, 7};
+		cz::TPriorityQueue<int>::Handle handles[7];
+		for (int i = 0; i < 7; i++)
+		{
+			handles[i] = q.push(values[i]);
+			CHECK(handles[i] != q.InvalidHandle);
+		}
+		CHECK(q.size() == 7);
+		CHECK(q.top() == 1);
+		CHECK(q.topHandle() == handles[3]);
+		for (int i = 0; i < 7; i++)
+		{
+			CHECK(q.contains(handles[i]));
+			CHECK(q.get(handles[i]) == values[i]);
+		}
+		CHECK(!q.contains(q.InvalidHandle));
+		CHECK(!q.contains(7));
+
+		CHECK(popsInOrder(q, 7));
+		CHECK(!q.contains(handles[0]));
+	}
+
+	SECTION("max heap")
+	{
+		cz::TPriorityQueue<int, std::greater<int>> q;
+		q.push(1);
+		q.push(3);
+		q.push(2);
+		CHECK(q.top() == 3);
+	}
+
+	SECTION("decreaseKey, update and remove")
+	{
+		cz::TPriorityQueue<int> q;
+		cz::TPriorityQueue<int>::Handle handles[20];
+		for (int i = 0; i < 20; i++)
+		{
+			handles[i] = q.push(100 + i);
+		}
+
+		q.decreaseKey(handles[15], 1);
+		CHECK(q.top() == 1);
+		CHECK(q.topHandle() == handles[15]);
+		CHECK(q.get(handles[15]) == 1);
+
+		// Moving the top down
+		q.update(handles[15], 200);
+		CHECK(q.top() == 100);
+		CHECK(q.get(handles[15]) == 200);
+
+		CHECK(q.remove(handles[0]));
+		CHECK(!q.remove(handles[0]));
+		CHECK(q.top() == 101);
+		CHECK(q.remove(handles[10]));
+		CHECK(q.size() == 18);
+
+		// All the remaining handles still point to the right values
+		bool ok = true;
+		for (int i = 1; i < 20; i++)
+		{
+			if (i == 10)
+				continue;
+			ok = ok && q.get(handles[i]) == (i == 15 ? 200 : 100 + i);
+		}
+		CHECK(ok);
+
+		// Removed handles are reused
+		cz::TPriorityQueue<int>::Handle h = q.push(50);
+		CHECK((h == handles[0] || h == handles[10]));
+		CHECK(q.top() == 50);
+		CHECK(popsInOrder(q, 19));
+	}
+
+	SECTION("heapify")
+	{
+		const int values[] = {9, 4, 7, 1, 8, 2, 6, 3, 5, 0};
+		cz::TPriorityQueue<int> q;
+		CHECK(q.assign(values, 10));
+		CHECK(q.size() == 10);
+		// Handles are the indices into the values
+		for (int i = 0; i < 10; i++)
+		{
+			CHECK(q.get(i) == values[i]);
+		}
+		CHECK(q.top() == 0);
+		q.decreaseKey(0, -1);
+		CHECK(q.top() == -1);
+		CHECK(popsInOrder(q, 10));
+
+		for (int i = 0; i < 10; i++)
+		{
+			q.addUnsorted(values[i]);
+		}
+		q.heapify();
+		CHECK(popsInOrder(q, 10));
+	}
+
+	SECTION("random operations")
+	{
+		// Compare against a sorted TArray
+		cz::TPriorityQueue<int> q;
+		cz::TArray<int> sorted;
+		uint32_t rnd = 12345;
+		auto next = [&rnd]()
+		{
+			rnd = rnd * 1103515245 + 12345;
+			return static_cast<int>((rnd >> 16) % 1000);
+		};
+
+		bool ok = true;
+		for (int i = 0; i < 2000; i++)
+		{
+			if (next() % 3 != 0 || sorted.size() == 0)
+			{
+				int val = next();
+				q.push(val);
+				int index = 0;
+				while (index < sorted.size() && sorted[index] < val)
+				{
+					index++;
+				}
+				sorted.insertAtIndex(index, val);
+			}
+			else
+			{
+				int val;
+				ok = ok && q.pop(val) && val == sorted[0];
+				sorted.removeAtIndex(0);
+			}
+			ok = ok && q.size() == sorted.size() && (q.empty() || q.top() == sorted[0]);
+		}
+		CHECK(ok);
+	}
+
+	SECTION("non trivial types")
+	{
+		cz::TPriorityQueue<std::string> q;
+		q.push("c with some padding to avoid the small string optimization");
+		auto h = q.push("b with some padding to avoid the small string optimization");
+		q.push("a with some padding to avoid the small string optimization");
+		q.update(h, "d");
+		std::string s;
+		CHECK(q.pop(s) && s[0] == 'a');
+		CHECK(q.pop(s) && s[0] == 'c');
+		CHECK(q.pop(s) && s == "d");
+	}
+}
+
+TEST_CASE("PriorityQueue-static", TEST_TAG)
+{
+	cz::TStaticPriorityQueue<Timer, 4, EarlierDeadline> q;
+	CHECK(q.capacity() == 4);
+	auto a = q.push(Timer{40, 0});
+	q.push(Timer{10, 1});
+	q.push(Timer{30, 2});
+	q.push(Timer{20, 3});
+	CHECK(q.push(Timer{0, 4}) == q.InvalidHandle);
+	CHECK(q.size() == 4);
+	CHECK(q.top().id == 1);
+
+	q.decreaseKey(a, Timer{5, 0});
+	Timer t;
+	CHECK(q.pop(t) && t.id == 0);
+	CHECK(q.pop(t) && t.id == 1);
+	CHECK(q.push(Timer{25, 5}) != q.InvalidHandle);
+	CHECK(q.pop(t) && t.id == 3);
+	CHECK(q.pop(t) && t.id == 5);
+	CHECK(q.pop(t) && t.id == 2);
+	CHECK(q.empty());
+
+	const Timer many[5] = {};
+	CHECK(!q.assign(many, 5));
+	CHECK(q.empty());
+}
@@ -0,0 +1,157 @@
+#include <crazygaze/micromuc/Queue.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+#if _GLIBCXX_HAS_GTHREADS
+	#include <mutex>
+#endif
+
+#define TEST_TAG "[czmicromuc][queue][benchmark]"
+
+namespace
+{
+
+constexpr int gBatchSize = 32;
+constexpr int gNumBatches = 20000;
+
+// Pushes and pops batches of items, to measure the cost of a push/pop pair.
+// Not inlined, so the compiler can't see through the queue state across calls.
+template<typename Q>
+__attribute__((noinline)) uint32_t pushPopBatches(Q& q)
+{
+	uint32_t sum = 0;
+	for(int batch = 0; batch < gNumBatches; batch++)
+	{
+		for(int i = 0; i < gBatchSize; i++)
+		{
+			q.push(i);
+		}
+
+		for(int i = 0; i < gBatchSize; i++)
+		{
+			int val;
+			if (q.pop(val))
+			{
+				sum += val;
+			}
+		}
+	}
+	return sum;
+}
+
+template<typename Q>
+void runPushPopBenchmark(const char* name, Q& q)
+{
+	cz::test::Stopwatch watch;
+	volatile uint32_t sum = pushPopBatches(q);
+	unsigned long elapsed = watch.elapsedMicros();
+	(void)sum;
+	cz::test::logBenchmark(name, gBatchSize * gNumBatches, elapsed);
+}
+
+}
+
+TEST_CASE("Queue-push/pop modulo vs mask", TEST_TAG)
+{
+	// Same number of usable slots (63) in both, but TStaticPow2FixedCapacityQueue doesn't waste a slot, so it only
+	// needs 64 elements.
+	static cz::TStaticFixedCapacityQueue<int, 63> moduloQueue;
+	static cz::TStaticPow2FixedCapacityQueue<int, 64> maskQueue;
+
+	runPushPopBenchmark("TStaticFixedCapacityQueue<int,63> push+pop", moduloQueue);
+	runPushPopBenchmark("TStaticPow2FixedCapacityQueue<int,64> push+pop", maskQueue);
+
+	CHECK(moduloQueue.isEmpty());
+	CHECK(maskQueue.isEmpty());
+}
+
+#if _GLIBCXX_HAS_GTHREADS
+
+namespace
+{
+
+/**
+ * TFixedCapacityQueue protected by a mutex, to compare against TMPMCFixedCapacityQueue
+ */
+template<typename T, int SIZE>
+class MutexQueue
+{
+public:
+	bool push(const T& val)
+	{
+		std::unique_lock<std::mutex> lk(m_mtx);
+		return m_q.push(val);
+	}
+
+	bool pop(T& outVal)
+	{
+		std::unique_lock<std::mutex> lk(m_mtx);
+		return m_q.pop(outVal);
+	}
+
+private:
+	std::mutex m_mtx;
+	cz::TStaticFixedCapacityQueue<T, SIZE> m_q;
+};
+
+/**
+ * Runs numPairs producers and numPairs consumers, moving numItems through the queue
+ */
+template<typename Q>
+void runThroughputBenchmark(const char* name, Q& q, int numPairs, uint32_t numItems)
+{
+	uint32_t itemsPerProducer = numItems / numPairs;
+	numItems = itemsPerProducer * numPairs;
+	std::atomic<uint32_t> received(0);
+
+	auto func = [&](int index)
+	{
+		if (index < numPairs)
+		{
+			for (uint32_t i = 0; i < itemsPerProducer; )
+			{
+				if (q.push(i))
+					i++;
+				else
+					cz::test::spinPause();
+			}
+		}
+		else
+		{
+			uint32_t val;
+			while(received.load(std::memory_order_relaxed) != numItems)
+			{
+				if (q.pop(val))
+					received.fetch_add(1, std::memory_order_relaxed);
+				else
+					cz::test::spinPause();
+			}
+		}
+	};
+
+	cz::test::Stopwatch watch;
+	cz::test::runThreads(numPairs * 2, func);
+	unsigned long elapsed = watch.elapsedMicros();
+
+	char buf[100];
+	snprintf(buf, sizeof(buf), "%s %dP/%dC", name, numPairs, numPairs);
+	cz::test::logBenchmark(buf, numItems, elapsed);
+	CHECK(received == numItems);
+}
+
+}
+
+TEST_CASE("Queue-MPMC vs mutex throughput", TEST_TAG)
+{
+	constexpr uint32_t numItems = 400000;
+	int maxPairs = std::max(2u, std::thread::hardware_concurrency() / 2);
+
+	for (int numPairs = 1; numPairs <= maxPairs; numPairs++)
+	{
+		static cz::TStaticMPMCFixedCapacityQueue<uint32_t, 256> mpmcQueue;
+		static MutexQueue<uint32_t, 255> mutexQueue;
+		runThroughputBenchmark("TMPMCFixedCapacityQueue", mpmcQueue, numPairs, numItems);
+		runThroughputBenchmark("Mutex+TFixedCapacityQueue", mutexQueue, numPairs, numItems);
+	}
+}
+
+#endif
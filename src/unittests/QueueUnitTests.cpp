@@ -0,0 +1,499 @@
+#include <crazygaze/micromuc/Queue.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+#include <memory>
+
+#define TEST_TAG "[czmicromuc][queue]"
+
+namespace
+{
+
+// Unlike cz::test::equals, this pops the elements to check them, so the queue is left empty
+template<class Q>
+bool popEquals(Q& q, std::initializer_list<typename Q::Type> list)
+{
+	if (static_cast<size_t>(q.size()) != list.size())
+		return false;
+
+	typename Q::Type val;
+	for(auto&& v : list)
+	{
+		if (!q.pop(val) || val != v)
+			return false;
+	}
+
+	return true;
+}
+
+using cz::test::Tracked;
+
+}
+
+TEST_CASE("Queue-non POD", TEST_TAG)
+{
+	Tracked::ms_alive = 0;
+
+	SECTION("Elements are only constructed when pushed, and destroyed when popped")
+	{
+		cz::TStaticFixedCapacityQueue<Tracked, 4> q;
+		CHECK(Tracked::ms_alive == 0);
+		CHECK(q.emplace(0));
+		CHECK(q.emplace(1));
+		CHECK(Tracked::ms_alive == 2);
+		Tracked t(2);
+		CHECK(q.push(std::move(t)));
+		CHECK(t.movedFrom);
+		CHECK(Tracked::ms_alive == 4);
+
+		Tracked out(-1);
+		CHECK(q.pop(out));
+		CHECK(out.n == 0);
+		CHECK(Tracked::ms_alive == 4);
+		CHECK(q.pop().n == 1);
+		CHECK(Tracked::ms_alive == 3);
+	}
+	CHECK(Tracked::ms_alive == 0);
+
+	SECTION("Destroying the queue destroys the elements")
+	{
+		{
+			cz::TStaticFixedCapacityQueue<Tracked, 4> q;
+			q.emplace(0);
+			q.emplace(1);
+			CHECK(Tracked::ms_alive == 2);
+		}
+		CHECK(Tracked::ms_alive == 0);
+	}
+
+	SECTION("remove/clear/popN")
+	{
+		cz::TStaticFixedCapacityQueue<Tracked, 5> q;
+		// Force a wrap around
+		for (int i = 0; i < 4; i++)
+		{
+			q.emplace(i);
+			q.pop();
+		}
+
+		q.emplace(1);
+		q.emplace(2);
+		q.emplace(1);
+		q.emplace(3);
+		q.emplace(1);
+		CHECK(q.remove(Tracked(1)) == 3);
+		CHECK(Tracked::ms_alive == 2);
+		CHECK(q.size() == 2);
+		CHECK(q.front().n == 2);
+		CHECK(q.back().n == 3);
+
+
+		const Tracked src[2] = {Tracked(4), Tracked(5)};
+		CHECK(q.pushN(src, 2) == 2);
+		CHECK(Tracked::ms_alive == 6);
+
+		Tracked dst[2] = {Tracked(-1), Tracked(-1)};
+		CHECK(q.popN(dst, 2) == 2);
+		CHECK(dst[0].n == 2 && dst[1].n == 3);
+		CHECK(Tracked::ms_alive == 6);
+
+		// Removing using an element of the queue itself, which gets destroyed while removing
+		q.emplace(7);
+		q.emplace(8);
+		q.emplace(7);
+		CHECK(q.remove(q.getAtIndex(2)) == 2);
+		CHECK(Tracked::ms_alive == 7);
+		CHECK(q.size() == 3);
+		CHECK(q.getAtIndex(1).n == 5);
+		CHECK(q.back().n == 8);
+
+		q.clear();
+		CHECK(q.isEmpty());
+		CHECK(Tracked::ms_alive == 4);
+	}
+	CHECK(Tracked::ms_alive == 0);
+
+	SECTION("Move only types")
+	{
+		cz::TStaticFixedCapacityQueue<std::unique_ptr<int>, 2> q;
+		CHECK(q.push(std::make_unique<int>(1)));
+		CHECK(q.emplace(new int(2)));
+		CHECK(*q.pop() == 1);
+		std::unique_ptr<int> p;
+		CHECK(q.pop(p));
+		CHECK(*p == 2);
+	}
+}
+
+TEST_CASE("Queue-pushN/popN", TEST_TAG)
+{
+	cz::TStaticFixedCapacityQueue<int, 5> q;
+	const int src[] = {0, 1, 2, 3, 4, 5, 6};
+	int dst[7] = {};
+
+	SECTION("Should only push what fits")
+	{
+		CHECK(q.pushN(src, 7) == 5);
+		CHECK(q.isFull());
+		CHECK(q.popN(dst, 7) == 5);
+		CHECK(memcmp(src, dst, sizeof(int) * 5) == 0);
+		CHECK(q.isEmpty());
+	}
+
+	SECTION("Should wrap around")
+	{
+		// Move head/tail to the middle of the buffer, so the next push wraps
+		CHECK(q.pushN(src, 4) == 4);
+		CHECK(q.popN(dst, 4) == 4);
+
+		CHECK(q.pushN(src, 3) == 3);
+		CHECK(q.pushN(src + 3, 2) == 2);
+		CHECK(q.pushN(src, 1) == 0);
+		CHECK(popEquals(q, {0, 1, 2, 3, 4}));
+
+		CHECK(q.pushN(src, 5) == 5);
+		CHECK(q.popN(dst, 2) == 2);
+		CHECK(q.popN(dst + 2, 7) == 3);
+		CHECK(memcmp(src, dst, sizeof(int) * 5) == 0);
+	}
+}
+
+TEST_CASE("Queue-spans", TEST_TAG)
+{
+	cz::TStaticFixedCapacityQueue<int, 5> q;
+
+	SECTION("Empty queue")
+	{
+		auto w = q.getWritableSpans();
+		CHECK(w.size() == 5);
+		CHECK(w.first.size == 5);
+		CHECK(w.second.size == 0);
+		CHECK(q.getReadableSpans().size() == 0);
+	}
+
+	SECTION("Write and read through the spans")
+	{
+		const int dummy[4] = {};
+		const int src[3] = {10, 11, 12};
+
+		// Move head/tail to index 4 (of 6 slots)
+		q.pushN(dummy, 4);
+		q.commitPop(4);
+		CHECK(q.isEmpty());
+
+		auto w = q.getWritableSpans();
+		CHECK(w.first.size == 2);
+		CHECK(w.second.size == 3);
+		int n = 0;
+		for (int i = 0; i < w.first.size; i++)
+			w.first.data[i] = n++;
+		for (int i = 0; i < w.second.size; i++)
+			w.second.data[i] = n++;
+		q.commitPush(4);
+		CHECK(popEquals(q, {0, 1, 2, 3}));
+
+		// head/tail are now at index 2. Move them to index 5
+		q.pushN(dummy, 3);
+		q.commitPop(3);
+
+		q.pushN(src, 3);
+		auto r = q.getReadableSpans();
+		CHECK(r.size() == 3);
+		CHECK(r.first.size == 1);
+		CHECK(r.first.data[0] == 10);
+		CHECK(r.second.size == 2);
+		CHECK(r.second.data[0] == 11);
+		CHECK(r.second.data[1] == 12);
+		q.commitPop(2);
+		CHECK(q.size() == 1);
+		CHECK(q.front() == 12);
+	}
+}
+
+TEST_CASE("Pow2Queue-push/pop", TEST_TAG)
+{
+	cz::TStaticPow2FixedCapacityQueue<int, 4> q;
+	CHECK(q.isEmpty());
+	CHECK(q.capacity() == 4);
+
+	SECTION("Should use all the slots")
+	{
+		for(int i = 0; i < 4; i++)
+		{
+			CHECK(q.push(i));
+		}
+		CHECK(q.isFull());
+		CHECK(q.size() == 4);
+		CHECK(q.push(4) == false);
+		CHECK(q.front() == 0);
+		CHECK(q.back() == 3);
+		CHECK(q.find(3));
+		CHECK(q.find(4) == false);
+		CHECK(popEquals(q, {0, 1, 2, 3}));
+	}
+
+	SECTION("Should wrap around")
+	{
+		int expected = 0;
+		int pushed = 0;
+		for(int i = 0; i < 10; i++)
+		{
+			CHECK(q.push(pushed++));
+			CHECK(q.push(pushed++));
+			CHECK(q.push(pushed++));
+			CHECK(q.pop() == expected++);
+			CHECK(q.pop() == expected++);
+			CHECK(q.size() == 1);
+			CHECK(q.pop() == expected++);
+		}
+		CHECK(q.isEmpty());
+	}
+
+	SECTION("remove")
+	{
+		// Force a wrap around first
+		q.push(0);
+		q.push(0);
+		q.pop();
+		q.pop();
+
+		q.push(2);
+		q.push(3);
+		q.push(2);
+		q.push(4);
+		CHECK(q.remove(2) == 2);
+		CHECK(q.getAtIndex(0) == 3);
+		CHECK(q.getAtIndex(1) == 4);
+		CHECK(popEquals(q, {3, 4}));
+
+		// Removing using an element of the queue itself. That element gets overwritten while removing
+		q.push(3);
+		q.push(4);
+		q.push(3);
+		CHECK(q.remove(q.getAtIndex(0)) == 2);
+		CHECK(popEquals(q, {4}));
+	}
+}
+
+TEST_CASE("SPSCQueue-push/pop", TEST_TAG)
+{
+	cz::TStaticSPSCFixedCapacityQueue<int, 5> q;
+	CHECK(q.isEmpty());
+	CHECK(q.size() == 0);
+	CHECK(q.capacity() == 6);
+
+	SECTION("Should fill up to capacity-1")
+	{
+		for(int i = 0; i < 5; i++)
+		{
+			CHECK(q.push(i));
+		}
+		CHECK(q.isFull());
+		CHECK(q.push(5) == false);
+		CHECK(popEquals(q, {0, 1, 2, 3, 4}));
+		CHECK(q.isEmpty());
+	}
+
+	SECTION("Should wrap around")
+	{
+		int expected = 0;
+		int pushed = 0;
+		for(int i = 0; i < 20; i++)
+		{
+			CHECK(q.push(pushed++));
+			CHECK(q.push(pushed++));
+			int val;
+			CHECK(q.peek(val) && val == expected);
+			CHECK(q.front() == expected);
+			CHECK(q.pop() == expected++);
+			CHECK(q.pop() == expected++);
+			CHECK(q.size() == 0);
+		}
+
+		int val = -1;
+		CHECK(q.pop(val) == false);
+		CHECK(q.peek(val) == false);
+		CHECK(val == -1);
+	}
+
+	SECTION("clear")
+	{
+		q.push(1);
+		q.push(2);
+		q.clear();
+		CHECK(q.isEmpty());
+		CHECK(q.size() == 0);
+	}
+}
+
+#if CZ_TEST_HAS_CONCURRENCY
+
+TEST_CASE("SPSCQueue-stress", TEST_TAG)
+{
+	#if _GLIBCXX_HAS_GTHREADS
+		constexpr uint32_t numItems = 4000000;
+	#else
+		constexpr uint32_t numItems = 1000000;
+	#endif
+
+	// Using a small queue on purpose, so both sides keep hitting the full/empty conditions
+	static cz::TStaticSPSCFixedCapacityQueue<uint32_t, 63> q;
+	q.clear();
+
+	auto producer = []()
+	{
+		uint32_t next = 0;
+		while(next != numItems)
+		{
+			if (q.push(next))
+			{
+				next++;
+			}
+			else
+			{
+				cz::test::spinPause();
+			}
+		}
+	};
+
+	uint32_t received = 0;
+	uint32_t outOfOrder = 0;
+	auto consumer = [&received, &outOfOrder]()
+	{
+		while(received != numItems)
+		{
+			uint32_t val;
+			if (q.pop(val))
+			{
+				if (val != received)
+				{
+					outOfOrder++;
+				}
+				received++;
+			}
+			else
+			{
+				cz::test::spinPause();
+			}
+		}
+	};
+
+	cz::test::runConcurrently(producer, consumer);
+
+	CHECK(received == numItems);
+	CHECK(outOfOrder == 0);
+	CHECK(q.isEmpty());
+}
+
+#endif
+
+TEST_CASE("MPMCQueue-push/pop", TEST_TAG)
+{
+	cz::TStaticMPMCFixedCapacityQueue<int, 4> q;
+	CHECK(q.isEmpty());
+	CHECK(q.capacity() == 4);
+
+	int expected = 0;
+	int pushed = 0;
+	for(int i = 0; i < 10; i++)
+	{
+		while(q.push(pushed))
+		{
+			pushed++;
+		}
+		CHECK(q.isFull());
+		CHECK(q.size() == 4);
+		CHECK(q.pop() == expected++);
+		CHECK(q.pop() == expected++);
+		CHECK(q.size() == 2);
+	}
+
+	int val;
+	while(q.pop(val))
+	{
+		CHECK(val == expected++);
+	}
+	CHECK(expected == pushed);
+	CHECK(q.isEmpty());
+
+	q.push(1);
+	q.clear();
+	CHECK(q.isEmpty());
+	CHECK(q.pop(val) == false);
+}
+
+#if _GLIBCXX_HAS_GTHREADS
+
+TEST_CASE("MPMCQueue-stress", TEST_TAG)
+{
+	constexpr int numProducers = 3;
+	constexpr int numConsumers = 3;
+	constexpr uint32_t itemsPerProducer = 500000;
+
+	static cz::TStaticMPMCFixedCapacityQueue<uint32_t, 64> q;
+	q.clear();
+
+	std::atomic<uint32_t> totalReceived(0);
+	std::atomic<uint64_t> totalSum(0);
+	std::atomic<int> outOfOrder(0);
+
+	// Threads [0, numProducers) are producers, and the others are consumers.
+	// Each item has the producer index in the top bits, so consumers can check that items from the same producer
+	// arrive in order.
+	auto func = [&](int index)
+	{
+		if (index < numProducers)
+		{
+			for(uint32_t i = 0; i < itemsPerProducer; )
+			{
+				if (q.push((static_cast<uint32_t>(index) << 24) | i))
+				{
+					i++;
+				}
+				else
+				{
+					cz::test::spinPause();
+				}
+			}
+		}
+		else
+		{
+			int32_t last[numProducers];
+			for(auto&& l : last)
+			{
+				l = -1;
+			}
+
+			uint64_t sum = 0;
+			while(totalReceived.load() != numProducers * itemsPerProducer)
+			{
+				uint32_t val;
+				if (q.pop(val))
+				{
+					int producer = val >> 24;
+					int32_t n = val & 0xFFFFFF;
+					if (n <= last[producer])
+					{
+						outOfOrder++;
+					}
+					last[producer] = n;
+					sum += n;
+					totalReceived++;
+				}
+				else
+				{
+					cz::test::spinPause();
+				}
+			}
+			totalSum += sum;
+		}
+	};
+
+	cz::test::runThreads(numProducers + numConsumers, func);
+
+	CHECK(totalReceived == numProducers * itemsPerProducer);
+	CHECK(totalSum == uint64_t(numProducers) * (uint64_t(itemsPerProducer) * (itemsPerProducer - 1) / 2));
+	CHECK(outOfOrder == 0);
+	CHECK(q.isEmpty());
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include <crazygaze/micromuc/Simd.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][simd][benchmark]"
+
+namespace
+{
+
+#ifdef __AVR__
+constexpr int gMaxSize = 256;
+constexpr uint32_t gTotalElements = 20000;
+#else
+constexpr int gMaxSize = 4096;
+constexpr uint32_t gTotalElements = 4000000;
+#endif
+
+const char* implName()
+{
+#if CZ_SIMD==CZ_SIMD_AVX2
+	return "AVX2";
+#elif CZ_SIMD==CZ_SIMD_SSE2
+	return "SSE2";
+#elif CZ_SIMD==CZ_SIMD_NEON
+	return "NEON";
+#elif CZ_SIMD==CZ_SIMD_SWAR
+	return "SWAR";
+#else
+	return "scalar";
+#endif
+}
+
+template<typename T>
+const char* typeName()
+{
+	return sizeof(T) == 1 ? "uint8_t" : (sizeof(T) == 2 ? "uint16_t" : "uint32_t");
+}
+
+template<typename T>
+struct Scalar
+{
+	__attribute__((noinline)) static const T* find(const T* s, const T* e, const T& v)
+	{
+		return cz::simd::detail::findScalar(s, e, v);
+	}
+	__attribute__((noinline)) static int count(const T* s, const T* e, const T& v)
+	{
+		return cz::simd::detail::countScalar(s, e, v);
+	}
+};
+
+template<typename T>
+struct Swar
+{
+	__attribute__((noinline)) static const T* find(const T* s, const T* e, const T& v)
+	{
+		return cz::simd::detail::findSwar(s, e, v);
+	}
+	__attribute__((noinline)) static int count(const T* s, const T* e, const T& v)
+	{
+		return cz::simd::detail::countSwar(s, e, v);
+	}
+};
+
+template<typename T>
+struct Default
+{
+	__attribute__((noinline)) static const T* find(const T* s, const T* e, const T& v)
+	{
+		return cz::simd::find(s, e, v);
+	}
+	__attribute__((noinline)) static int count(const T* s, const T* e, const T& v)
+	{
+		return cz::simd::count(s, e, v);
+	}
+};
+
+// Searches for a value that is only at the end, so the whole array is scanned
+template<typename T, typename Impl>
+void runSearch(const char* implName, T* data, int size)
+{
+	const uint32_t reps = gTotalElements / size;
+	// Read through a volatile on every iteration, so the compiler can't hoist the calls out of the loops
+	volatile T val = static_cast<T>(1);
+	data[size - 1] = val;
+	char name[80];
+
+	cz::test::Stopwatch watch;
+	intptr_t sum = 0;
+	for (uint32_t i = 0; i < reps; i++)
+	{
+		sum += Impl::find(data, data + size, static_cast<T>(val)) - data;
+	}
+	unsigned long elapsed = watch.elapsedMicros();
+	snprintf(name, sizeof(name), "find %s, %s, %d elements (per element)", typeName<T>(), implName, size);
+	cz::test::logBenchmark(name, reps * size, elapsed);
+	CHECK(sum == static_cast<intptr_t>(reps) * (size - 1));
+
+	watch.reset();
+	sum = 0;
+	for (uint32_t i = 0; i < reps; i++)
+	{
+		sum += Impl::count(data, data + size, static_cast<T>(val));
+	}
+	elapsed = watch.elapsedMicros();
+	snprintf(name, sizeof(name), "count %s, %s, %d elements (per element)", typeName<T>(), implName, size);
+	cz::test::logBenchmark(name, reps * size, elapsed);
+	CHECK(sum == static_cast<intptr_t>(reps));
+
+	data[size - 1] = 0;
+}
+
+template<typename T>
+void runSearchBenchmarks()
+{
+	static T data[gMaxSize];
+	for (int size = 16; size <= gMaxSize; size *= 16)
+	{
+		runSearch<T, Scalar<T>>("scalar", data, size);
+		runSearch<T, Swar<T>>("SWAR", data, size);
+		runSearch<T, Default<T>>(implName(), data, size);
+	}
+}
+
+}
+
+TEST_CASE("Simd-find and count", TEST_TAG)
+{
+	runSearchBenchmarks<uint8_t>();
+	runSearchBenchmarks<uint16_t>();
+	runSearchBenchmarks<uint32_t>();
+}
@@ -0,0 +1,195 @@
+#include <crazygaze/micromuc/Simd.h>
+#include <crazygaze/micromuc/Array.h>
+#include <crazygaze/micromuc/Queue.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][simd]"
+
+namespace
+{
+
+enum class Channel : uint16_t
+{
+	A,
+	B,
+	C
+};
+
+template<typename T>
+T makeVal(int i)
+{
+	if constexpr (std::is_pointer<T>::value)
+	{
+		static char buf[256];
+		return reinterpret_cast<T>(&buf[i & 0xFF]);
+	}
+	else
+	{
+		return static_cast<T>(i);
+	}
+}
+
+/**
+ * Checks find/count/fill against plain loops, for all sizes up to a few vectors, all start offsets (so the
+ * alignment handling is tested), and matches at every position.
+ * Values are chosen so that neighbour lanes differ from the searched value by a single bit or by a borrow, which is
+ * what could trick the SWAR code.
+ */
+template<typename T, typename Find, typename Count, typename Fill>
+bool testKernels(Find find, Count count, Fill fill)
+{
+	constexpr int maxSize = 80;
+	// Space for a guard element before and after
+	alignas(64) T buf[maxSize + 10];
+	bool ok = true;
+
+	const T val = makeVal<T>(0x40);
+	const T others[] = {makeVal<T>(0x41), makeVal<T>(0x3F), makeVal<T>(0xC0), makeVal<T>(0)};
+
+	for (int offset = 0; offset < 8; offset++)
+	{
+		T* data = buf + 1 + offset;
+		for (int size = 0; size <= maxSize; size++)
+		{
+			for (int i = 0; i < size; i++)
+			{
+				data[i] = others[i % 4];
+			}
+			ok = ok && find(data, data + size, val) == data + size;
+			ok = ok && count(data, data + size, val) == 0;
+
+			for (int pos = 0; pos < size; pos++)
+			{
+				data[pos] = val;
+				ok = ok && find(data, data + size, val) == data + pos;
+				ok = ok && count(data, data + size, val) == 1;
+				data[pos] = others[pos % 4];
+			}
+
+			// Several matches
+			for (int i = 0; i < size; i += 3)
+			{
+				data[i] = val;
+			}
+			ok = ok && count(data, data + size, val) == (size + 2) / 3;
+			ok = ok && (size == 0 || find(data + 1, data + size, val) == (size > 3 ? data + 3 : data + size));
+
+			// Fill only touches the specified elements
+			data[-1] = others[0];
+			data[size] = others[1];
+			fill(data, val, size);
+			ok = ok && data[-1] == others[0] && data[size] == others[1];
+			ok = ok && count(data, data + size, val) == size;
+		}
+	}
+
+	return ok;
+}
+
+template<typename T>
+bool testAllKernels()
+{
+	bool ok = testKernels<T>(
+		[](const T* s, const T* e, const T& v) { return cz::simd::find(s, e, v); },
+		[](const T* s, const T* e, const T& v) { return cz::simd::count(s, e, v); },
+		[](T* s, const T& v, int c) { cz::simd::fill(s, v, c); });
+
+	// SWAR is used on most microcontrollers, so test it even if the host uses something else
+	ok = ok && testKernels<T>(
+		[](const T* s, const T* e, const T& v) { return cz::simd::detail::findSwar(s, e, v); },
+		[](const T* s, const T* e, const T& v) { return cz::simd::detail::countSwar(s, e, v); },
+		[](T* s, const T& v, int c) { cz::simd::detail::fillSwar(s, v, c); });
+
+	return ok;
+}
+
+struct NotSupported
+{
+	int a;
+	bool operator==(const NotSupported& other) const { return a == other.a; }
+};
+
+}
+
+TEST_CASE("Simd-kernels", TEST_TAG)
+{
+	CHECK(cz::simd::TIsSupported<uint8_t>::value);
+	CHECK(cz::simd::TIsSupported<int64_t>::value);
+	CHECK(cz::simd::TIsSupported<const char*>::value);
+	CHECK(cz::simd::TIsSupported<Channel>::value);
+	CHECK(!cz::simd::TIsSupported<float>::value);
+	CHECK(!cz::simd::TIsSupported<NotSupported>::value);
+
+	CHECK(testAllKernels<uint8_t>());
+	CHECK(testAllKernels<int8_t>());
+	CHECK(testAllKernels<uint16_t>());
+	CHECK(testAllKernels<int32_t>());
+	CHECK(testAllKernels<uint32_t>());
+	CHECK(testAllKernels<uint64_t>());
+	CHECK(testAllKernels<Channel>());
+	CHECK(testAllKernels<const char*>());
+
+	// Unsupported types fallback to plain loops
+	NotSupported ns[3] = {{1}, {2}, {1}};
+	CHECK(cz::simd::find(ns, ns + 3, NotSupported{2}) == ns + 1);
+	CHECK(cz::simd::count(ns, ns + 3, NotSupported{1}) == 2);
+}
+
+TEST_CASE("Simd-containers", TEST_TAG)
+{
+	SECTION("TArray")
+	{
+		cz::TArray<uint8_t> a;
+		a.push(7, 100);
+		a.push(3);
+		a.push(7, 10);
+		a.push(3);
+		int idx = -1;
+		CHECK(a.find(3, idx) && idx == 100);
+		CHECK(a.count(3) == 2);
+		CHECK(a.count(7) == 110);
+		CHECK(a.count(0) == 0);
+	}
+
+	SECTION("TStaticArray")
+	{
+		cz::TStaticArray<uint16_t, 50> a;
+		a.setAll(9);
+		a[40] = 1;
+		int idx = -1;
+		CHECK(a.find(1, idx) && idx == 40);
+		CHECK(a.count(9) == 49);
+
+		cz::TStaticArray<uint32_t, 50, true> b;
+		b.push(5);
+		b.push(6);
+		b.push(5);
+		CHECK(b.count(5) == 2);
+	}
+
+	SECTION("Queue that wraps around")
+	{
+		cz::TStaticFixedCapacityQueue<int, 40> q;
+		for (int i = 0; i < 30; i++)
+		{
+			q.push(i);
+		}
+		int v;
+		for (int i = 0; i < 20; i++)
+		{
+			q.pop(v);
+		}
+		for (int i = 30; i < 60; i++)
+		{
+			q.push(i);
+		}
+
+		bool ok = true;
+		for (int i = 0; i < 70; i++)
+		{
+			ok = ok && q.find(i) == (i >= 20 && i < 60);
+		}
+		CHECK(ok);
+	}
+}
@@ -0,0 +1,152 @@
+#include <crazygaze/micromuc/SlotMap.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][slotmap][benchmark]"
+
+namespace
+{
+
+constexpr int gNumTimers = 64;
+constexpr int gNumOps = 20000;
+
+struct Timer
+{
+	uint32_t expiry;
+	int id; // Only needed by the TArray version, to fix up the side table
+};
+
+/**
+ * What we did before TSlotMap: TArray with removeAtIndexAndFillWithLast, plus a side table to map ids to indices.
+ */
+class ArrayTimers
+{
+public:
+	ArrayTimers()
+	{
+		for (int i = 0; i < gNumTimers; i++)
+		{
+			m_idToIndex.push(-1);
+		}
+	}
+
+	int add(uint32_t expiry, int id)
+	{
+		m_idToIndex[id] = m_timers.size();
+		m_timers.push(Timer{expiry, id});
+		return id;
+	}
+
+	void remove(int id)
+	{
+		int index = m_idToIndex[id];
+		m_timers.removeAtIndexAndFillWithLast(index);
+		if (index < m_timers.size())
+		{
+			m_idToIndex[m_timers[index].id] = index;
+		}
+		m_idToIndex[id] = -1;
+	}
+
+	Timer* get(int id)
+	{
+		int index = m_idToIndex[id];
+		return index == -1 ? nullptr : &m_timers[index];
+	}
+
+	uint32_t sumExpiry() const
+	{
+		uint32_t sum = 0;
+		for (auto&& t : m_timers)
+		{
+			sum += t.expiry;
+		}
+		return sum;
+	}
+
+private:
+	cz::TArray<Timer> m_timers;
+	cz::TArray<int> m_idToIndex;
+};
+
+class SlotMapTimers
+{
+public:
+	cz::SlotMapHandle add(uint32_t expiry, int)
+	{
+		return m_timers.insert(Timer{expiry, 0});
+	}
+
+	void remove(cz::SlotMapHandle handle)
+	{
+		m_timers.erase(handle);
+	}
+
+	Timer* get(cz::SlotMapHandle handle)
+	{
+		return m_timers.get(handle);
+	}
+
+	uint32_t sumExpiry() const
+	{
+		uint32_t sum = 0;
+		for (auto&& t : m_timers)
+		{
+			sum += t.expiry;
+		}
+		return sum;
+	}
+
+private:
+	cz::TSlotMap<Timer> m_timers;
+};
+
+/**
+ * Each op removes a timer, adds a new one, updates another one through its handle, and every few ops iterates all
+ * the timers (as a per frame update would).
+ */
+template<typename Timers, typename Handle>
+__attribute__((noinline)) uint32_t churn(Timers& timers, Handle* handles)
+{
+	uint32_t rnd = 1;
+	uint32_t sum = 0;
+	for (int i = 0; i < gNumTimers; i++)
+	{
+		handles[i] = timers.add(static_cast<uint32_t>(i), i);
+	}
+
+	for (int i = 0; i < gNumOps; i++)
+	{
+		rnd = rnd * 1103515245 + 12345;
+		int a = static_cast<int>((rnd >> 16) % gNumTimers);
+		int b = static_cast<int>((rnd >> 8) % gNumTimers);
+		timers.remove(handles[a]);
+		handles[a] = timers.add(static_cast<uint32_t>(i), a);
+		timers.get(handles[b])->expiry += 1;
+		if ((i % 8) == 0)
+		{
+			sum += timers.sumExpiry();
+		}
+	}
+
+	return sum;
+}
+
+}
+
+TEST_CASE("SlotMap-churn", TEST_TAG)
+{
+	cz::test::Stopwatch watch;
+	ArrayTimers arrayTimers;
+	int ids[gNumTimers];
+	volatile uint32_t sumArray = churn(arrayTimers, ids);
+	cz::test::logBenchmark("TArray + index side table", gNumOps, watch.elapsedMicros());
+
+	watch.reset();
+	SlotMapTimers slotMapTimers;
+	cz::SlotMapHandle handles[gNumTimers];
+	volatile uint32_t sumSlotMap = churn(slotMapTimers, handles);
+	cz::test::logBenchmark("TSlotMap", gNumOps, watch.elapsedMicros());
+
+	CHECK(sumArray == sumSlotMap);
+}
@@ -0,0 +1,200 @@
+#include <crazygaze/micromuc/SlotMap.h>
+#include <crazygaze/micromuc/Allocator.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+#include <string>
+
+#define TEST_TAG "[czmicromuc][slotmap]"
+
+namespace
+{
+
+// Sum of all the elements, so we can check iteration goes through all the live elements
+template<typename M>
+int sum(const M& m)
+{
+	int res = 0;
+	for (auto&& v : m)
+	{
+		res += v;
+	}
+	return res;
+}
+
+}
+
+TEST_CASE("SlotMap", TEST_TAG)
+{
+	SECTION("basics")
+	{
+		cz::TSlotMap<int> m;
+		CHECK(m.empty());
+		CHECK(!m.contains(cz::SlotMapHandle()));
+
+		cz::SlotMapHandle a = m.insert(10);
+		cz::SlotMapHandle b = m.insert(20);
+		cz::SlotMapHandle c = m.emplace(30);
+		CHECK(a.isSet() && b.isSet() && c.isSet());
+		CHECK(m.size() == 3);
+		CHECK(*m.get(a) == 10);
+		CHECK(*m.get(b) == 20);
+		CHECK(*m.get(c) == 30);
+		CHECK(sum(m) == 60);
+
+		// Removing "a" moves "c" to its position, but the handle for "c" stays valid
+		CHECK(m.erase(a));
+		CHECK(!m.erase(a));
+		CHECK(!m.contains(a));
+		CHECK(m.get(a) == nullptr);
+		CHECK(m.size() == 2);
+		CHECK(*m.get(c) == 30);
+		CHECK(m.findIndex(c) == 0);
+		CHECK(m.handleAt(0) == c);
+		CHECK(m.handleAt(1) == b);
+		CHECK(sum(m) == 50);
+	}
+
+	SECTION("slots are reused with a new generation")
+	{
+		cz::TSlotMap<int> m;
+		cz::SlotMapHandle a = m.insert(1);
+		m.erase(a);
+		cz::SlotMapHandle b = m.insert(2);
+		CHECK(a.index() == b.index());
+		CHECK(a.generation() != b.generation());
+		CHECK(a != b);
+		CHECK(!m.contains(a));
+		CHECK(*m.get(b) == 2);
+	}
+
+	SECTION("clear invalidates all handles")
+	{
+		cz::TSlotMap<int> m;
+		cz::SlotMapHandle a = m.insert(1);
+		cz::SlotMapHandle b = m.insert(2);
+		m.clear();
+		CHECK(m.empty());
+		CHECK(!m.contains(a));
+		CHECK(!m.contains(b));
+		cz::SlotMapHandle c = m.insert(3);
+		CHECK(*m.get(c) == 3);
+		CHECK(m.size() == 1);
+	}
+
+	SECTION("erase while iterating")
+	{
+		cz::TSlotMap<int> m;
+		cz::SlotMapHandle handles[10];
+		for (int i = 0; i < 10; i++)
+		{
+			handles[i] = m.insert(i);
+		}
+
+		for (int i = 0; i < m.size();)
+		{
+			if (m[i] % 2)
+				m.eraseAt(i);
+			else
+				i++;
+		}
+
+		CHECK(m.size() == 5);
+		CHECK(sum(m) == 0 + 2 + 4 + 6 + 8);
+		bool ok = true;
+		for (int i = 0; i < 10; i++)
+		{
+			ok = ok && ((i % 2) ? !m.contains(handles[i]) : *m.get(handles[i]) == i);
+		}
+		CHECK(ok);
+	}
+
+	SECTION("insert an element of the map itself while growing")
+	{
+		const std::string str = "A string that doesn't fit in the small string buffer";
+		cz::TSlotMap<std::string> m;
+		cz::SlotMapHandle h = m.insert(str);
+		bool ok = true;
+		for (int i = 0; i < 20; i++)
+		{
+			ok = ok && m.insert(m[0]).isSet();
+			ok = ok && m.insert(*m.get(h)).isSet();
+		}
+		CHECK(ok);
+		CHECK(m.size() == 41);
+		for (const std::string& s : m)
+		{
+			ok = ok && s == str;
+		}
+		CHECK(ok);
+	}
+
+	SECTION("churn")
+	{
+		cz::TSlotMap<std::string> m;
+		cz::SlotMapHandle handles[32];
+		uint32_t rnd = 1;
+		bool ok = true;
+		for (int i = 0; i < 1000; i++)
+		{
+			rnd = rnd * 1103515245 + 12345;
+			int idx = static_cast<int>((rnd >> 16) % 32);
+			if (m.contains(handles[idx]))
+			{
+				ok = ok && m.erase(handles[idx]);
+			}
+			else
+			{
+				handles[idx] = m.insert(std::to_string(idx) + " with some padding to avoid the small string optimization");
+			}
+
+			for (int j = 0; j < 32; j++)
+			{
+				if (const std::string* s = m.get(handles[j]))
+				{
+					ok = ok && *s == std::to_string(j) + " with some padding to avoid the small string optimization";
+				}
+			}
+		}
+		CHECK(ok);
+	}
+
+	SECTION("out of memory")
+	{
+		cz::TStaticArenaAllocator<256> arena;
+		cz::TSlotMap<int, cz::TAllocatorRef<cz::ArenaAllocator>> m(arena);
+		CHECK(m.reserve(8));
+		cz::SlotMapHandle handles[8];
+		for (int i = 0; i < 8; i++)
+		{
+			handles[i] = m.insert(i);
+			CHECK(handles[i].isSet());
+		}
+
+		// Use up what's left of the arena, so nothing can grow
+		while (arena.allocate(1))
+		{
+		}
+
+		// A failed insert leaves the existing elements and handles as they were
+		cz::SlotMapHandle h = m.insert(100);
+		CHECK(!h.isSet());
+		CHECK(!m.contains(h));
+		CHECK(m.size() == 8);
+		CHECK(sum(m) == 28);
+		bool ok = true;
+		for (int i = 0; i < 8; i++)
+		{
+			ok = ok && m.contains(handles[i]) && *m.get(handles[i]) == i;
+		}
+		CHECK(ok);
+
+		// Erasing frees space that can be reused without allocating
+		CHECK(m.erase(handles[3]));
+		h = m.insert(100);
+		CHECK(h.isSet());
+		CHECK(*m.get(h) == 100);
+		CHECK(!m.contains(handles[3]));
+		CHECK(sum(m) == 28 - 3 + 100);
+		CHECK(!m.insert(101).isSet());
+	}
+}
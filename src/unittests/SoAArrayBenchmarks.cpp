@@ -0,0 +1,85 @@
+#include <crazygaze/micromuc/SoAArray.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+
+#define TEST_TAG "[czmicromuc][soaarray][benchmark]"
+
+namespace
+{
+
+#if CZ_TEST_HOST
+constexpr int gNumRows = 1000000;
+#elif defined(__AVR__)
+constexpr int gNumRows = 200;
+#else
+// Both layouts together take about 63 bytes per row
+constexpr int gNumRows = 1000;
+#endif
+
+struct Record
+{
+	uint32_t id;
+	uint32_t timestamp;
+	float temperature;
+	float humidity;
+	float pressure;
+	uint16_t flags;
+	uint8_t status;
+	char name[13];
+};
+
+__attribute__((noinline)) float sumAoS(const cz::TArray<Record>& records)
+{
+	float sum = 0;
+	for(auto&& r : records)
+	{
+		sum += r.temperature;
+	}
+	return sum;
+}
+
+using RecordColumns = cz::TSoAArray<uint32_t, uint32_t, float, float, float, uint16_t, uint8_t>;
+constexpr int gTemperatureColumn = 2;
+
+__attribute__((noinline)) float sumSoA(const RecordColumns& records)
+{
+	float sum = 0;
+	for(float v : records.column<gTemperatureColumn>())
+	{
+		sum += v;
+	}
+	return sum;
+}
+
+}
+
+TEST_CASE("SoAArray-sum one field", TEST_TAG)
+{
+	cz::TArray<Record> aos;
+	RecordColumns soa;
+	CHECK(aos.reserve(gNumRows));
+	CHECK(soa.reserve(gNumRows));
+	bool ok = true;
+	for(int i = 0; i < gNumRows; i++)
+	{
+		// Small integer values, so the float sums are exact and the same in both cases
+		float t = static_cast<float>(i % 8);
+		ok &= aos.push(Record{static_cast<uint32_t>(i), 0, t, 0, 0, 0, 0, {}});
+		ok &= soa.push(static_cast<uint32_t>(i), 0u, t, 0.0f, 0.0f, static_cast<uint16_t>(0), static_cast<uint8_t>(0));
+	}
+	CHECK(ok);
+
+	char name[64];
+	cz::test::Stopwatch watch;
+	volatile float sumA = sumAoS(aos);
+	unsigned long elapsed = watch.elapsedMicros();
+	snprintf(name, sizeof(name), "AoS TArray<Record> sum (%d bytes per row)", static_cast<int>(sizeof(Record)));
+	cz::test::logBenchmark(name, gNumRows, elapsed);
+
+	watch.reset();
+	volatile float sumB = sumSoA(soa);
+	elapsed = watch.elapsedMicros();
+	cz::test::logBenchmark("SoA TSoAArray column sum", gNumRows, elapsed);
+
+	CHECK(sumA == sumB);
+}
@@ -0,0 +1,127 @@
+#include <crazygaze/micromuc/SoAArray.h>
+#include <crazygaze/micromuc/Allocator.h>
+#include <crazygaze/mut/mut.h>
+#include "TestUtils.h"
+#include <string>
+
+#define TEST_TAG "[czmicromuc][soaarray]"
+
+TEST_CASE("SoAArray", TEST_TAG)
+{
+	SECTION("basics")
+	{
+		cz::TSoAArray<int, float, uint8_t> a;
+		CHECK(a.size() == 0);
+		CHECK(a.column<0>().size == 0);
+
+		for (int i = 0; i < 100; i++)
+		{
+			CHECK(a.push(i, i * 0.5f, static_cast<uint8_t>(i * 2)));
+		}
+		CHECK(a.size() == 100);
+		CHECK(a.capacity() >= 100);
+
+		// Columns are contiguous
+		cz::TSpan<int> ints = a.column<0>();
+		CHECK(ints.size == 100);
+		int sum = 0;
+		for (int v : ints)
+		{
+			sum += v;
+		}
+		CHECK(sum == 4950);
+		CHECK(a.column<1>()[10] == 5.0f);
+		CHECK(a.at<2>(20) == 40);
+
+		auto [i, f, u] = a.row(30);
+		CHECK(i == 30 && f == 15.0f && u == 60);
+		f = 1.0f;
+		CHECK(a.at<1>(30) == 1.0f);
+
+		CHECK(a.removeAtIndexAndFillWithLast(0));
+		CHECK(a.size() == 99);
+		CHECK(a.at<0>(0) == 99);
+		CHECK(a.at<2>(0) == 198);
+		CHECK(a.pop());
+		CHECK(a.size() == 98);
+
+		const auto& ca = a;
+		CHECK(std::get<0>(ca.row(1)) == 1);
+		CHECK(ca.column<0>()[2] == 2);
+
+		a.clear();
+		CHECK(a.size() == 0);
+		a.shrink_to_fit();
+		CHECK(a.capacity() == 0);
+	}
+
+	SECTION("non POD fields")
+	{
+		cz::TSoAArray<std::string, int> a;
+		for (int i = 0; i < 20; i++)
+		{
+			CHECK(a.push(std::to_string(i) + " with some padding to avoid the small string optimization", i));
+		}
+		// Pushing an element of the array itself while it needs to grow
+		a.shrink_to_fit();
+		CHECK(a.size() == a.capacity());
+		CHECK(a.push(a.at<0>(3), a.at<1>(3)));
+		CHECK(a.at<0>(20) == a.at<0>(3));
+		CHECK(a.at<1>(20) == 3);
+
+		cz::TSoAArray<std::string, int> b(a);
+		CHECK(b.size() == 21);
+		CHECK(b.at<0>(5) == a.at<0>(5));
+
+		cz::TSoAArray<std::string, int> c(std::move(a));
+		CHECK(a.size() == 0);
+		CHECK(c.size() == 21);
+
+		b.append(b);
+		CHECK(b.size() == 42);
+		CHECK(b.at<0>(41) == c.at<0>(20));
+
+		a = std::move(b);
+		CHECK(a.size() == 42);
+		a = c;
+		CHECK(a.size() == 21);
+	}
+
+	SECTION("out of memory leaves the array as it was")
+	{
+		cz::TStaticArenaAllocator<256> arena;
+		cz::TBasicSoAArray<cz::TAllocatorRef<cz::ArenaAllocator>, cz::ExactGrowth, uint32_t, uint32_t> a(arena);
+		CHECK(a.reserve(8));
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			CHECK(a.push(i, i * 2));
+		}
+
+		// Leave space for one bigger column but not two, so growing fails after allocating the first column
+		CHECK(arena.allocate(256 - arena.used() - 48) != nullptr);
+		size_t used = arena.used();
+
+		CHECK(!a.push(8u, 16u));
+		CHECK(a.size() == 8);
+		CHECK(a.capacity() == 8);
+		// The first column was allocated, and given back
+		CHECK(arena.peak() > used);
+		CHECK(arena.used() == used);
+		bool ok = true;
+		for (int i = 0; i < 8; i++)
+		{
+			ok = ok && a.at<0>(i) == static_cast<uint32_t>(i) && a.at<1>(i) == static_cast<uint32_t>(i * 2);
+		}
+		CHECK(ok);
+
+		// Values from the array itself fail the same way
+		CHECK(!a.push(a.at<0>(0), a.at<1>(0)));
+		CHECK(a.size() == 8);
+
+		// And it can still be used within its capacity
+		CHECK(a.pop());
+		CHECK(a.push(100u, 200u));
+		CHECK(a.at<0>(7) == 100 && a.at<1>(7) == 200);
+		CHECK(a.at<1>(6) == 12);
+	}
+}
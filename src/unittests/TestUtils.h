@@ -0,0 +1,265 @@
+#pragma once
+
+#include <crazygaze/micromuc/czmicromuc.h>
+#include <crazygaze/micromuc/Logging.h>
+#include <atomic>
+#include <initializer_list>
+#include <stdlib.h>
+
+#if _GLIBCXX_HAS_GTHREADS
+	#include <thread>
+	#include <vector>
+	#define CZ_TEST_HAS_CONCURRENCY 1
+#elif defined(ARDUINO_ARCH_RP2040)
+	#include <pico/multicore.h>
+	#define CZ_TEST_HAS_CONCURRENCY 1
+#else
+	#define CZ_TEST_HAS_CONCURRENCY 0
+#endif
+
+// Benchmarks running on a PC can use much bigger sizes than the ones that fit in a board's memory
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__) || defined(_M_X64) || defined(_M_IX86)
+	#define CZ_TEST_HOST 1
+#else
+	#define CZ_TEST_HOST 0
+#endif
+
+namespace cz::test
+{
+
+/**
+ * Simple stopwatch for the benchmarks
+ */
+class Stopwatch
+{
+public:
+	Stopwatch()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		m_start = micros();
+	}
+
+	unsigned long elapsedMicros() const
+	{
+		return micros() - m_start;
+	}
+
+private:
+	unsigned long m_start;
+};
+
+/**
+ * Logs the result of a benchmark, as time and cycles per operation
+ */
+inline void logBenchmark(const char* name, uint32_t numOps, unsigned long elapsedMicros)
+{
+	uint64_t nsPerOpX100 = (static_cast<uint64_t>(elapsedMicros) * 1000 * 100) / numOps;
+	uint64_t cyclesPerOpX100 = (static_cast<uint64_t>(elapsedMicros) * (F_CPU / 1000000) * 100) / numOps;
+	CZ_LOG(logDefault, Log, "%s: %lu ops in %lu us. %lu.%02lu ns/op, %lu.%02lu cycles/op", name,
+		static_cast<unsigned long>(numOps), elapsedMicros,
+		static_cast<unsigned long>(nsPerOpX100 / 100), static_cast<unsigned long>(nsPerOpX100 % 100),
+		static_cast<unsigned long>(cyclesPerOpX100 / 100), static_cast<unsigned long>(cyclesPerOpX100 % 100));
+}
+
+/**
+ * Logs the result of a benchmark as throughput, in units per second (e.g: "bits/s")
+ */
+inline void logThroughput(const char* name, uint64_t numUnits, const char* unitName, unsigned long elapsedMicros)
+{
+	uint64_t perSecond = elapsedMicros ? (numUnits * 1000000) / elapsedMicros : 0;
+	CZ_LOG(logDefault, Log, "%s: %lu %s in %lu us. %lu %s/s", name,
+		static_cast<unsigned long>(numUnits), unitName, elapsedMicros,
+		static_cast<unsigned long>(perSecond), unitName);
+}
+
+/**
+ * malloc based allocator that keeps track of how much memory is in use
+ */
+struct PeakTrackingAllocator
+{
+	static inline size_t ms_used = 0;
+	static inline size_t ms_peak = 0;
+	static inline int ms_count = 0;
+
+	static void reset()
+	{
+		ms_used = 0;
+		ms_peak = 0;
+		ms_count = 0;
+	}
+
+	static void add(size_t size)
+	{
+		ms_used += size;
+		if (ms_used > ms_peak)
+			ms_peak = ms_used;
+	}
+
+	void* allocate(size_t size)
+	{
+		ms_count++;
+		add(size);
+		return malloc(size);
+	}
+
+	void deallocate(void* ptr, size_t size)
+	{
+		ms_used -= size;
+		free(ptr);
+	}
+
+	void* reallocate(void* ptr, size_t oldSize, size_t newSize)
+	{
+		ms_count++;
+		ms_used -= oldSize;
+		add(newSize);
+		return realloc(ptr, newSize);
+	}
+};
+
+#if CZ_TEST_HAS_CONCURRENCY
+
+/**
+ * Runs "a" and "b" at the same time, and returns when both are finished.
+ * On hosts with thread support, "a" runs in a std::thread. On the RP2040, "a" runs on core 1.
+ */
+template<typename A, typename B>
+void runConcurrently(A& a, B& b)
+{
+#if _GLIBCXX_HAS_GTHREADS
+	std::thread th([&a]() { a(); });
+	b();
+	th.join();
+#else
+	static A* ms_a;
+	static std::atomic<bool> ms_done;
+	ms_a = &a;
+	ms_done.store(false);
+	multicore_reset_core1();
+	multicore_launch_core1([]()
+	{
+		(*ms_a)();
+		ms_done.store(true, std::memory_order_release);
+		while(true)
+		{
+			tight_loop_contents();
+		}
+	});
+
+	b();
+
+	while(!ms_done.load(std::memory_order_acquire))
+	{
+	}
+	multicore_reset_core1();
+#endif
+}
+
+#if _GLIBCXX_HAS_GTHREADS
+/**
+ * Runs "f(index)" in numThreads threads, and returns when all are finished.
+ * Only available on hosts.
+ */
+template<typename F>
+void runThreads(int numThreads, F& f)
+{
+	std::vector<std::thread> threads;
+	for(int i = 0; i < numThreads; i++)
+	{
+		threads.emplace_back([&f, i]() { f(i); });
+	}
+
+	for(auto&& th : threads)
+	{
+		th.join();
+	}
+}
+#endif
+
+/**
+ * To be called while spinning and waiting on the other side of a runConcurrently call.
+ * On hosts, this yields so it doesn't starve the other thread if there are fewer cores than threads.
+ */
+inline void spinPause()
+{
+#if _GLIBCXX_HAS_GTHREADS
+	std::this_thread::yield();
+#endif
+}
+
+#endif
+
+/**
+ * Checks if a container has exactly the specified elements, both when iterating and when indexing.
+ */
+template<class A>
+bool equals(const A& a, std::initializer_list<int> list)
+{
+	if (static_cast<size_t>(a.size()) != list.size())
+		return false;
+
+	auto it = a.begin();
+	int index = 0;
+	for(auto&& v : list)
+	{
+		if (!(*it == v) || !(a[index] == v))
+			return false;
+		++it;
+		index++;
+	}
+
+	return it == a.end();
+}
+
+/**
+ * Counts how many instances are alive, and how many copies were made, so tests can check elements are constructed and
+ * destroyed properly, and moved instead of copied when possible.
+ * A moved from instance has n set to -1.
+ */
+struct Tracked
+{
+	static inline int ms_alive = 0;
+	static inline int ms_copies = 0;
+	int n;
+	bool movedFrom = false;
+
+	Tracked(int n = 0) : n(n) { ms_alive++; }
+	Tracked(const Tracked& other) : n(other.n) { ms_alive++; ms_copies++; }
+	Tracked(Tracked&& other) noexcept : n(other.n)
+	{
+		other.n = -1;
+		other.movedFrom = true;
+		ms_alive++;
+	}
+	Tracked& operator=(const Tracked& other)
+	{
+		n = other.n;
+		movedFrom = other.movedFrom;
+		ms_copies++;
+		return *this;
+	}
+	Tracked& operator=(Tracked&& other) noexcept
+	{
+		n = other.n;
+		movedFrom = false;
+		other.n = -1;
+		other.movedFrom = true;
+		return *this;
+	}
+	~Tracked() { ms_alive--; }
+	bool operator==(int other) const { return n == other; }
+	bool operator==(const Tracked& other) const { return n == other.n; }
+
+	static void reset()
+	{
+		ms_alive = 0;
+		ms_copies = 0;
+	}
+};
+
+} // namespace cz::test
+